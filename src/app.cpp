@@ -20,6 +20,10 @@ app::app()
 {
     memset(mVersion, 0, sizeof(char) * 12);
     memset(mVersionModules, 0, sizeof(char) * 12);
+    #if defined(ENABLE_RADIO_TASK)
+    mCommMutex = xSemaphoreCreateBinaryStatic(&mCommMutexBuffer);
+    xSemaphoreGive(mCommMutex);
+    #endif
 }
 
 
@@ -48,6 +52,12 @@ void app::setup() {
     #if defined(ESP32)
     mCmtRadio.setup(&mConfig->serial.debug, &mConfig->serial.privacyLog, &mConfig->serial.printWholeTrace, &mConfig->cmt, mConfig->sys.region);
     #endif
+    #if defined(ENABLE_PACKET_TRACE)
+    mNrfRadio.setPacketTrace(&mPacketTrace);
+    #if defined(ESP32)
+    mCmtRadio.setPacketTrace(&mPacketTrace);
+    #endif
+    #endif
 
     #ifdef ETHERNET
         delay(1000);
@@ -61,10 +71,20 @@ void app::setup() {
     esp_task_wdt_reset();
 
     mCommunication.setup(&mTimestamp, &mConfig->serial.debug, &mConfig->serial.privacyLog, &mConfig->serial.printWholeTrace);
+    mCommunication.setChannelSelection(&mConfig->nrf.chSelect);
+    mCommunication.setLimitFastPath(&mConfig->inst.limitFastPath);
+    #if defined(ENABLE_RADIO_TASK)
+    // the listeners run in the radio task, the events are handled in loop()
+    mCommunication.addPayloadListener([this] (uint8_t cmd, Inverter<> *iv) { pushCommEvent(CommEvent::PAYLOAD, cmd, iv); });
+    #if defined(ENABLE_MQTT)
+        mCommunication.addPowerLimitAckListener([this] (Inverter<> *iv) { pushCommEvent(CommEvent::POWER_LIMIT_ACK, 0, iv); });
+    #endif
+    #else
     mCommunication.addPayloadListener([this] (uint8_t cmd, Inverter<> *iv) { payloadEventListener(cmd, iv); });
     #if defined(ENABLE_MQTT)
         mCommunication.addPowerLimitAckListener([this] (Inverter<> *iv) { mMqtt.setPowerLimitAck(iv); });
     #endif
+    #endif
     mSys.setup(&mTimestamp, &mConfig->inst, this);
     for (uint8_t i = 0; i < MAX_NUM_INVERTERS; i++) {
         initInverter(i);
@@ -81,9 +101,13 @@ void app::setup() {
     #if defined(ENABLE_MQTT)
     mMqttEnabled = (mConfig->mqtt.broker[0] > 0);
     if (mMqttEnabled) {
-        mMqtt.setup(this, &mConfig->mqtt, mConfig->sys.deviceName, mVersion, &mSys, &mTimestamp, &mUptime);
+        mMqtt.setup(this, &mConfig->mqtt, &mConfig->inst, mConfig->sys.deviceName, mVersion, &mSys, &mTimestamp, &mUptime);
         mMqtt.setSubscriptionCb([this](JsonObject obj) { mqttSubRxCb(obj); });
+        #if defined(ENABLE_RADIO_TASK)
+        mCommunication.addAlarmListener([this](Inverter<> *iv) { pushCommEvent(CommEvent::ALARM, 0, iv); });
+        #else
         mCommunication.addAlarmListener([this](Inverter<> *iv) { mMqtt.alarmEvent(iv); });
+        #endif
     }
     #endif
     setupLed();
@@ -125,32 +149,106 @@ void app::setup() {
 
     esp_task_wdt_reset();
     regularTickers();
+
+    #if defined(ENABLE_RADIO_TASK)
+    xTaskCreatePinnedToCore(radioTask, "radio", RADIO_TASK_STACK, this, RADIO_TASK_PRIO, &mRadioTask, RADIO_TASK_CORE);
+    #endif
 }
 
 //-----------------------------------------------------------------------------
 void app::loop(void) {
+    #if defined(ENABLE_PROFILER)
+    uint32_t start = micros();
+    #endif
     esp_task_wdt_reset();
 
-    mNrfRadio.loop();
+    #if defined(ENABLE_RADIO_TASK)
+    // tickers, payload events and MQTT read or reset the records
+    lockComm();
+    ah::Scheduler::loop();
+    handleCommEvents();
+    #if defined(ENABLE_MQTT)
+    if (mMqttEnabled && mNetworkConnected)
+        PERF_RUN(ah::PerfSection::MQTT, mMqtt.loop());
+    #endif
+    unlockComm();
+    #else
+    PERF_RUN(ah::PerfSection::NRF, mNrfRadio.loop());
 
     #if defined(ESP32)
-    mCmtRadio.loop();
+    PERF_RUN(ah::PerfSection::CMT, mCmtRadio.loop());
     #endif
 
     ah::Scheduler::loop();
-    mCommunication.loop();
+    PERF_RUN(ah::PerfSection::COMM, mCommunication.loop());
 
     #if defined(ENABLE_MQTT)
     if (mMqttEnabled && mNetworkConnected)
-        mMqtt.loop();
+        PERF_RUN(ah::PerfSection::MQTT, mMqtt.loop());
     #endif
-
-    #if defined(PLUGIN_DISPLAY)
-    mDisplay.loop();
+    #endif
+    #if defined(ENABLE_PROFILER)
+    ah::gPerf.add(ah::PerfSection::LOOP, micros() - start);
     #endif
     yield();
 }
 
+#if defined(ENABLE_RADIO_TASK)
+//-----------------------------------------------------------------------------
+void app::radioTask(void *arg) {
+    app *a = static_cast<app*>(arg);
+    while(true) {
+        PERF_RUN(ah::PerfSection::NRF, a->mNrfRadio.loop());
+        PERF_RUN(ah::PerfSection::CMT, a->mCmtRadio.loop());
+        a->lockComm();
+        PERF_RUN(ah::PerfSection::COMM, a->mCommunication.loop());
+        a->unlockComm();
+        ulTaskNotifyTake(pdTRUE, 1); // until the next radio IRQ, at most one tick
+    }
+}
+
+//-----------------------------------------------------------------------------
+// radio task, called with the lock held: it is released while waiting for
+// free space, otherwise loop() can't empty the ring
+void app::pushCommEvent(CommEvent type, uint8_t cmd, Inverter<> *iv) {
+    for(uint8_t i = 0; mCommEvents.full() && (i < COMM_EVENT_WAIT_TICKS); i++) {
+        unlockComm();
+        vTaskDelay(1);
+        lockComm();
+    }
+    if(mCommEvents.full()) {
+        mCommEventsDropped++;
+        DPRINTLN(DBG_WARN, F("comm event dropped"));
+        return;
+    }
+    mCommEvents.push({type, cmd, iv});
+}
+
+//-----------------------------------------------------------------------------
+void app::handleCommEvents(void) {
+    while(!mCommEvents.empty()) {
+        const commEvent_t *evt = &mCommEvents.front();
+        switch(evt->type) {
+            case CommEvent::PAYLOAD:
+                payloadEventListener(evt->cmd, evt->iv);
+                break;
+            case CommEvent::POWER_LIMIT_ACK:
+                #if defined(ENABLE_MQTT)
+                mMqtt.setPowerLimitAck(evt->iv);
+                #endif
+                break;
+            case CommEvent::ALARM:
+                #if defined(ENABLE_MQTT)
+                if(mMqttEnabled)
+                    mMqtt.alarmEvent(evt->iv);
+                #endif
+                break;
+        }
+        mCommEvents.pop();
+    }
+}
+#endif /*ENABLE_RADIO_TASK*/
+
 //-----------------------------------------------------------------------------
 void app::onNetwork(bool connected) {
     mNetworkConnected = connected;
@@ -165,7 +263,7 @@ void app::onNetwork(bool connected) {
         mNetwork->updateNtpTime();
 
         resetTickerByName("tSend");
-        every([this]() { tickSend(); }, mConfig->inst.sendInterval, "tSend");
+        every([this]() { tickSend(); }, getSendTickInterval(), "tSend");
 
         #if defined(ENABLE_MQTT)
         if (mMqttEnabled) {
@@ -184,7 +282,7 @@ void app::regularTickers(void) {
     everySec([this]() { mNetwork->tickNetworkLoop(); }, "net");
 
     if(mConfig->inst.startWithoutTime)
-        every([this]() { tickSend(); }, mConfig->inst.sendInterval, "tSend");
+        every([this]() { tickSend(); }, getSendTickInterval(), "tSend");
 
 
     every([this]() { mNetwork->updateNtpTime(); }, mConfig->ntp.interval * 60, "ntp");
@@ -196,6 +294,10 @@ void app::regularTickers(void) {
     #if defined(PLUGIN_DISPLAY)
     if (DISP_TYPE_T0_NONE != mConfig->plugin.display.type)
         everySec([this]() { mDisplay.tickerSecond(); }, "disp");
+    #if defined(ESP32)
+    if (DISP_TYPE_T10_EPAPER == mConfig->plugin.display.type)
+        everyMs([this]() { PERF_RUN(ah::PerfSection::DISPLAY, mDisplay.loop()); }, 10, "epd"); // ePaper refresh steps
+    #endif
     #endif
     every([this]() { mPubSerial.tick(); }, 5, "uart");
     //everySec([this]() { mImprov.tickSerial(); }, "impro");
@@ -218,6 +320,9 @@ void app::onNtpUpdate(uint32_t utcTimestamp) {
         mTimestamp = utcTimestamp;
         DPRINTLN(DBG_INFO, "[NTP]: " + ah::getDateTimeStr(mTimestamp) + " UTC");
 
+        if(!mHeuStore.isLoaded())
+            mHeuStore.load(&mSys, mTimestamp);
+
         uint32_t localTime = gTimezone.toLocal(mTimestamp);
         uint32_t midTrig = gTimezone.toUTC(localTime - (localTime % 86400) + 86400);  // next midnight local time
         resetTickerByName("midNi");
@@ -352,6 +457,7 @@ void app::tickMidnight(void) {
 
         iv->historyMidnight(mTimestamp);
     }
+    mHeuStore.save(&mSys, mTimestamp);
 
     if (mConfig->inst.rstValsAtMidNight) {
         zeroIvValues(!CHECK_AVAIL, !SKIP_YIELD_DAY);
@@ -378,6 +484,14 @@ void app::tickSend(void) {
 
     for (uint8_t i = 0; i < MAX_NUM_INVERTERS; i++) {
         Inverter<> *iv = mSys.getInverterByPos(i);
+        if(mConfig->inst.adaptiveInterval && (NULL != iv)) {
+            if(!iv->pollIntvl.tick()) { // ticker runs every second, not due yet
+                if(InverterStatus::OFF != iv->status)
+                    notAvail = false;
+                continue;
+            }
+            iv->startPollInterval(mConfig->inst.minInterval, mConfig->inst.maxInterval);
+        }
         if(!sendIv(iv))
             notAvail = false;
     }
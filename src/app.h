@@ -28,6 +28,9 @@
 #include "utils/crc.h"
 #include "utils/dbg.h"
 #include "utils/scheduler.h"
+#if defined(ENABLE_RADIO_TASK)
+#include "utils/spscRing.h"
+#endif
 #include "utils/syslog.h"
 #include "web/RestApi.h"
 #include "web/Protection.h"
@@ -37,6 +40,7 @@
 #endif /*ENABLE_HISTORY*/
 #include "web/web.h"
 #include "hm/Communication.h"
+#include "hm/HeuristicStore.h"
 #if defined(ETHERNET)
     #include "network/AhoyEthernet.h"
 #else /* defined(ETHERNET) */
@@ -94,6 +98,7 @@ class app : public IApp, public ah::Scheduler {
 
         void handleIntr(void) {
             mNrfRadio.handleIntr();
+            wakeRadioTask();
         }
         void* getRadioObj(bool nrf) override {
             if(nrf)
@@ -107,9 +112,24 @@ class app : public IApp, public ah::Scheduler {
             }
         }
 
+        // the radio task holds the lock while Communication writes the
+        // records and heuristics, without the task both run in loop()
+        void lockComm(void) override {
+            #if defined(ENABLE_RADIO_TASK)
+            xSemaphoreTake(mCommMutex, portMAX_DELAY);
+            #endif
+        }
+
+        void unlockComm(void) override {
+            #if defined(ENABLE_RADIO_TASK)
+            xSemaphoreGive(mCommMutex);
+            #endif
+        }
+
         #ifdef ESP32
         void handleHmsIntr(void) {
             mCmtRadio.handleIntr();
+            wakeRadioTask();
         }
         #endif
 
@@ -233,7 +253,7 @@ class app : public IApp, public ah::Scheduler {
 
         void setMqttDiscoveryFlag() override {
             #if defined(ENABLE_MQTT)
-            once(std::bind(&PubMqttType::sendDiscoveryConfig, &mMqtt), 1, "disCf");
+            once(std::bind(&PubMqttType::sendDiscoveryConfig, &mMqtt, true), 1, "disCf");
             #endif
         }
 
@@ -261,6 +281,30 @@ class app : public IApp, public ah::Scheduler {
             #endif
         }
 
+        uint32_t getMqttRxDroppedCnt() override {
+            #if defined(ENABLE_MQTT)
+                return mMqtt.getRxDroppedCnt();
+            #else
+                return 0;
+            #endif
+        }
+
+        uint32_t getMqttRxCoalescedCnt() override {
+            #if defined(ENABLE_MQTT)
+                return mMqtt.getRxCoalescedCnt();
+            #else
+                return 0;
+            #endif
+        }
+
+        uint32_t getMqttRxTooLargeCnt() override {
+            #if defined(ENABLE_MQTT)
+                return mMqtt.getRxTooLargeCnt();
+            #else
+                return 0;
+            #endif
+        }
+
         #if defined(ETHERNET)
         bool isWiredConnection() override {
             return mNetwork->isWiredConnection();
@@ -334,6 +378,24 @@ class app : public IApp, public ah::Scheduler {
             printSchedulers();
         }
 
+        void getCommQueueInfo(JsonObject obj) override {
+            obj[F("fill")]     = mCommunication.getFillState();
+            obj[F("max_fill")] = mCommunication.getMaxFill();
+            const char *names[] = {"dev_control", "realtime", "info"};
+            for(uint8_t i = 0; i < Communication::PrioCnt; i++) {
+                const Communication::queueStat_t *st = mCommunication.getQueueStat(static_cast<Communication::Prio>(i));
+                JsonObject cl = obj.createNestedObject(names[i]);
+                cl[F("cnt")]    = st->cnt;
+                cl[F("avg_ms")] = (0 == st->cnt) ? 0 : (st->sumMs / st->cnt);
+                cl[F("max_ms")] = st->maxMs;
+                cl[F("drop")]   = st->dropCnt;
+            }
+            obj[F("preempt")] = mCommunication.getPreemptCnt();
+            #if defined(ENABLE_RADIO_TASK)
+            obj[F("evt_drop")] = mCommEventsDropped;
+            #endif
+        }
+
         void setTimestamp(uint32_t newTime) override {
             DPRINT(DBG_DEBUG, F("setTimestamp: "));
             DBGPRINTLN(String(newTime));
@@ -397,6 +459,9 @@ class app : public IApp, public ah::Scheduler {
 
         void payloadEventListener(uint8_t cmd, Inverter<> *iv) {
             mMaxPower.payloadEvent(cmd, iv);
+            if((RealTimeRunData_Debug == cmd) && (nullptr != iv))
+                iv->pollIntvl.addPower(iv->getChannelFieldValue(CH0, FLD_PAC, iv->getRecordStruct(RealTimeRunData_Debug)));
+            mWeb.payloadEventListener(cmd, iv);
             #if defined(ENABLE_MQTT)
                 if (mMqttEnabled)
                     mMqtt.payloadEventListener(cmd, iv);
@@ -415,6 +480,7 @@ class app : public IApp, public ah::Scheduler {
 
         void tickReboot(void) {
             DPRINTLN(DBG_INFO, F("Rebooting..."));
+            mHeuStore.save(&mSys, mTimestamp);
             ah::Scheduler::resetTicker();
             WiFi.disconnect();
             delay(200);
@@ -445,14 +511,56 @@ class app : public IApp, public ah::Scheduler {
         void tickComm(void);
         void tickSend(void);
         bool sendIv(Inverter<> *iv);
+
+        // with the adaptive interval each inverter has its own countdown
+        uint16_t getSendTickInterval(void) const {
+            return mConfig->inst.adaptiveInterval ? 1 : mConfig->inst.sendInterval;
+        }
         void tickMinute(void);
         void tickZeroValues(void);
         void tickMidnight(void);
         void notAvailChanged(void);
 
+        // called from the radio ISRs
+        inline void wakeRadioTask(void) {
+            #if defined(ENABLE_RADIO_TASK)
+            if(nullptr != mRadioTask) {
+                BaseType_t woken = pdFALSE;
+                vTaskNotifyGiveFromISR(mRadioTask, &woken);
+                if(pdFALSE != woken)
+                    portYIELD_FROM_ISR();
+            }
+            #endif
+        }
+
+        #if defined(ENABLE_RADIO_TASK)
+        enum class CommEvent : uint8_t {
+            PAYLOAD,
+            POWER_LIMIT_ACK,
+            ALARM
+        };
+
+        typedef struct {
+            CommEvent type;
+            uint8_t cmd;
+            Inverter<> *iv;
+        } commEvent_t;
+
+        static void radioTask(void *arg);
+        void pushCommEvent(CommEvent type, uint8_t cmd, Inverter<> *iv);
+        void handleCommEvents(void);
+
+        TaskHandle_t mRadioTask = nullptr;
+        SpscRing<commEvent_t, COMM_EVENT_BUF_SIZE> mCommEvents;
+        uint32_t mCommEventsDropped = 0;
+        SemaphoreHandle_t mCommMutex;
+        StaticSemaphore_t mCommMutexBuffer;
+        #endif
+
         HmSystemType mSys;
         NrfRadio<> mNrfRadio;
         Communication mCommunication;
+        HeuristicStore<HmSystemType> mHeuStore;
 
         bool mShowRebootRequest = false;
 
@@ -469,6 +577,9 @@ class app : public IApp, public ah::Scheduler {
         #ifdef ESP32
         CmtRadio<> mCmtRadio;
         #endif
+        #if defined(ENABLE_PACKET_TRACE)
+        PacketTrace mPacketTrace;
+        #endif
 
         char mVersion[12];
         char mVersionModules[12];
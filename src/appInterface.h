@@ -45,6 +45,7 @@ class IApp {
         virtual uint32_t getTimezoneOffset() = 0;
         virtual void getSchedulerInfo(uint8_t *max) = 0;
         virtual void getSchedulerNames() = 0;
+        virtual void getCommQueueInfo(JsonObject obj) = 0;
 
         virtual void triggerTickSend(uint8_t id) = 0;
 
@@ -60,6 +61,9 @@ class IApp {
 
         virtual uint32_t getMqttRxCnt() = 0;
         virtual uint32_t getMqttTxCnt() = 0;
+        virtual uint32_t getMqttRxDroppedCnt() = 0;
+        virtual uint32_t getMqttRxCoalescedCnt() = 0;
+        virtual uint32_t getMqttRxTooLargeCnt() = 0;
 
         #if defined(ETHERNET)
         virtual bool isWiredConnection() = 0;
@@ -79,6 +83,10 @@ class IApp {
         virtual void addValueToHistory(uint8_t historyType, uint8_t valueType, uint32_t value) = 0;
         #endif
         virtual void* getRadioObj(bool nrf) = 0;
+
+        // records and heuristics written by Communication (radio task)
+        virtual void lockComm(void) = 0;
+        virtual void unlockComm(void) = 0;
 };
 
 #endif /*__IAPP_H__*/
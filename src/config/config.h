@@ -53,6 +53,12 @@
 // inverter simulation
 //#define ENABLE_SIMULATOR
 
+// RF packet trace, download via /trace
+//#define ENABLE_PACKET_TRACE
+
+// store inverter values as fixed point integers (16 / 32 bit) instead of float
+//#define ENABLE_FIXED_POINT_RECORD
+
 // to enable the syslog logging (will disable web-serial)
 //#define ENABLE_SYSLOG
 
@@ -206,6 +212,10 @@
 // default send interval
 #define SEND_INTERVAL           15
 
+// default limits of the adaptive send interval
+#define SEND_INTERVAL_MIN       5
+#define SEND_INTERVAL_MAX       120
+
 // maximum human readable inverter name length
 #define MAX_NAME_LENGTH         16
 
@@ -215,6 +225,30 @@
 // maximum total payload buffers (must be greater than the number of received frame fragments)
 #define MAX_PAYLOAD_ENTRIES     20
 
+// received frames buffered per radio (power of 2, greater than MAX_PAYLOAD_ENTRIES)
+#define RADIO_RX_BUF_SIZE       32
+
+// ESP32: radios and Communication in an own task (ENABLE_RADIO_TASK), by
+// default above the loop task and on its core
+#if defined(ENABLE_RADIO_TASK)
+    #if !defined(ESP32)
+        #error "ENABLE_RADIO_TASK is only available on ESP32"
+    #endif
+    #ifndef RADIO_TASK_PRIO
+        #define RADIO_TASK_PRIO     2
+    #endif
+    #ifndef RADIO_TASK_CORE
+        #define RADIO_TASK_CORE     ARDUINO_RUNNING_CORE
+    #endif
+    #ifndef RADIO_TASK_STACK
+        #define RADIO_TASK_STACK    6144
+    #endif
+    // results of Communication waiting for the loop task (power of 2)
+    #define COMM_EVENT_BUF_SIZE     16
+    // ticks the radio task waits for a free event slot before it drops the event
+    #define COMM_EVENT_WAIT_TICKS   10
+#endif
+
 // number of seconds since last successful response, before inverter is marked inactive
 #define INVERTER_INACT_THRES_SEC    5*60
 
@@ -257,6 +291,16 @@
 // discovery prefix
 #define MQTT_DISCOVERY_PREFIX   "homeassistant"
 
+// report by exception: all values are published at least every ... seconds
+#define DEF_MQTT_RBE_REFRESH    300
+
+// report by exception: default deadbands (absolute / percent of the last value)
+#define DEF_MQTT_DB_POWER       5.0  // W, var
+#define DEF_MQTT_DB_POWER_REL   2
+#define DEF_MQTT_DB_VOLTAGE     1.0  // V
+#define DEF_MQTT_DB_TEMP        0.5  // °C
+#define DEF_MQTT_DB_YIELD       10.0 // Wh
+
 // reconnect delay
 #define MQTT_RECONNECT_DELAY    5000
 
@@ -31,6 +31,10 @@
 // To enable the endpoint for prometheus to scrape data from at /metrics
 // #define ENABLE_PROMETHEUS_EP
 
+// To measure the run times of the loop, the modules and the tickers, served
+// at /api/perf and /metrics
+// #define ENABLE_PROFILER
+
 
 
 #endif /*__CONFIG_OVERRIDE_H__*/
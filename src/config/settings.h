@@ -31,7 +31,10 @@
  * https://arduino-esp8266.readthedocs.io/en/latest/filesystem.html#flash-layout
  * */
 
-#define CONFIG_VERSION      11
+#define CONFIG_VERSION      15
+
+// deadband classes of the MQTT report by exception, by unit of the field
+enum {MQTT_DB_POWER = 0, MQTT_DB_VOLTAGE, MQTT_DB_TEMP, MQTT_DB_YIELD, MQTT_DB_CNT};
 
 #define PROT_MASK_INDEX     0x0001
 #define PROT_MASK_LIVE      0x0002
@@ -118,6 +121,7 @@ typedef struct {
     uint8_t pinMiso;
     uint8_t pinMosi;
     uint8_t pinSclk;
+    uint8_t chSelect;   // TX channel selection, RF_CH_SEL_QUALITY or RF_CH_SEL_UCB
 } cfgNrf24_t;
 
 typedef struct {
@@ -164,8 +168,13 @@ typedef struct {
     char pwd[MQTT_PWD_LEN];
     char topic[MQTT_TOPIC_LEN];
     bool json;
+    bool batch;                 // one message per inverter with all live data
     uint16_t interval;
     bool enableRetain;
+    bool rbe;                   // report by exception
+    uint16_t rbeRefresh;        // [s] all values are published at least every ...
+    float dbAbs[MQTT_DB_CNT];   // deadbands, see MQTT_DB_POWER
+    uint8_t dbRel[MQTT_DB_CNT]; // [%] of the last published value
 } cfgMqtt_t;
 
 typedef struct {
@@ -192,6 +201,10 @@ typedef struct {
     bool rstIncludeMaxVals;
     bool startWithoutTime;
     bool readGrid;
+    bool adaptiveInterval;  // poll interval per inverter between minInterval and maxInterval
+    bool limitFastPath;     // a power limit preempts the request in progress
+    uint16_t minInterval;
+    uint16_t maxInterval;
 } cfgInst_t;
 
 typedef struct {
@@ -428,6 +441,7 @@ class settings {
             mCfg.nrf.pinMiso           = DEF_NRF_MISO_PIN;
             mCfg.nrf.pinMosi           = DEF_NRF_MOSI_PIN;
             mCfg.nrf.pinSclk           = DEF_NRF_SCLK_PIN;
+            mCfg.nrf.chSelect          = 0; // RF_CH_SEL_QUALITY
 
             #if defined(ETHERNET)
             mCfg.nrf.enabled           = false;
@@ -472,7 +486,9 @@ class settings {
             snprintf(mCfg.mqtt.topic,  MQTT_TOPIC_LEN, "%s", DEF_MQTT_TOPIC);
             mCfg.mqtt.interval = 0; // off
             mCfg.mqtt.json = false; // off
+            mCfg.mqtt.batch = false;
             mCfg.mqtt.enableRetain = true;
+            loadDefaultDeadbands();
 
             mCfg.inst.sendInterval       = SEND_INTERVAL;
             mCfg.inst.rstValsAtMidNight   = false;
@@ -482,6 +498,10 @@ class settings {
             mCfg.inst.startWithoutTime   = false;
             mCfg.inst.rstIncludeMaxVals = false;
             mCfg.inst.readGrid           = true;
+            mCfg.inst.adaptiveInterval   = false;
+            mCfg.inst.limitFastPath      = false;
+            mCfg.inst.minInterval        = SEND_INTERVAL_MIN;
+            mCfg.inst.maxInterval        = SEND_INTERVAL_MAX;
 
             for(uint8_t i = 0; i < MAX_NUM_INVERTERS; i++) {
                 mCfg.inst.iv[i].powerLevel  = 0xff; // impossible high value
@@ -510,6 +530,18 @@ class settings {
             mCfg.plugin.display.pirPin     = DEF_PIN_OFF;
         }
 
+        void loadDefaultDeadbands() {
+            mCfg.mqtt.rbe        = false;
+            mCfg.mqtt.rbeRefresh = DEF_MQTT_RBE_REFRESH;
+            mCfg.mqtt.dbAbs[MQTT_DB_POWER]   = DEF_MQTT_DB_POWER;
+            mCfg.mqtt.dbAbs[MQTT_DB_VOLTAGE] = DEF_MQTT_DB_VOLTAGE;
+            mCfg.mqtt.dbAbs[MQTT_DB_TEMP]    = DEF_MQTT_DB_TEMP;
+            mCfg.mqtt.dbAbs[MQTT_DB_YIELD]   = DEF_MQTT_DB_YIELD;
+            for(uint8_t i = 0; i < MQTT_DB_CNT; i++)
+                mCfg.mqtt.dbRel[i] = 0;
+            mCfg.mqtt.dbRel[MQTT_DB_POWER]   = DEF_MQTT_DB_POWER_REL;
+        }
+
         void loadAddedDefaults() {
             for(uint8_t i = 0; i < MAX_NUM_INVERTERS; i++) {
                 if(mCfg.configVersion < 1) {
@@ -542,6 +574,20 @@ class settings {
                 if(mCfg.configVersion < 11) {
                     mCfg.serial.log2mqtt = false;
                 }
+                if(mCfg.configVersion < 12) {
+                    mCfg.inst.adaptiveInterval = false;
+                    mCfg.inst.minInterval      = SEND_INTERVAL_MIN;
+                    mCfg.inst.maxInterval      = SEND_INTERVAL_MAX;
+                }
+                if(mCfg.configVersion < 13) {
+                    loadDefaultDeadbands();
+                }
+                if(mCfg.configVersion < 14) {
+                    mCfg.inst.limitFastPath = false;
+                }
+                if(mCfg.configVersion < 15) {
+                    mCfg.nrf.chSelect = 0; // RF_CH_SEL_QUALITY
+                }
             }
         }
 
@@ -625,6 +671,7 @@ class settings {
                 obj[F("mosi")]      = mCfg.nrf.pinMosi;
                 obj[F("miso")]      = mCfg.nrf.pinMiso;
                 obj[F("en")]        = (bool) mCfg.nrf.enabled;
+                obj[F("chSel")]     = mCfg.nrf.chSelect;
             } else {
                 getVal<uint8_t>(obj, F("cs"), &mCfg.nrf.pinCs);
                 getVal<uint8_t>(obj, F("ce"), &mCfg.nrf.pinCe);
@@ -632,6 +679,7 @@ class settings {
                 getVal<uint8_t>(obj, F("sclk"), &mCfg.nrf.pinSclk);
                 getVal<uint8_t>(obj, F("mosi"), &mCfg.nrf.pinMosi);
                 getVal<uint8_t>(obj, F("miso"), &mCfg.nrf.pinMiso);
+                getVal<uint8_t>(obj, F("chSel"), &mCfg.nrf.chSelect);
                 #if !defined(ESP32)
                 mCfg.nrf.enabled = true; // ESP8266, read always as enabled
                 #else
@@ -726,19 +774,35 @@ class settings {
                 obj[F("pwd")]      = mCfg.mqtt.pwd;
                 obj[F("topic")]    = mCfg.mqtt.topic;
                 obj[F("json")]     = mCfg.mqtt.json;
+                obj[F("batch")]    = mCfg.mqtt.batch;
                 obj[F("intvl")]    = mCfg.mqtt.interval;
                 obj[F("retain")]   = mCfg.mqtt.enableRetain;
+                obj[F("rbe")]      = mCfg.mqtt.rbe;
+                obj[F("rbeRef")]   = mCfg.mqtt.rbeRefresh;
+                for(uint8_t i = 0; i < MQTT_DB_CNT; i++) {
+                    obj[F("dbAbs")][i] = mCfg.mqtt.dbAbs[i];
+                    obj[F("dbRel")][i] = mCfg.mqtt.dbRel[i];
+                }
 
             } else {
                 getVal<uint16_t>(obj, F("port"), &mCfg.mqtt.port);
                 getVal<uint16_t>(obj, F("intvl"), &mCfg.mqtt.interval);
                 getVal<bool>(obj, F("json"), &mCfg.mqtt.json);
+                getVal<bool>(obj, F("batch"), &mCfg.mqtt.batch);
                 getChar(obj, F("broker"), mCfg.mqtt.broker, MQTT_ADDR_LEN);
                 getChar(obj, F("user"), mCfg.mqtt.user, MQTT_USER_LEN);
                 getChar(obj, F("clientId"), mCfg.mqtt.clientId, MQTT_CLIENTID_LEN);
                 getChar(obj, F("pwd"), mCfg.mqtt.pwd, MQTT_PWD_LEN);
                 getChar(obj, F("topic"), mCfg.mqtt.topic, MQTT_TOPIC_LEN);
                 getVal<bool>(obj, F("retain"), &mCfg.mqtt.enableRetain);
+                getVal<bool>(obj, F("rbe"), &mCfg.mqtt.rbe);
+                getVal<uint16_t>(obj, F("rbeRef"), &mCfg.mqtt.rbeRefresh);
+                if(obj.containsKey(F("dbAbs")) && obj.containsKey(F("dbRel"))) {
+                    for(uint8_t i = 0; i < MQTT_DB_CNT; i++) {
+                        mCfg.mqtt.dbAbs[i] = obj[F("dbAbs")][i];
+                        mCfg.mqtt.dbRel[i] = obj[F("dbRel")][i];
+                    }
+                }
             }
         }
 
@@ -813,6 +877,10 @@ class settings {
                 obj[F("strtWthtTime")]   = (bool)mCfg.inst.startWithoutTime;
                 obj[F("rstMaxMidNight")] = (bool)mCfg.inst.rstIncludeMaxVals;
                 obj[F("rdGrid")]         = (bool)mCfg.inst.readGrid;
+                obj[F("adptIntvl")]      = (bool)mCfg.inst.adaptiveInterval;
+                obj[F("lmtFast")]        = (bool)mCfg.inst.limitFastPath;
+                obj[F("intvlMin")]       = mCfg.inst.minInterval;
+                obj[F("intvlMax")]       = mCfg.inst.maxInterval;
             }
             else {
                 getVal<uint16_t>(obj, F("intvl"), &mCfg.inst.sendInterval);
@@ -824,6 +892,10 @@ class settings {
                 getVal<bool>(obj, F("strtWthtTime"), &mCfg.inst.startWithoutTime);
                 getVal<bool>(obj, F("rstMaxMidNight"), &mCfg.inst.rstIncludeMaxVals);
                 getVal<bool>(obj, F("rdGrid"), &mCfg.inst.readGrid);
+                getVal<bool>(obj, F("adptIntvl"), &mCfg.inst.adaptiveInterval);
+                getVal<bool>(obj, F("lmtFast"), &mCfg.inst.limitFastPath);
+                getVal<uint16_t>(obj, F("intvlMin"), &mCfg.inst.minInterval);
+                getVal<uint16_t>(obj, F("intvlMax"), &mCfg.inst.maxInterval);
             }
 
             JsonArray ivArr;
@@ -19,12 +19,37 @@
     #endif
 #endif
 
+//-----------------------------------------------------------------------------
+// Requests are kept in one pool of N elements, linked into a FIFO per
+// inverter and priority class. get() serves the highest non-empty class and
+// within a class the inverter with the least used airtime (time from get()
+// till the next get() for the same radio). An inverter that was idle starts
+// at the airtime of the last served inverter, so it can't save up credit. A
+// slow or offline inverter with many retries is served less often but can't
+// block the others. Duplicates (inverter, cmd, dev control) are found by a
+// bitmap.
+//-----------------------------------------------------------------------------
 #if defined(CONFIG_IDF_TARGET_ESP32S3)
 template <uint8_t N=200>
 #else
 template <uint8_t N=100>
 #endif
 class CommQueue {
+    public: /* types */
+        enum class Prio : uint8_t {
+            DEV_CONTROL = 0,
+            REALTIME,
+            INFO        // info, alarm, grid profile, ...
+        };
+        static constexpr uint8_t PrioCnt = 3;
+
+        typedef struct {
+            uint32_t cnt;       // dequeued requests
+            uint32_t sumMs;     // time spent in the queue
+            uint32_t maxMs;
+            uint32_t dropCnt;   // queue was full
+        } queueStat_t;
+
     protected: /* types */
         static constexpr uint8_t DefaultAttempts = 5;
         static constexpr uint8_t MoreAttemptsAlarmData = 3;
@@ -37,7 +62,9 @@ class CommQueue {
             uint8_t attempts;
             uint8_t attemptsMax;
             uint32_t ts;
+            uint32_t queued;    // millis() when added
             bool isDevControl;
+            bool preempted;     // by a power limit, only once
 
             QueueElement()
                 : iv {nullptr}
@@ -45,7 +72,9 @@ class CommQueue {
                 , attempts {0}
                 , attemptsMax {0}
                 , ts {0}
+                , queued {0}
                 , isDevControl {false}
+                , preempted {false}
             {}
 
             QueueElement(Inverter<> *iv, uint8_t cmd, bool devCtrl)
@@ -54,7 +83,9 @@ class CommQueue {
                 , attempts {DefaultAttempts}
                 , attemptsMax {DefaultAttempts}
                 , ts {0}
+                , queued {0}
                 , isDevControl {devCtrl}
+                , preempted {false}
             {}
 
             QueueElement(const QueueElement&) = delete;
@@ -96,19 +127,30 @@ class CommQueue {
                 std::swap(this->attempts, other.attempts);
                 std::swap(this->attemptsMax, other.attemptsMax);
                 std::swap(this->ts, other.ts);
+                std::swap(this->queued, other.queued);
                 std::swap(this->isDevControl, other.isDevControl);
+                std::swap(this->preempted, other.preempted);
             }
         };
 
     public:
-        CommQueue()
-            : wrPtr {0}
-            , rdPtr {0}
-        {
+        CommQueue() {
             #if defined(ESP32)
             this->mutex = xSemaphoreCreateBinaryStatic(&this->mutex_buffer);
             xSemaphoreGive(this->mutex);
+            #else
+            this->mutex = false;
             #endif
+            for(uint8_t i = 0; i < N; i++)
+                mNext[i] = ((i + 1) < N) ? (i + 1) : Nil;
+            mFree = 0;
+            mList.fill({Nil, Nil});
+            mPending.fill(0);
+            mAirtime.fill(0);
+            mDup.fill(0);
+            mCurIv.fill(Nil);
+            mCurStart.fill(0);
+            resetQueueStats();
         }
 
         ~CommQueue() {
@@ -117,103 +159,208 @@ class CommQueue {
 
         void addImportant(Inverter<> *iv, uint8_t cmd) {
             QueueElement q(iv, cmd, true);
-            xSemaphoreTake(this->mutex, portMAX_DELAY);
-            if(!isIncluded(&q)) {
-                dec(&this->rdPtr);
-                mQueue[this->rdPtr] = std::move(q);
-            }
-            xSemaphoreGive(this->mutex);
+            push(&q, Prio::DEV_CONTROL);
         }
 
         void add(Inverter<> *iv, uint8_t cmd) {
             QueueElement q(iv, cmd, false);
-            xSemaphoreTake(this->mutex, portMAX_DELAY);
-            if(!isIncluded(&q)) {
-                mQueue[this->wrPtr] = std::move(q);
-                inc(&this->wrPtr);
-            }
-            xSemaphoreGive(this->mutex);
+            push(&q, getPrio(iv, cmd));
         }
 
         uint8_t getFillState(void) const {
-            //DPRINTLN(DBG_INFO, "wr: " + String(this->wrPtr) + ", rd: " + String(this->rdPtr));
-            return abs(this->rdPtr - this->wrPtr);
+            return mFillCnt;
         }
 
         uint8_t getMaxFill(void) const {
             return N;
         }
 
-    protected:
-        void add(QueueElement q) {
+        // a power limit is queued as dev control request for an inverter of
+        // this radio type (INV_RADIO_TYPE_UNKNOWN for all)
+        bool hasPendingLimit(uint8_t radioType) {
+            bool found = false;
             xSemaphoreTake(this->mutex, portMAX_DELAY);
-            mQueue[this->wrPtr] = q;
-            inc(&this->wrPtr);
+            for(uint8_t id = 0; id < MAX_NUM_INVERTERS; id++) {
+                uint8_t pos = mList[id * PrioCnt + static_cast<uint8_t>(Prio::DEV_CONTROL)].head;
+                if(Nil == pos)
+                    continue;
+                if((INV_RADIO_TYPE_UNKNOWN != radioType) && (mQueue[pos].iv->ivRadioType != radioType))
+                    continue;
+                if(ActivePowerContr == mQueue[pos].cmd) {
+                    found = true;
+                    break;
+                }
+            }
             xSemaphoreGive(this->mutex);
+            return found;
+        }
+
+        const queueStat_t *getQueueStat(Prio prio) const {
+            return &mStat[static_cast<uint8_t>(prio)];
         }
 
+        void resetQueueStats(void) {
+            for(queueStat_t &st : mStat)
+                memset(&st, 0, sizeof(queueStat_t));
+        }
+
+    protected:
         void add(QueueElement *q, bool rstAttempts = false) {
-            xSemaphoreTake(this->mutex, portMAX_DELAY);
             if(rstAttempts) {
                 q->attempts = DefaultAttempts;
                 q->attemptsMax = DefaultAttempts;
             }
-            mQueue[this->wrPtr] = std::move(*q);
-            inc(&this->wrPtr);
-            xSemaphoreGive(this->mutex);
+            push(q, q->isDevControl ? Prio::DEV_CONTROL : getPrio(q->iv, q->cmd));
         }
 
-        void get(std::function<void(bool valid, QueueElement *q)> cb) {
+        // radioType: only inverters using this radio, INV_RADIO_TYPE_UNKNOWN for all
+        void get(std::function<void(bool valid, QueueElement *q)> cb, uint8_t radioType = INV_RADIO_TYPE_UNKNOWN) {
             xSemaphoreTake(this->mutex, portMAX_DELAY);
-            if(this->rdPtr == this->wrPtr) {
-                xSemaphoreGive(this->mutex);
-                cb(false, nullptr); // empty
-            } else {
-                QueueElement el = std::move(mQueue[this->rdPtr]);
-                inc(&this->rdPtr);
+            uint32_t now = millis();
+            uint8_t *curIv = &mCurIv[radioType];
+            if(Nil != *curIv) { // charge the airtime of the previous request of this radio
+                mAirtime[*curIv] += now - mCurStart[radioType];
+                *curIv = Nil;
+            }
+
+            for(uint8_t p = 0; p < PrioCnt; p++) {
+                uint8_t id = Nil;
+                for(uint8_t i = 0; i < MAX_NUM_INVERTERS; i++) {
+                    uint8_t j = (mRr + i) % MAX_NUM_INVERTERS;
+                    if(Nil == mList[j * PrioCnt + p].head)
+                        continue;
+                    if((INV_RADIO_TYPE_UNKNOWN != radioType) && (mQueue[mList[j * PrioCnt + p].head].iv->ivRadioType != radioType))
+                        continue;
+                    if((Nil == id) || ((int32_t)(mAirtime[j] - mAirtime[id]) < 0))
+                        id = j;
+                }
+                if(Nil == id)
+                    continue;
+
+                uint8_t pos = pop(id, p);
+                QueueElement el = std::move(mQueue[pos]);
+                mNext[pos] = mFree;
+                mFree = pos;
+
+                queueStat_t *st = &mStat[p];
+                uint32_t waitMs = now - el.queued;
+                st->cnt++;
+                st->sumMs += waitMs;
+                if(waitMs > st->maxMs)
+                    st->maxMs = waitMs;
+
+                mLastAirtime         = mAirtime[id];
+                mRr                  = (id + 1) % MAX_NUM_INVERTERS;
+                *curIv               = id;
+                mCurStart[radioType] = now;
                 xSemaphoreGive(this->mutex);
                 cb(true, &el);
+                return;
             }
+
+            xSemaphoreGive(this->mutex);
+            cb(false, nullptr); // empty
         }
 
         void cmdReset(QueueElement *q) {
             q->attempts = DefaultAttempts;
             q->attemptsMax = DefaultAttempts;
-            add(q); // add to the end again
+            // a repeated dev control request competes with the live data of
+            // the other inverters, otherwise an unreachable inverter would
+            // block them
+            push(q, q->isDevControl ? Prio::REALTIME : getPrio(q->iv, q->cmd));
         }
 
     private:
-        void inc(uint8_t *ptr) {
-            if(++(*ptr) >= N)
-                *ptr = 0;
+        typedef struct {
+            uint8_t head;
+            uint8_t tail;
+        } list_t;
+
+        static constexpr uint8_t Nil = 0xff;
+
+        static Prio getPrio(const Inverter<> *iv, uint8_t cmd) {
+            if(IV_MI == iv->ivGen) {
+                if((MI_REQ_CH1 == cmd) || (MI_REQ_CH2 == cmd) || (MI_REQ_4CH == cmd))
+                    return Prio::REALTIME;
+            } else if(RealTimeRunData_Debug == cmd)
+                return Prio::REALTIME;
+            return Prio::INFO;
         }
-        void dec(uint8_t *ptr) {
-            if((*ptr) == 0)
-                *ptr = N-1;
-            else
-                --(*ptr);
+
+        // bit of (inverter, dev control, cmd) in mDup
+        static inline uint16_t getDupBit(const QueueElement *q) {
+            return (q->iv->id * 512) + (q->isDevControl ? 256 : 0) + q->cmd;
         }
 
-        bool isIncluded(const QueueElement *q) {
-            uint8_t ptr = this->rdPtr;
-            while (ptr != this->wrPtr) {
-                if(mQueue[ptr].cmd == q->cmd) {
-                    if(mQueue[ptr].iv->id == q->iv->id) {
-                        if(mQueue[ptr].isDevControl == q->isDevControl)
-                            return true;
-                    }
-                }
-                inc(&ptr);
+        void push(QueueElement *q, Prio prio) {
+            uint8_t p = static_cast<uint8_t>(prio);
+            xSemaphoreTake(this->mutex, portMAX_DELAY);
+            uint16_t bit = getDupBit(q);
+            if(mDup[bit / 32] & (1UL << (bit % 32))) {
+                xSemaphoreGive(this->mutex);
+                return;
             }
-            return false;
+            if(Nil == mFree) {
+                mStat[p].dropCnt++;
+                xSemaphoreGive(this->mutex);
+                DPRINTLN(DBG_WARN, F("send queue full, request dropped"));
+                return;
+            }
+
+            uint8_t pos = mFree;
+            mFree = mNext[pos];
+            q->queued = millis();
+            mQueue[pos] = std::move(*q);
+            mNext[pos] = Nil;
+
+            uint8_t id = mQueue[pos].iv->id;
+            list_t *l = &mList[id * PrioCnt + p];
+            if(Nil == l->head)
+                l->head = pos;
+            else
+                mNext[l->tail] = pos;
+            l->tail = pos;
+
+            if(0 == mPending[id]++) { // was idle, no credit from the past
+                if((int32_t)(mAirtime[id] - mLastAirtime) < 0)
+                    mAirtime[id] = mLastAirtime;
+            }
+            mDup[bit / 32] |= (1UL << (bit % 32));
+            mFillCnt++;
+            xSemaphoreGive(this->mutex);
+        }
+
+        uint8_t pop(uint8_t id, uint8_t p) {
+            list_t *l = &mList[id * PrioCnt + p];
+            uint8_t pos = l->head;
+            l->head = mNext[pos];
+            if(Nil == l->head)
+                l->tail = Nil;
+
+            uint16_t bit = getDupBit(&mQueue[pos]);
+            mDup[bit / 32] &= ~(1UL << (bit % 32));
+            mPending[id]--;
+            mFillCnt--;
+            return pos;
         }
 
     protected:
         std::array<QueueElement, N> mQueue;
 
     private:
-        uint8_t wrPtr;
-        uint8_t rdPtr;
+        std::array<uint8_t, N> mNext;                               // next element in the same list or free list
+        std::array<list_t, MAX_NUM_INVERTERS * PrioCnt> mList;      // FIFO per inverter and class
+        std::array<uint8_t, MAX_NUM_INVERTERS> mPending;            // elements per inverter
+        std::array<uint32_t, MAX_NUM_INVERTERS> mAirtime;           // ms used by the requests of the inverter
+        std::array<uint32_t, MAX_NUM_INVERTERS * 16> mDup;          // 2 x 256 cmd bits per inverter
+        std::array<queueStat_t, PrioCnt> mStat;
+        uint8_t mFree = 0;
+        uint8_t mFillCnt = 0;
+        uint8_t mRr = 0;                // round robin start for equal airtime
+        std::array<uint8_t, 3> mCurIv;      // inverter of the request in progress per radio type
+        std::array<uint32_t, 3> mCurStart;
+        uint32_t mLastAirtime = 0;      // airtime of the last served inverter
         #if defined(ESP32)
         SemaphoreHandle_t mutex;
         StaticSemaphore_t mutex_buffer;
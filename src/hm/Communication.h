@@ -15,6 +15,15 @@
 
 #define MAX_BUFFER          200
 
+// independent requests in flight, nRF24 and CMT2300A inverters are polled in parallel
+#ifndef COMM_RADIO_SLOTS
+    #if defined(ESP32) || defined(NATIVE_BUILD)
+        #define COMM_RADIO_SLOTS    2
+    #else
+        #define COMM_RADIO_SLOTS    1
+    #endif
+#endif
+
 typedef std::function<void(uint8_t, Inverter<> *)> payloadListenerType;
 typedef std::function<void(Inverter<> *)> powerLimitAckListenerType;
 typedef std::function<void(Inverter<> *)> alarmListenerType;
@@ -34,6 +43,22 @@ class Communication : public CommQueue<> {
             mPrintWholeTrace = printWholeTrace;
         }
 
+        // nRF channel selection, RF_CH_SEL_QUALITY or RF_CH_SEL_UCB (HeuristicInv.h)
+        void setChannelSelection(const uint8_t *mode) {
+            mHeu.setup(mode);
+            Inverter<>::ChSelect = mode;
+        }
+
+        // a queued power limit preempts the request in progress (not a dev
+        // control request) of the same radio, cfgInst_t::limitFastPath
+        void setLimitFastPath(const bool *en) {
+            mLimitFastPath = en;
+        }
+
+        uint32_t getPreemptCnt(void) const {
+            return mPreemptCnt;
+        }
+
         void addPayloadListener(payloadListenerType cb) {
             mCbPayload = cb;
         }
@@ -47,46 +72,54 @@ class Communication : public CommQueue<> {
         }
 
         void loop() {
-            if(States::IDLE == mState) {
-                get([this](bool valid, QueueElement *q) {
-                    if(!valid) {
-                        if(mPrintSequenceDuration) {
-                            mPrintSequenceDuration = false;
-                            DPRINT(DBG_INFO, F("com loop duration: "));
-                            DBGPRINT(String(millis() - mLastEmptyQueueMillis));
-                            DBGPRINTLN(F("ms"));
-                            DBGPRINTLN(F("-----"));
-                        }
-                        return; // empty
-                    }
+            bool idle = true;
+            for(uint8_t i = 0; i < COMM_RADIO_SLOTS; i++) {
+                mCur = &mSlot[i];
+                if((nullptr != mLimitFastPath) && *mLimitFastPath && isPreemptible(&mCur->el)) {
+                    if(hasPendingLimit(getSlotRadioType(i)))
+                        preempt(&mCur->el);
+                }
 
-                    el = std::move(*q);
-                    mState = States::INIT;
-                    if(!mPrintSequenceDuration) // entry was added to the queue
-                        mLastEmptyQueueMillis = millis();
-                    mPrintSequenceDuration = true;
-                });
+                if(States::IDLE == mCur->state) {
+                    get([this](bool valid, QueueElement *q) {
+                        if(!valid)
+                            return; // empty
+
+                        mCur->el = std::move(*q);
+                        mCur->state = States::INIT;
+                        if(!mPrintSequenceDuration) // entry was added to the queue
+                            mLastEmptyQueueMillis = millis();
+                        mPrintSequenceDuration = true;
+                    }, getSlotRadioType(i));
+                }
+
+                if(nullptr != mCur->el.iv)
+                    innerLoop(&mCur->el);
+                if(States::IDLE != mCur->state)
+                    idle = false;
             }
 
-            if(nullptr != el.iv)
-                innerLoop(&el);
+            if(idle && mPrintSequenceDuration && (0 == getFillState())) {
+                mPrintSequenceDuration = false;
+                DPRINT(DBG_INFO, F("com loop duration: "));
+                DBGPRINT(String(millis() - mLastEmptyQueueMillis));
+                DBGPRINTLN(F("ms"));
+                DBGPRINTLN(F("-----"));
+            }
         }
 
     private:
         inline void innerLoop(QueueElement *q) {
-            switch(mState) {
+            switch(mCur->state) {
                 default:
                 case States::IDLE:
                     break;
 
                 case States::INIT:
-                    if (!mWaitTime.isTimeout())
+                    if (!mCur->waitTime.isTimeout())
                         return;
 
-                    mMaxFrameId = 0;
-                    for(uint8_t i = 0; i < MAX_PAYLOAD_ENTRIES; i++) {
-                        mLocalBuf[i].len = 0;
-                    }
+                    resetPayload();
 
                     if(*mSerialDebug)
                         mHeu.printStatus(q->iv);
@@ -95,17 +128,17 @@ class Communication : public CommQueue<> {
                     q->iv->mGotLastMsg  = false;
                     q->iv->curFrmCnt    = 0;
                     q->iv->radioStatistics.txCnt++;
-                    mIsRetransmit = false;
-                    mFirstTry = (INV_RADIO_TYPE_NRF == q->iv->ivRadioType) && (q->iv->isAvailable());
+                    mCur->isRetransmit = false;
+                    mCur->firstTry = (INV_RADIO_TYPE_NRF == q->iv->ivRadioType) && (q->iv->isAvailable());
                     q->iv->mCmd = q->cmd;
                     q->iv->mIsSingleframeReq = false;
-                    mFramesExpected = getFramesExpected(q); // function to get expected frame count.
-                    mTimeout = DURATION_TXFRAME + mFramesExpected*DURATION_ONEFRAME + duration_reserve[q->iv->ivRadioType];
+                    mCur->framesExpected = getFramesExpected(q); // function to get expected frame count.
+                    mCur->timeout = DURATION_TXFRAME + mCur->framesExpected*DURATION_ONEFRAME + duration_reserve[q->iv->ivRadioType];
                     if((q->iv->ivGen == IV_MI) && ((q->cmd == MI_REQ_CH1) || (q->cmd == MI_REQ_4CH)))
                         q->incrAttempt(q->iv->channels); // 2 more attempts for 2ch, 4 more for 4ch
 
                     if(NULL != q->iv->radio)
-                        mState = States::START;
+                        mCur->state = States::START;
                     break;
 
                 case States::START:
@@ -119,30 +152,32 @@ class Communication : public CommQueue<> {
                     }
 
                     if(q->isDevControl) {
-                        if(ActivePowerContr == q->cmd)
+                        if(ActivePowerContr == q->cmd) {
                             q->iv->powerLimitAck = false;
+                            q->iv->limitBox.take(q->iv->powerLimit); // latest set point
+                        }
                         q->iv->radio->sendControlPacket(q->iv, q->cmd, q->iv->powerLimit, false);
                     } else
                         q->iv->radio->prepareDevInformCmd(q->iv, q->cmd, q->ts, q->iv->alarmLastId, false);
 
                     //q->iv->radioStatistics.txCnt++;
-                    q->iv->radio->mRadioWaitTime.startTimeMonitor(mTimeout);
-                    if((!mIsRetransmit && (q->cmd == AlarmData)) || (q->cmd == GridOnProFilePara))
+                    q->iv->radio->mRadioWaitTime.startTimeMonitor(mCur->timeout);
+                    if((!mCur->isRetransmit && (q->cmd == AlarmData)) || (q->cmd == GridOnProFilePara))
                         q->incrAttempt((q->cmd == AlarmData)? CommQueue::MoreAttemptsAlarmData : CommQueue::MoreAttemptsGridProfile);
 
-                    mIsRetransmit    = false;
+                    mCur->isRetransmit = false;
                     q->setAttempt();
-                    mState = States::WAIT;
+                    mCur->state = States::WAIT;
                     break;
 
                 case States::WAIT:
                     if (!q->iv->radio->mRadioWaitTime.isTimeout())
                         return;
-                    mState = States::CHECK_FRAMES;
+                    mCur->state = States::CHECK_FRAMES;
                     break;
 
                 case States::CHECK_FRAMES: {
-                    if((q->iv->radio->mBufCtrl.empty() && !mIsRetransmit) ) { // || (0 == q->attempts)) { // radio buffer empty. No more answers will be checked later
+                    if((q->iv->radio->mBufCtrl.empty() && !mCur->isRetransmit) ) { // || (0 == q->attempts)) { // radio buffer empty. No more answers will be checked later
                         if(*mSerialDebug) {
                             DPRINT_IVID(DBG_INFO, q->iv->id);
                             DBGPRINT(F("request timeout: "));
@@ -157,21 +192,21 @@ class Communication : public CommQueue<> {
                                     DPRINT_IVID(DBG_INFO, q->iv->id);
                                     DBGPRINTLN(F("switch frequency failed!"));
                                 }
-                                mWaitTime.startTimeMonitor(1000);
+                                mCur->waitTime.startTimeMonitor(1000);
                                 #endif
                             } else {
                                 mHeu.setIvRetriesBad(q->iv);
                                 if(IV_MI == q->iv->ivGen)
                                     q->iv->mIvTxCnt++;
 
-                                if(mFirstTry) {
+                                if(mCur->firstTry) {
                                     if(q->attempts < 3 || !q->iv->isProducing())
-                                        mFirstTry = false;
+                                        mCur->firstTry = false;
                                     mHeu.evalTxChQuality(q->iv, false, 0, 0);
                                     mHeu.getTxCh(q->iv);
                                     q->iv->radioStatistics.retransmits++;
                                     q->iv->radio->mRadioWaitTime.stopTimeMonitor();
-                                    mState = States::START;
+                                    mCur->state = States::START;
                                     return;
                                 }
                             }
@@ -179,30 +214,29 @@ class Communication : public CommQueue<> {
                         closeRequest(q, false);
                         break;
                     }
-                    mFirstTry = false; // for correct reset
+                    mCur->firstTry = false; // for correct reset
                     if((IV_MI != q->iv->ivGen) || (0 == q->attempts))
-                        mIsRetransmit = false;
+                        mCur->isRetransmit = false;
 
                     while(!q->iv->radio->mBufCtrl.empty()) {
                         packet_t *p = &q->iv->radio->mBufCtrl.front();
 
                         if(validateIvSerial(&p->packet[1], q->iv)) {
                             printRxInfo(q, p);
+                            mHeu.addRxCh(q->iv, p->ch);
                             q->iv->radioStatistics.frmCnt++;
                             q->iv->mDtuRxCnt++;
 
                             if (p->packet[0] == (TX_REQ_INFO + ALL_FRAMES)) {  // response from get information command
                                 if(parseFrame(q, p)) {
                                     q->iv->curFrmCnt++;
-                                    if(!mIsRetransmit && ((p->packet[9] == 0x02) || (p->packet[9] == 0x82)) && (p->millis < LIMIT_FAST_IV))
+                                    if(!mCur->isRetransmit && ((p->packet[9] == 0x02) || (p->packet[9] == 0x82)) && (p->millis < LIMIT_FAST_IV))
                                         mHeu.setIvRetriesGood(q->iv,p->millis < LIMIT_VERYFAST_IV);
                                 }
                             } else if (p->packet[0] == (TX_REQ_DEVCONTROL + ALL_FRAMES)) { // response from dev control command
-                                q->iv->radio->mBufCtrl.pop();
-                                if(parseDevCtrl(p, q))
-                                    closeRequest(q, true);
-                                else
-                                    closeRequest(q, false);
+                                bool accepted = parseDevCtrl(p, q);
+                                q->iv->radio->mBufCtrl.pop(); // slot is released after parsing
+                                closeRequest(q, accepted);
                                 return; // don't wait for empty buffer
                             } else if(IV_MI == q->iv->ivGen) {
                                 parseMiFrame(p, q);
@@ -215,10 +249,10 @@ class Communication : public CommQueue<> {
                     }
 
                     if(q->iv->ivGen != IV_MI) {
-                        mState = States::CHECK_PACKAGE;
+                        mCur->state = States::CHECK_PACKAGE;
                     } else {
                         if(q->iv->miMultiParts < 6) {
-                            mState = States::WAIT;
+                            mCur->state = States::WAIT;
                             if(q->iv->radio->mRadioWaitTime.isTimeout() && q->attempts) {
                                 miRepeatRequest(q);
                                 return;
@@ -243,25 +277,8 @@ class Communication : public CommQueue<> {
 
                 case States::CHECK_PACKAGE:
                     uint8_t framnr = 0;
-                    if(0 == mMaxFrameId) {
-                        uint8_t i = 0;
-                        while(i < MAX_PAYLOAD_ENTRIES) {
-                            if(mLocalBuf[i].len == 0) {
-                                framnr = i+1;
-                                break;
-                            }
-                            i++;
-                        }
-                    }
-
-                    if(!framnr) {
-                        for(uint8_t i = 0; i < mMaxFrameId; i++) {
-                            if(mLocalBuf[i].len == 0) {
-                                framnr = i+1;
-                                break;
-                            }
-                        }
-                    }
+                    if(((0 == mCur->maxFrameId) && (mCur->nextFrame < MAX_PAYLOAD_ENTRIES)) || (mCur->nextFrame < mCur->maxFrameId))
+                        framnr = mCur->nextFrame + 1; // first missing frame
 
                     if(framnr) {
                         if(0 == q->attempts) {
@@ -274,7 +291,7 @@ class Communication : public CommQueue<> {
                         if(!q->iv->mIsSingleframeReq && (q->iv->ivRadioType == INV_RADIO_TYPE_NRF)) {  // already checked?
                             uint8_t missedFrames = 0;
                             for(uint8_t i = 0; i < q->iv->radio->mFramesExpected; i++) {
-                                if(mLocalBuf[i].len == 0)
+                                if(!isFrameRcvd(i))
                                     missedFrames++;
                             }
                             if(missedFrames > 3 || (q->cmd == RealTimeRunData_Debug && missedFrames > 1) || ((missedFrames > 1) && ((missedFrames + 2) > q->attempts))) {
@@ -287,8 +304,8 @@ class Communication : public CommQueue<> {
                                 mHeu.evalTxChQuality(q->iv, false, (q->attemptsMax - 1 - q->attempts), q->iv->curFrmCnt, true);
                                 q->iv->radioStatistics.txCnt--;
                                 q->iv->radioStatistics.retransmits++;
-                                mCompleteRetry = true;
-                                mState = States::IDLE;
+                                mCur->completeRetry = true;
+                                mCur->state = States::IDLE;
                                 return;
                             }
                         }
@@ -303,10 +320,10 @@ class Communication : public CommQueue<> {
                             DBGPRINT(String(q->attempts));
                             DBGPRINTLN(F(" attempts left)"));
                         }
-                        if (!mIsRetransmit)
+                        if (!mCur->isRetransmit)
                             q->iv->mIsSingleframeReq = true;
                         sendRetransmit(q, (framnr-1));
-                        mIsRetransmit = true;
+                        mCur->isRetransmit = true;
                         return;
                     }
 
@@ -437,21 +454,72 @@ class Communication : public CommQueue<> {
             }
 
             if((*frameId & ALL_FRAMES) == ALL_FRAMES) {
-                mMaxFrameId = (*frameId & 0x7f);
-                if(mMaxFrameId > 8) // large payloads, e.g. AlarmData
-                    q->incrAttempt(mMaxFrameId - 6);
+                mCur->maxFrameId = (*frameId & 0x7f);
+                if(mCur->maxFrameId > 8) // large payloads, e.g. AlarmData
+                    q->incrAttempt(mCur->maxFrameId - 6);
             }
 
-            frame_t *f = &mLocalBuf[(*frameId & 0x7f) - 1];
-            memcpy(f->buf, &p->packet[10], p->len-11);
-            f->len  = p->len - 11;
-            f->rssi = p->rssi;
+            uint8_t id = (*frameId & 0x7f) - 1;
+            if(isFrameRcvd(id) || ((0 != mCur->maxFrameId) && (id >= mCur->maxFrameId)))
+                return true; // duplicate or behind the last frame
+            mCur->frameRcvd |= (1UL << id);
+            // get worst RSSI (high value is better)
+            if(p->rssi > mCur->rssi)
+                mCur->rssi = p->rssi;
+
+            if(id != mCur->nextFrame) { // out of order, keep it until the gap is closed
+                frame_t *f = &mCur->localBuf[id];
+                memcpy(f->buf, &p->packet[10], p->len-11);
+                f->len  = p->len - 11;
+                return true;
+            }
+
+            appendFrame(&p->packet[10], p->len - 11);
+            uint8_t end = (0 != mCur->maxFrameId) ? mCur->maxFrameId : MAX_PAYLOAD_ENTRIES;
+            while((mCur->nextFrame < end) && isFrameRcvd(mCur->nextFrame))
+                appendFrame(mCur->localBuf[mCur->nextFrame].buf, mCur->localBuf[mCur->nextFrame].len);
 
             return true;
         }
 
+        // copies the next in order fragment to its final position in the payload
+        // and adds it to the running CRC16, the last two bytes are the CRC
+        inline void appendFrame(const uint8_t buf[], uint8_t len) {
+            bool isLast = ((mCur->nextFrame + 1) == mCur->maxFrameId);
+            mCur->nextFrame++;
+            if((mCur->payloadLen + len) > MAX_BUFFER) {
+                mCur->payloadOverflow = true;
+                return;
+            }
+            memcpy(&mCur->payload[mCur->payloadLen], buf, len);
+            mCur->payloadLen += len;
+
+            if(!isLast)
+                mCur->crc.update(buf, len);
+            else if(len >= 2) {
+                mCur->crc.update(buf, len - 2);
+                mCur->crcRcv = (buf[len-2] << 8) | buf[len-1];
+            } else
+                mCur->crcRcv = ~mCur->crc.get(); // CRC split over two frames is not supported, force a CRC error
+        }
+
+        inline bool isFrameRcvd(uint8_t id) const {
+            return (id < MAX_PAYLOAD_ENTRIES) && (mCur->frameRcvd & (1UL << id));
+        }
+
+        inline void resetPayload(void) {
+            mCur->maxFrameId      = 0;
+            mCur->nextFrame       = 0;
+            mCur->frameRcvd       = 0;
+            mCur->payloadLen      = 0;
+            mCur->payloadOverflow = false;
+            mCur->rssi            = -127;
+            mCur->crcRcv          = 0x0000;
+            mCur->crc.reset();
+        }
+
         inline void parseMiFrame(packet_t *p, QueueElement *q) {
-            if((!mIsRetransmit && p->packet[9] == 0x00) && (p->millis < LIMIT_FAST_IV_MI)) //first frame is fast?
+            if((!mCur->isRetransmit && p->packet[9] == 0x00) && (p->millis < LIMIT_FAST_IV_MI)) //first frame is fast?
                 mHeu.setIvRetriesGood(q->iv,p->millis < LIMIT_VERYFAST_IV_MI);
             if ((p->packet[0] == MI_REQ_CH1 + ALL_FRAMES)
                 || (p->packet[0] == MI_REQ_CH2 + ALL_FRAMES)
@@ -495,7 +563,7 @@ class Communication : public CommQueue<> {
 
             bool accepted = true;
             if((p->packet[10] == 0x00) && (p->packet[11] == 0x00))
-                q->iv->powerLimitAck = true;
+                q->iv->powerLimitAck = q->iv->limitBox.ack(); // a newer limit is still waiting
             else
                 accepted = false;
 
@@ -513,17 +581,13 @@ class Communication : public CommQueue<> {
         }
 
         inline bool compilePayload(QueueElement *q) {
-            uint16_t crc = 0xffff, crcRcv = 0x0000;
-            for(uint8_t i = 0; i < mMaxFrameId; i++) {
-                if(i == (mMaxFrameId - 1)) {
-                    crc = ah::crc16(mLocalBuf[i].buf, mLocalBuf[i].len - 2, crc);
-                    crcRcv = (mLocalBuf[i].buf[mLocalBuf[i].len-2] << 8);
-                    crcRcv |= mLocalBuf[i].buf[mLocalBuf[i].len-1];
-                } else
-                    crc = ah::crc16(mLocalBuf[i].buf, mLocalBuf[i].len, crc);
+            // all fragments are in place and the CRC16 was accumulated while they arrived
+            if(mCur->payloadOverflow) {
+                DPRINTLN(DBG_ERROR, F("payload buffer to small!"));
+                return true;
             }
 
-            if(crc != crcRcv) {
+            if(mCur->crc.get() != mCur->crcRcv) {
                 DPRINT_IVID(DBG_WARN, q->iv->id);
                 DBGPRINT(F("CRC Error "));
                 if(q->attempts == 0) {
@@ -531,28 +595,14 @@ class Communication : public CommQueue<> {
 
                 } else
                     DBGPRINTLN(F("-> complete retransmit"));
-                mCompleteRetry = true;
-                mState = States::IDLE;
+                mCur->completeRetry = true;
+                mCur->state = States::IDLE;
                 return false;
             }
 
-            mPayload.fill(0);
-            int8_t rssi = -127;
-            uint8_t len = 0;
-
-            for(uint8_t i = 0; i < mMaxFrameId; i++) {
-                if(mLocalBuf[i].len + len > MAX_BUFFER) {
-                    DPRINTLN(DBG_ERROR, F("payload buffer to small!"));
-                    return true;
-                }
-                memcpy(&mPayload[len], mLocalBuf[i].buf, mLocalBuf[i].len);
-                len += mLocalBuf[i].len;
-                // get worst RSSI (high value is better)
-                if(mLocalBuf[i].rssi > rssi)
-                    rssi = mLocalBuf[i].rssi;
-            }
-
-            len -= 2;
+            std::fill(mCur->payload.begin() + mCur->payloadLen, mCur->payload.end(), 0);
+            int8_t rssi = mCur->rssi;
+            uint8_t len = mCur->payloadLen - 2;
 
             if(*mSerialDebug) {
                 DPRINT_IVID(DBG_INFO, q->iv->id);
@@ -560,20 +610,20 @@ class Communication : public CommQueue<> {
                 DBGPRINT(String(len));
                 if(*mPrintWholeTrace) {
                     DBGPRINT(F("): "));
-                    ah::dumpBuf(mPayload.data(), len);
+                    ah::dumpBuf(mCur->payload.data(), len);
                 } else
                     DBGPRINTLN(F(")"));
             }
 
             if(GridOnProFilePara == q->cmd) {
-                q->iv->addGridProfile(mPayload.data(), len);
+                q->iv->addGridProfile(mCur->payload.data(), len);
                 return true;
             }
 
             record_t<> *rec = q->iv->getRecordStruct(q->cmd);
             if(NULL == rec) {
                 if(GetLossRate == q->cmd) {
-                    q->iv->parseGetLossRate(mPayload.data(), len);
+                    q->iv->parseGetLossRate(mCur->payload.data(), len);
                     return true;
                 } else
                     DPRINTLN(DBG_ERROR, F("record is NULL!"));
@@ -591,9 +641,7 @@ class Communication : public CommQueue<> {
             }
 
             rec->ts = q->ts;
-            for (uint8_t i = 0; i < rec->length; i++) {
-                q->iv->addValue(i, mPayload.data(), rec);
-            }
+            q->iv->addValues(mCur->payload.data(), rec);
             rec->mqttSentStatus = MqttSentStatus::NEW_DATA;
 
             q->iv->rssi = rssi;
@@ -605,7 +653,7 @@ class Communication : public CommQueue<> {
             if(AlarmData == q->cmd) {
                 uint8_t i = 0;
                 while(1) {
-                    if(0 == q->iv->parseAlarmLog(i++, mPayload.data(), len))
+                    if(0 == q->iv->parseAlarmLog(i++, mCur->payload.data(), len))
                         break;
                     if (NULL != mCbAlarm)
                         (mCbAlarm)(q->iv);
@@ -616,25 +664,57 @@ class Communication : public CommQueue<> {
         }
 
         void sendRetransmit(QueueElement *q, uint8_t i) {
-            mFramesExpected = 1;
-            q->iv->radio->setExpectedFrames(mFramesExpected);
+            mCur->framesExpected = 1;
+            q->iv->radio->setExpectedFrames(mCur->framesExpected);
             q->iv->radio->sendCmdPacket(q->iv, TX_REQ_INFO, (SINGLE_FRAME + i), true);
             q->iv->radioStatistics.retransmits++;
             q->iv->radio->mRadioWaitTime.startTimeMonitor(DURATION_TXFRAME + DURATION_ONEFRAME + duration_reserve[q->iv->ivRadioType]);
 
-            mState = States::WAIT;
+            mCur->state = States::WAIT;
         }
 
     private:
+        // request which wasn't answered yet and is no dev control request,
+        // once per request, otherwise fast limits would stop the polling
+        inline bool isPreemptible(const QueueElement *q) const {
+            if((nullptr == q->iv) || q->isDevControl || q->preempted)
+                return false;
+            if(States::WAIT == mCur->state) // no fragment received so far
+                return q->iv->radio->mBufCtrl.empty() && !q->iv->mGotFragment && !mCur->isRetransmit;
+            return (States::INIT == mCur->state) || (States::START == mCur->state);
+        }
+
+        // the request is added to the queue again, the power limit is sent
+        // with the next get()
+        void preempt(QueueElement *q) {
+            if(States::INIT != mCur->state) { // counted in INIT, sent again later
+                q->iv->radioStatistics.txCnt--;
+                q->iv->radio->mRadioWaitTime.stopTimeMonitor();
+            }
+            while(!q->iv->radio->mBufCtrl.empty())
+                q->iv->radio->mBufCtrl.pop();
+
+            if(*mSerialDebug) {
+                DPRINT_IVID(DBG_INFO, q->iv->id);
+                DBGPRINTLN(F("request preempted by power limit"));
+            }
+            mPreemptCnt++;
+            q->preempted = true;
+            add(q, true);
+            mCur->isRetransmit  = false;
+            mCur->completeRetry = false;
+            mCur->state         = States::IDLE;
+        }
+
         void closeRequest(QueueElement *q, bool crcPass) {
             mHeu.evalTxChQuality(q->iv, crcPass, (q->attemptsMax - 1 - q->attempts), q->iv->curFrmCnt);
             if(crcPass)
                 q->iv->radioStatistics.rxSuccess++;
-            else if(q->iv->mGotFragment || mCompleteRetry)
+            else if(q->iv->mGotFragment || mCur->completeRetry)
                 q->iv->radioStatistics.rxFail++; // got no complete payload
             else
                 q->iv->radioStatistics.rxFailNoAnswer++; // got nothing
-            mWaitTime.startTimeMonitor(1); // maybe remove, side effects unknown
+            mCur->waitTime.startTimeMonitor(1); // maybe remove, side effects unknown
 
             bool keep = false;
             if(q->isDevControl)
@@ -647,9 +727,9 @@ class Communication : public CommQueue<> {
             if(keep)
                 cmdReset(q); // q will be zero'ed after that command
 
-            mIsRetransmit       = false;
-            mCompleteRetry      = false;
-            mState              = States::IDLE;
+            mCur->isRetransmit  = false;
+            mCur->completeRetry = false;
+            mCur->state         = States::IDLE;
             DBGPRINTLN(F("-----"));
         }
 
@@ -796,7 +876,7 @@ class Communication : public CommQueue<> {
         inline void miDataDecode(packet_t *p, QueueElement *q) {
             record_t<> *rec = q->iv->getRecordStruct(RealTimeRunData_Debug);  // choose the parser
             rec->ts = q->ts;
-            //mState = States::IDLE;
+            //mCur->state = States::IDLE;
             if(q->iv->miMultiParts < 6)
                 q->iv->miMultiParts += 6;
 
@@ -851,8 +931,8 @@ class Communication : public CommQueue<> {
             mHeu.getTxCh(q->iv);
             q->iv->radioStatistics.ivSent++;
 
-            mFramesExpected = getFramesExpected(q);
-            q->iv->radio->setExpectedFrames(mFramesExpected);
+            mCur->framesExpected = getFramesExpected(q);
+            q->iv->radio->setExpectedFrames(mCur->framesExpected);
             q->iv->radio->sendCmdPacket(q->iv, cmd, 0x00, true);
 
             q->iv->radio->mRadioWaitTime.startTimeMonitor(DURATION_TXFRAME + DURATION_ONEFRAME + duration_reserve[q->iv->ivRadioType]);
@@ -865,9 +945,9 @@ class Communication : public CommQueue<> {
                 DBGPRINT(F(" attempts left): 0x"));
                 DBGHEXLN(cmd);
             }
-            mIsRetransmit = true;
+            mCur->isRetransmit = true;
             q->changeCmd(cmd);
-            //mState = States::WAIT;
+            //mCur->state = States::WAIT;
         }
 
         void miRepeatRequest(QueueElement *q) {
@@ -882,7 +962,7 @@ class Communication : public CommQueue<> {
                 DBGPRINT(F(" attempts left): 0x"));
                 DBGHEXLN(q->cmd);
             }
-            //mIsRetransmit = false;
+            //mCur->isRetransmit = false;
         }
 
         void miStsConsolidate(QueueElement *q, uint8_t stschan,  record_t<> *rec, uint8_t uState, uint8_t uEnum, uint8_t lState = 0, uint8_t lEnum = 0) {
@@ -908,7 +988,7 @@ class Communication : public CommQueue<> {
             uint16_t prntsts = (statusMi == 3) ? 1 : statusMi;
             bool stsok = true;
             bool changedStatus = false;  //if true, raise alarms and send via mqtt (might affect single channel only)
-            uint8_t oldState = rec->record[q->iv->getPosByChFld(0, FLD_EVT, rec)];
+            uint8_t oldState = q->iv->getChannelFieldValue(0, FLD_EVT, rec);
             if ( prntsts != oldState ) { // sth.'s changed?
                 stsok = false;
                 if( (!oldState) || (!q->iv->alarmCnt) ) {          // initial zero value? => just write this channel to main state and raise changed flags
@@ -963,8 +1043,8 @@ class Communication : public CommQueue<> {
                 }
             }
 
-            if (q->iv->alarmMesIndex < rec->record[q->iv->getPosByChFld(0, FLD_EVT, rec)]) {
-                q->iv->alarmMesIndex = rec->record[q->iv->getPosByChFld(0, FLD_EVT, rec)]; // seems there's no status per channel in 3rd gen. models?!?
+            if (q->iv->alarmMesIndex < q->iv->getChannelFieldValue(0, FLD_EVT, rec)) {
+                q->iv->alarmMesIndex = q->iv->getChannelFieldValue(0, FLD_EVT, rec); // seems there's no status per channel in 3rd gen. models?!?
                 if (*mSerialDebug) {
                     DPRINT_IVID(DBG_INFO, q->iv->id);
                     DBGPRINT(F("alarm ID incremented to "));
@@ -1036,25 +1116,48 @@ class Communication : public CommQueue<> {
         typedef struct {
             uint8_t buf[MAX_RF_PAYLOAD_SIZE];
             uint8_t len;
-            int8_t rssi;
         } frame_t;
 
+        // state of the request in progress, one per radio
+        typedef struct {
+            States state = States::IDLE;
+            QueueElement el;
+            TimeMonitor waitTime = TimeMonitor(0, true);  // start as expired (due to code in RESET state)
+            std::array<frame_t, MAX_PAYLOAD_ENTRIES> localBuf; // fragments received out of order
+            bool firstTry = false;      // see, if we should do a second try
+            bool completeRetry = false; // remember if we did request a complete retransmission
+            bool isRetransmit = false;  // we already had waited one complete cycle
+            uint8_t maxFrameId = 0;
+            uint8_t framesExpected = 12; // 0x8c was highest last frame for alarm data
+            uint16_t timeout = 0;       // calculating that once should be ok
+            std::array<uint8_t, MAX_BUFFER> payload;
+            uint8_t payloadLen = 0;     // in order received bytes in payload
+            uint8_t nextFrame = 0;      // index of the next in order fragment
+            uint32_t frameRcvd = 0;     // bit per received fragment
+            bool payloadOverflow = false;
+            int8_t rssi = -127;
+            ah::Crc16 crc;
+            uint16_t crcRcv = 0x0000;
+        } slot_t;
+
+        // slot 0 serves the nRF24 inverters, slot 1 the CMT2300A inverters
+        static inline uint8_t getSlotRadioType(uint8_t slot) {
+            #if (COMM_RADIO_SLOTS > 1)
+            return (0 == slot) ? INV_RADIO_TYPE_NRF : INV_RADIO_TYPE_CMT;
+            #else
+            return INV_RADIO_TYPE_UNKNOWN; // any
+            #endif
+        }
+
     private:
-        States mState = States::IDLE;
         uint32_t *mTimestamp = nullptr;
-        QueueElement el;
         bool *mPrivacyMode = nullptr, *mSerialDebug = nullptr, *mPrintWholeTrace = nullptr;
-        TimeMonitor mWaitTime = TimeMonitor(0, true);  // start as expired (due to code in RESET state)
-        std::array<frame_t, MAX_PAYLOAD_ENTRIES> mLocalBuf;
-        bool mFirstTry = false;      // see, if we should do a second try
-        bool mCompleteRetry = false; // remember if we did request a complete retransmission
-        bool mIsRetransmit = false;  // we already had waited one complete cycle
-        uint8_t mMaxFrameId = 0;
-        uint8_t mFramesExpected = 12; // 0x8c was highest last frame for alarm data
-        uint16_t mTimeout = 0;       // calculating that once should be ok
-        std::array<uint8_t, MAX_BUFFER> mPayload;
+        std::array<slot_t, COMM_RADIO_SLOTS> mSlot;
+        slot_t *mCur = &mSlot[0];
         payloadListenerType mCbPayload = NULL;
         powerLimitAckListenerType mCbPwrAck = NULL;
+        const bool *mLimitFastPath = nullptr;
+        uint32_t mPreemptCnt = 0;
         alarmListenerType mCbAlarm = NULL;
         Heuristic mHeu;
         uint32_t mLastEmptyQueueMillis = 0;
@@ -6,6 +6,7 @@
 #ifndef __HEURISTIC_H__
 #define __HEURISTIC_H__
 
+#include <cmath>
 #include "../utils/dbg.h"
 #include "hmInverter.h"
 #include "HeuristicInv.h"
@@ -20,13 +21,41 @@
 #define RF_TX_CHAN_QUALITY_LOW          -1
 #define RF_TX_CHAN_QUALITY_BAD          -2
 
+#define RF_UCB_DISCOUNT                 0.99f   // decay of the statistics per evaluation
+#define RF_UCB_EXPLORE                  0.1f    // weight of the confidence bound
+#define RF_UCB_RETRANSMIT_COST          0.15f   // reward reduction per retransmitted frame
+#define RF_UCB_MIN_TRIES                0.05f   // channels below are tried first
+#define RF_UCB_GOOD_REWARD              0.6f    // average reward which is shown as RF_MAX_QUALITY
+#define RF_RX_OFS_DISCOUNT              0.95f   // decay of the RX offset counters per fragment
+
+//-----------------------------------------------------------------------------
+// TX channel selection of nRF inverters. RF_CH_SEL_QUALITY is the classic
+// heuristic: a clamped quality per channel and test periods for the others.
+// RF_CH_SEL_UCB treats the channels as bandit arms: every evaluation gives a
+// reward (1 for a complete payload minus the retransmits, a bit for single
+// fragments), the statistics decay so changes of the RF environment are
+// followed, and the channel with the highest upper confidence bound is used.
+// It also learns the offset between TX and RX channel from the received
+// fragments.
+//-----------------------------------------------------------------------------
 class Heuristic {
     public:
+        // 'mode' is read on every call, changes are used immediately
+        void setup(const uint8_t *mode) {
+            mMode = mode;
+        }
+
         uint8_t getTxCh(Inverter<> *iv) {
             if(iv->ivRadioType != INV_RADIO_TYPE_NRF)
                 return 0; // not used for other than nRF inverter types
 
             HeuristicInv *ih = &iv->heuristics;
+            if(isUcb()) {
+                ih->lastBestTxChId = ih->txRfChId;
+                ih->txRfChId = getUcbTxChId(ih);
+                iv->radio->mTxRetriesNext = getIvRetries(iv);
+                return id2Ch(ih->txRfChId);
+            }
 
             // start with the next index: round robbin in case of same 'best' quality
             uint8_t curId = (ih->txRfChId + 1) % RF_MAX_CHANNEL_ID;
@@ -75,6 +104,18 @@ class Heuristic {
 
         void evalTxChQuality(Inverter<> *iv, bool crcPass, uint8_t retransmits, uint8_t rxFragments, bool quotaMissed = false) {
             HeuristicInv *ih = &iv->heuristics;
+            if(isUcb()) {
+                float reward = 0;
+                if(crcPass)
+                    reward = 1.0f - RF_UCB_RETRANSMIT_COST * std::min(retransmits, (uint8_t)5);
+                else if(quotaMissed)
+                    reward = (rxFragments > 1) ? 0.3f : 0.1f;
+                else if(rxFragments > ih->lastRxFragments)
+                    reward = 0.2f;
+                updateUcb(ih, reward);
+                ih->lastRxFragments = rxFragments;
+                return;
+            }
 
             #if (DBG_DEBUG == DEBUG_LEVEL)
             DPRINT(DBG_DEBUG, "eval ");
@@ -136,6 +177,30 @@ class Heuristic {
             ih->lastRxFragments = rxFragments;
         }
 
+        // RX channel of a fragment of the inverter, learns the offset to the TX channel
+        void addRxCh(Inverter<> *iv, uint8_t rxCh) {
+            if((iv->ivRadioType != INV_RADIO_TYPE_NRF) || !isUcb())
+                return;
+
+            uint8_t rxId = 0;
+            while((rxId < RF_MAX_CHANNEL_ID) && (mChList[rxId] != rxCh))
+                rxId++;
+            if(RF_MAX_CHANNEL_ID == rxId)
+                return;
+
+            HeuristicInv *ih = &iv->heuristics;
+            uint8_t best = 0;
+            for(uint8_t i = 0; i < RF_MAX_CHANNEL_ID; i++) {
+                ih->rxOfsCnt[i] *= RF_RX_OFS_DISCOUNT;
+                if(i == ((rxId + RF_MAX_CHANNEL_ID - ih->txRfChId) % RF_MAX_CHANNEL_ID))
+                    ih->rxOfsCnt[i] += 1.0f;
+                if(ih->rxOfsCnt[i] > ih->rxOfsCnt[best])
+                    best = i;
+            }
+            if(ih->rxOfsCnt[best] >= RF_RX_OFS_MIN_CNT)
+                ih->rxOffset = best;
+        }
+
         void printStatus(const Inverter<> *iv) {
             DPRINT_IVID(DBG_INFO, iv->id);
             DBGPRINT(F("Radio infos:"));
@@ -204,6 +269,44 @@ class Heuristic {
         }
 
     private:
+        inline bool isUcb(void) const {
+            return (nullptr != mMode) && (RF_CH_SEL_UCB == *mMode);
+        }
+
+        uint8_t getUcbTxChId(const HeuristicInv *ih) const {
+            float total = 0;
+            for(uint8_t i = 0; i < RF_MAX_CHANNEL_ID; i++) {
+                if(ih->chTries[i] < RF_UCB_MIN_TRIES)
+                    return i; // (almost) unknown channel
+                total += ih->chTries[i];
+            }
+
+            uint8_t best = ih->txRfChId;
+            float bestScore = -1.0f;
+            float logTotal = logf(total + 1.0f);
+            for(uint8_t i = 0; i < RF_MAX_CHANNEL_ID; i++) {
+                float score = (ih->chReward[i] / ih->chTries[i]) + RF_UCB_EXPLORE * sqrtf(logTotal / ih->chTries[i]);
+                if(score > bestScore) {
+                    bestScore = score;
+                    best = i;
+                }
+            }
+            return best;
+        }
+
+        void updateUcb(HeuristicInv *ih, float reward) {
+            for(uint8_t i = 0; i < RF_MAX_CHANNEL_ID; i++) {
+                ih->chReward[i] *= RF_UCB_DISCOUNT;
+                ih->chTries[i]  *= RF_UCB_DISCOUNT;
+            }
+            ih->chReward[ih->txRfChId] += reward;
+            ih->chTries[ih->txRfChId]  += 1.0f;
+
+            // average reward as quality (debug output, isTxAtMax())
+            float avg = std::min(ih->chReward[ih->txRfChId] / ih->chTries[ih->txRfChId] / RF_UCB_GOOD_REWARD, 1.0f);
+            ih->txRfQuality[ih->txRfChId] = RF_MIN_QUALTIY + (int8_t)lroundf(avg * (RF_MAX_QUALITY - RF_MIN_QUALTIY));
+        }
+
         bool isNewTxCh(const HeuristicInv *ih) const {
             return ih->txRfChId != ih->lastBestTxChId;
         }
@@ -223,6 +326,7 @@ class Heuristic {
                 return 3; // standard
         }
         uint8_t mChList[RF_MAX_CHANNEL_ID] = {03, 23, 40, 61, 75};
+        const uint8_t *mMode = nullptr;
 };
 
 
@@ -6,10 +6,20 @@
 #ifndef __HEURISTIC_INV_H__
 #define __HEURISTIC_INV_H__
 
+#include <cmath>
+#include <cstring>
+
 #define RF_MAX_CHANNEL_ID   5
 #define RF_MAX_QUALITY      4
 #define RF_MIN_QUALTIY      -6
 #define RF_NA               -99
+#define RF_RX_OFFSET_NA     0xff
+#define RF_RX_OFS_MIN_CNT   3.0f    // fragments needed before the learned RX offset is used
+#define RF_DECAY_OFF        0.5f    // fading of the learned values if the inverter goes off
+
+// channel selection
+#define RF_CH_SEL_QUALITY   0       // clamped quality with test periods
+#define RF_CH_SEL_UCB       1       // discounted upper confidence bound, learns the RX offset
 
 class HeuristicInv {
     public:
@@ -31,6 +41,34 @@ class HeuristicInv {
             rxSpeeds[1]   = false;
             rxSpeedCnt[0] = 0;
             rxSpeedCnt[1] = 0;
+
+            for(uint8_t i = 0; i < RF_MAX_CHANNEL_ID; i++) {
+                chReward[i] = 0;
+                chTries[i]  = 0;
+                rxOfsCnt[i] = 0;
+            }
+            rxOffset = RF_RX_OFFSET_NA;
+        }
+
+        // fades the learned values by 'factor' (0..1), the channel test is restarted
+        void decay(float factor) {
+            for(uint8_t i = 0; i < RF_MAX_CHANNEL_ID; i++) {
+                txRfQuality[i] = (int8_t)lroundf(txRfQuality[i] * factor);
+                chReward[i]   *= factor;
+                chTries[i]    *= factor;
+                rxOfsCnt[i]   *= factor;
+            }
+            testPeriodSendCnt  = 0;
+            testPeriodFailCnt  = 0;
+            testChId           = txRfChId;
+            saveOldTestQuality = -6;
+            lastRxFragments    = 0;
+
+            rxSpeedCnt[0] = (uint8_t)(rxSpeedCnt[0] * factor);
+            rxSpeedCnt[1] = (uint8_t)(rxSpeedCnt[1] * factor);
+
+            if((RF_RX_OFFSET_NA != rxOffset) && (rxOfsCnt[rxOffset] < RF_RX_OFS_MIN_CNT))
+                rxOffset = RF_RX_OFFSET_NA;
         }
 
         bool isTxAtMax(void) const {
@@ -49,6 +87,12 @@ class HeuristicInv {
         uint8_t lastRxFragments    = 0;
         bool    rxSpeeds[2]        = {false, false}; // is inverter responding very fast respective fast?
         uint8_t rxSpeedCnt[2]      = {0, 0};         // count how many messages had been received very fast respective fast (10 max)
+
+        // UCB channel selection (check 'Heuristic.h'), all values decay with every update
+        float   chReward[RF_MAX_CHANNEL_ID];            // sum of rewards per TX channel id
+        float   chTries[RF_MAX_CHANNEL_ID];             // number of evaluations per TX channel id
+        float   rxOfsCnt[RF_MAX_CHANNEL_ID];            // received fragments per offset between TX and RX channel id
+        uint8_t rxOffset = RF_RX_OFFSET_NA;             // learned RX channel offset, RF_RX_OFFSET_NA: default of the inverter generation
 };
 
 #endif /*__HEURISTIC_INV_H__*/
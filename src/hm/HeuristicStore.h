@@ -0,0 +1,181 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __HEURISTIC_STORE_H__
+#define __HEURISTIC_STORE_H__
+
+#include <cmath>
+#include <cstring>
+#include <LittleFS.h>
+#include "../utils/dbg.h"
+#include "hmInverter.h"
+
+#define HEU_STORE_FILE          "/heuristics.bin"
+#define HEU_STORE_VERSION       1
+#define HEU_STORE_HALF_LIFE     (3 * 86400)     // [s] the learned values are halved after this age
+#define HEU_STORE_MAX_AGE       (14 * 86400)    // [s] older values are dropped
+
+typedef struct {
+    uint8_t  version;
+    uint8_t  cnt;           // number of records
+    uint8_t  reserved[2];
+    uint32_t ts;            // time of saving (UTC)
+} heuStoreHdr_t;
+
+typedef struct {
+    uint64_t serial;
+    uint8_t  radioType;
+    uint8_t  cmtFreq;       // current CMT frequency (curCmtFreq)
+    int8_t   txRfQuality[RF_MAX_CHANNEL_ID];
+    uint8_t  txRfChId;
+    uint8_t  rxSpeeds;      // bit 0: very fast, bit 1: fast
+    uint8_t  rxSpeedCnt[2];
+    uint8_t  rxOffset;
+    float    chReward[RF_MAX_CHANNEL_ID];
+    float    chTries[RF_MAX_CHANNEL_ID];
+    float    rxOfsCnt[RF_MAX_CHANNEL_ID];
+} heuStoreRec_t;
+
+//-----------------------------------------------------------------------------
+// Keeps the learned radio values of the inverters (HeuristicInv and the
+// current CMT frequency) in the file system. The file is a header followed by
+// one fixed record per inverter, the records are matched by serial number. On
+// load the values fade with the age of the file. The CMT frequency is restored
+// regardless of the age, it is the frequency the inverter is tuned to.
+// Inverters which already sent something since boot keep their values.
+//-----------------------------------------------------------------------------
+template<class HMSYSTEM>
+class HeuristicStore {
+    public:
+        // 'ts' has to be a valid UTC timestamp
+        void load(HMSYSTEM *sys, uint32_t ts) {
+            mLoaded = true;
+            File fp = LittleFS.open(HEU_STORE_FILE, "r");
+            if(!fp)
+                return;
+
+            heuStoreHdr_t hdr;
+            if((sizeof(hdr) != fp.read(reinterpret_cast<uint8_t*>(&hdr), sizeof(hdr))) || (HEU_STORE_VERSION != hdr.version)) {
+                DPRINTLN(DBG_WARN, F("heuristics: invalid file"));
+                fp.close();
+                return;
+            }
+
+            bool valid = (hdr.ts <= ts) && ((ts - hdr.ts) < HEU_STORE_MAX_AGE);
+            float factor = valid ? powf(0.5f, (float)(ts - hdr.ts) / HEU_STORE_HALF_LIFE) : 0.0f;
+
+            uint8_t cnt = 0;
+            heuStoreRec_t rec;
+            for(uint8_t i = 0; i < hdr.cnt; i++) {
+                if(sizeof(rec) != fp.read(reinterpret_cast<uint8_t*>(&rec), sizeof(rec)))
+                    break;
+                Inverter<> *iv = getBySerial(sys, rec.serial);
+                if((nullptr == iv) || (iv->ivRadioType != rec.radioType) || (0 != iv->radioStatistics.txCnt))
+                    continue;
+
+                if(INV_RADIO_TYPE_CMT == iv->ivRadioType) {
+                    if(0 != rec.cmtFreq)
+                        iv->curCmtFreq = rec.cmtFreq;
+                    continue;
+                }
+                if(!valid)
+                    continue;
+
+                HeuristicInv *ih = &iv->heuristics;
+                memcpy(ih->txRfQuality, rec.txRfQuality, RF_MAX_CHANNEL_ID);
+                memcpy(ih->chReward, rec.chReward, sizeof(rec.chReward));
+                memcpy(ih->chTries, rec.chTries, sizeof(rec.chTries));
+                memcpy(ih->rxOfsCnt, rec.rxOfsCnt, sizeof(rec.rxOfsCnt));
+                ih->txRfChId      = rec.txRfChId % RF_MAX_CHANNEL_ID;
+                ih->rxSpeeds[0]   = (rec.rxSpeeds & 0x01);
+                ih->rxSpeeds[1]   = (rec.rxSpeeds & 0x02);
+                ih->rxSpeedCnt[0] = rec.rxSpeedCnt[0];
+                ih->rxSpeedCnt[1] = rec.rxSpeedCnt[1];
+                ih->rxOffset      = (rec.rxOffset < RF_MAX_CHANNEL_ID) ? rec.rxOffset : RF_RX_OFFSET_NA;
+                ih->decay(factor);
+                cnt++;
+            }
+            fp.close();
+
+            DPRINT(DBG_INFO, F("heuristics: loaded "));
+            DBGPRINT(String(cnt));
+            DBGPRINT(F(" inverter(s), age "));
+            DBGPRINT(String((hdr.ts <= ts) ? ((ts - hdr.ts) / 3600) : 0));
+            DBGPRINTLN(F("h"));
+        }
+
+        // nothing is saved before the stored values were loaded
+        bool save(HMSYSTEM *sys, uint32_t ts) {
+            if(!mLoaded || (0 == ts))
+                return false;
+
+            File fp = LittleFS.open(HEU_STORE_FILE, "w");
+            if(!fp) {
+                DPRINTLN(DBG_ERROR, F("heuristics: can't open file!"));
+                return false;
+            }
+
+            heuStoreHdr_t hdr;
+            memset(&hdr, 0, sizeof(hdr));
+            hdr.version = HEU_STORE_VERSION;
+            hdr.ts      = ts;
+            for(uint8_t id = 0; id < sys->getNumInverters(); id++) {
+                if(nullptr != sys->getInverterByPos(id))
+                    hdr.cnt++;
+            }
+            bool ok = (sizeof(hdr) == fp.write(reinterpret_cast<uint8_t*>(&hdr), sizeof(hdr)));
+
+            heuStoreRec_t rec;
+            for(uint8_t id = 0; (id < sys->getNumInverters()) && ok; id++) {
+                Inverter<> *iv = sys->getInverterByPos(id);
+                if(nullptr == iv)
+                    continue;
+
+                const HeuristicInv *ih = &iv->heuristics;
+                memset(&rec, 0, sizeof(rec));
+                rec.serial    = iv->config->serial.u64;
+                rec.radioType = iv->ivRadioType;
+                rec.cmtFreq   = iv->curCmtFreq;
+                memcpy(rec.txRfQuality, ih->txRfQuality, RF_MAX_CHANNEL_ID);
+                memcpy(rec.chReward, ih->chReward, sizeof(rec.chReward));
+                memcpy(rec.chTries, ih->chTries, sizeof(rec.chTries));
+                memcpy(rec.rxOfsCnt, ih->rxOfsCnt, sizeof(rec.rxOfsCnt));
+                rec.txRfChId      = ih->txRfChId;
+                rec.rxSpeeds      = (ih->rxSpeeds[0] ? 0x01 : 0) | (ih->rxSpeeds[1] ? 0x02 : 0);
+                rec.rxSpeedCnt[0] = ih->rxSpeedCnt[0];
+                rec.rxSpeedCnt[1] = ih->rxSpeedCnt[1];
+                rec.rxOffset      = ih->rxOffset;
+                ok = (sizeof(rec) == fp.write(reinterpret_cast<uint8_t*>(&rec), sizeof(rec)));
+            }
+            fp.close();
+
+            if(ok)
+                DPRINTLN(DBG_INFO, F("heuristics saved"));
+            else
+                DPRINTLN(DBG_ERROR, F("heuristics: can't write file!"));
+            return ok;
+        }
+
+        bool isLoaded(void) const {
+            return mLoaded;
+        }
+
+    private:
+        Inverter<> *getBySerial(HMSYSTEM *sys, uint64_t serial) {
+            if(0ULL == serial)
+                return nullptr;
+            for(uint8_t id = 0; id < sys->getNumInverters(); id++) {
+                Inverter<> *iv = sys->getInverterByPos(id);
+                if((nullptr != iv) && (iv->config->serial.u64 == serial))
+                    return iv;
+            }
+            return nullptr;
+        }
+
+    private:
+        bool mLoaded = false;
+};
+
+#endif /*__HEURISTIC_STORE_H__*/
@@ -147,7 +147,7 @@ class NrfRadio : public Radio {
                 // here we got news from the nRF
                 mIrqRcvd     = false;
                 mNrf24->whatHappened(tx_ok, tx_fail, rx_ready); // resets the IRQ pin to HIGH
-                mLastIrqTime = millis();
+                mLastIrqTime = mIrqMillis;
 
                 if(tx_ok || tx_fail) { // tx related interrupt, basically we should start listening
                     mNrf24->flush_tx();                         // empty TX FIFO
@@ -162,7 +162,10 @@ class NrfRadio : public Radio {
                     if(tx_ok)
                         mLastIv->mAckCount++;
 
-                    rxOffset = mLastIv->ivGen == IV_HM ? 3 : 2;          // holds the default channel offset between tx and rx channel (nRF only)
+                    if((RF_CH_SEL_UCB == mCfg->chSelect) && (RF_RX_OFFSET_NA != mLastIv->heuristics.rxOffset))
+                        rxOffset = mLastIv->heuristics.rxOffset;          // learned by the UCB channel selection
+                    else
+                        rxOffset = mLastIv->ivGen == IV_HM ? 3 : 2;      // holds the default channel offset between tx and rx channel (nRF only)
                     mRxChIdx = (mTxChIdx + rxOffset) % RF_CHANNELS;
                     mNrf24->setChannel(mRfChLst[mRxChIdx]);
                     mNrf24->startListening();
@@ -223,7 +226,7 @@ class NrfRadio : public Radio {
                     mTxBuf[cnt++] = (data[1]     ) & 0xff; // setting for persistens handling
                 }
             } else { //MI 2nd gen. specific
-                uint16_t powerMax = ((iv->powerLimit[1] == RelativNonPersistent) ? 0 : iv->getMaxPower());
+                uint16_t powerMax = ((data[1] == RelativNonPersistent) ? 0 : iv->getMaxPower());
                 switch (cmd) {
                     case Restart:
                     case TurnOn:
@@ -314,37 +317,39 @@ class NrfRadio : public Radio {
                 uint8_t len = mNrf24->getDynamicPayloadSize(); // payload size > 32 -> corrupt payload
 
                 if (len > 0) {
-                    packet_t p;
-                    p.ch   = mRfChLst[tempRxChIdx];
-                    p.len  = (len > MAX_RF_PAYLOAD_SIZE) ? MAX_RF_PAYLOAD_SIZE : len;
-                    p.rssi = mNrf24->testRPD() ? -64 : -75;
-                    p.millis = millis() - mMillis;
-                    mNrf24->read(p.packet, p.len);
-
-                    if (p.packet[0] != 0x00) {
-                        if(!checkIvSerial(p.packet, mLastIv)) {
+                    packet_t *p = mBufCtrl.reserve(); // filled in place
+                    p->ch   = mRfChLst[tempRxChIdx];
+                    p->len  = (len > MAX_RF_PAYLOAD_SIZE) ? MAX_RF_PAYLOAD_SIZE : len;
+                    p->rssi = mNrf24->testRPD() ? -64 : -75;
+                    p->millis = getRxMillis();
+                    mNrf24->read(p->packet, p->len);
+
+                    if (p->packet[0] != 0x00) {
+                        if(!checkIvSerial(p->packet, mLastIv)) {
                             DPRINT(DBG_WARN, F("RX other inverter "));
                             if(!*mPrivacyMode)
-                                ah::dumpBuf(p.packet, p.len);
+                                ah::dumpBuf(p->packet, p->len);
                             else
                                 DBGPRINTLN(F(""));
                         } else {
                             mLastIv->mGotFragment = true;
-                            mBufCtrl.push(p);
+                            traceRx(p);
+                            if(!mBufCtrl.commit())
+                                DPRINTLN(DBG_WARN, F("RX buffer full"));
 
-                            if (p.packet[0] == (TX_REQ_INFO + ALL_FRAMES)) {  // response from get information command
-                                isLastPackage = (p.packet[9] > ALL_FRAMES); // > ALL_FRAMES indicates last packet received
+                            if (p->packet[0] == (TX_REQ_INFO + ALL_FRAMES)) {  // response from get information command
+                                isLastPackage = (p->packet[9] > ALL_FRAMES); // > ALL_FRAMES indicates last packet received
                                 if(mLastIv->mIsSingleframeReq)                  // we only expect one frame here...
                                     isRetransmitAnswer = true;
 
                                 if(isLastPackage)
-                                    setExpectedFrames(p.packet[9] - ALL_FRAMES);
+                                    setExpectedFrames(p->packet[9] - ALL_FRAMES);
                             }
 
                             if(IV_MI == mLastIv->ivGen) {
-                                if (p.packet[0] == (0x0f + ALL_FRAMES))                  // response from MI get information command
-                                    isLastPackage = (p.packet[9] > 0x10);                // > 0x10 indicates last packet received
-                                else if ((p.packet[0] != 0x88) && (p.packet[0] != 0x92)) // ignore MI status messages //#0 was p.packet[0] != 0x00 &&
+                                if (p->packet[0] == (0x0f + ALL_FRAMES))                  // response from MI get information command
+                                    isLastPackage = (p->packet[9] > 0x10);                // > 0x10 indicates last packet received
+                                else if ((p->packet[0] != 0x88) && (p->packet[0] != 0x92)) // ignore MI status messages //#0 was p->packet[0] != 0x00 &&
                                     isLastPackage = true;                                // response from dev control command
                             }
                             rx_ready = true; //reset in case we first read messages from other inverter or ACK zero payloads
@@ -404,6 +409,7 @@ class NrfRadio : public Radio {
             }
             mNrf24->setChannel(mRfChLst[mTxChIdx]);
             mNrf24->openWritingPipe(reinterpret_cast<uint8_t*>(&iv->radioId.u64));
+            traceTx(len, mRfChLst[mTxChIdx]);
             mNrf24->startFastWrite(mTxBuf.data(), len, false, true); // false (3) = request ACK response; true (4) reset CE to high after transmission
             mMillis = millis();
 
@@ -435,7 +441,6 @@ class NrfRadio : public Radio {
         uint8_t mRxChIdx = 0;
         uint8_t tempRxChIdx = 0;
         bool    mGotLastMsg = false;
-        uint32_t mMillis = 0;
         bool tx_ok = false, tx_fail = false, rx_ready = false;
         unsigned long mTimeslotStart = 0;
         unsigned long mLastIrqTime = 0;
@@ -0,0 +1,17 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __PACKET_RING_H__
+#define __PACKET_RING_H__
+
+#include "../defines.h"
+#include "../utils/spscRing.h"
+
+// received frames of one radio: filled in place by the radio, consumed by
+// reference by Communication
+template<uint8_t N>
+using PacketRing = SpscRing<packet_t, N>;
+
+#endif /*__PACKET_RING_H__*/
@@ -0,0 +1,171 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __PACKET_TRACE_H__
+#define __PACKET_TRACE_H__
+
+#if defined(ENABLE_PACKET_TRACE)
+
+#include <algorithm>
+#include <Arduino.h>
+#include "../defines.h"
+
+#ifndef PACKET_TRACE_SIZE
+#define PACKET_TRACE_SIZE       128 // number of RX / TX frames kept in the ring
+#endif
+
+#define PACKET_TRACE_VERSION    1
+#define PACKET_TRACE_HDR_LEN    8
+#define PACKET_TRACE_ENTRY_LEN  (10 + MAX_RF_PAYLOAD_SIZE)
+
+//-----------------------------------------------------------------------------
+// ring buffer of the last RX and TX frames of all radios. The dump format is
+// little endian:
+//   header:  'A' 'H' 'T' 'R', version, number of inverters, number of entries (u16)
+//   serials: u64 per inverter
+//   entries: ms (u32), rx millis (u16), dir, ch, rssi, len, packet[MAX_RF_PAYLOAD_SIZE]
+//-----------------------------------------------------------------------------
+class PacketTrace {
+    public:
+        enum class Dir : uint8_t {
+            RX = 0,
+            TX
+        };
+
+        typedef struct {
+            uint32_t ms;        // millis() at capture
+            uint16_t rxMillis;  // RX only: time since the last TX (packet_t::millis)
+            Dir dir;
+            uint8_t ch;
+            int8_t rssi;
+            uint8_t len;
+            uint8_t packet[MAX_RF_PAYLOAD_SIZE];
+        } entry_t;
+
+    public:
+        void addRx(const packet_t *p) {
+            entry_t *e = next();
+            e->dir      = Dir::RX;
+            e->ch       = p->ch;
+            e->rssi     = p->rssi;
+            e->rxMillis = p->millis;
+            copy(e, p->packet, p->len);
+        }
+
+        void addTx(const uint8_t buf[], uint8_t len, uint8_t ch) {
+            entry_t *e = next();
+            e->dir      = Dir::TX;
+            e->ch       = ch;
+            e->rssi     = 0;
+            e->rxMillis = 0;
+            copy(e, buf, len);
+        }
+
+        void clear(void) {
+            mWr  = 0;
+            mCnt = 0;
+        }
+
+        uint16_t getCount(void) const {
+            return mCnt;
+        }
+
+        // index 0 is the oldest entry
+        const entry_t *get(uint16_t i) const {
+            if(i >= mCnt)
+                return nullptr;
+            return &mEntries[(mWr + PACKET_TRACE_SIZE - mCnt + i) % PACKET_TRACE_SIZE];
+        }
+
+        size_t getDumpSize(uint8_t numIv) const {
+            return PACKET_TRACE_HDR_LEN + numIv * 8 + mCnt * PACKET_TRACE_ENTRY_LEN;
+        }
+
+        // writes a snapshot of the ring, 'buf' must hold getDumpSize() bytes
+        size_t dump(uint8_t buf[], const uint64_t serial[], uint8_t numIv) const {
+            uint8_t *b = buf;
+            *b++ = 'A'; *b++ = 'H'; *b++ = 'T'; *b++ = 'R';
+            *b++ = PACKET_TRACE_VERSION;
+            *b++ = numIv;
+            *b++ = (mCnt     ) & 0xff;
+            *b++ = (mCnt >> 8) & 0xff;
+            for(uint8_t i = 0; i < numIv; i++) {
+                for(uint8_t j = 0; j < 8; j++)
+                    *b++ = (serial[i] >> (j * 8)) & 0xff;
+            }
+
+            for(uint16_t i = 0; i < mCnt; i++) {
+                const entry_t *e = get(i);
+                b[0] = (e->ms      ) & 0xff;
+                b[1] = (e->ms >>  8) & 0xff;
+                b[2] = (e->ms >> 16) & 0xff;
+                b[3] = (e->ms >> 24) & 0xff;
+                b[4] = (e->rxMillis     ) & 0xff;
+                b[5] = (e->rxMillis >> 8) & 0xff;
+                b[6] = static_cast<uint8_t>(e->dir);
+                b[7] = e->ch;
+                b[8] = static_cast<uint8_t>(e->rssi);
+                b[9] = e->len;
+                memcpy(&b[10], e->packet, MAX_RF_PAYLOAD_SIZE);
+                b += PACKET_TRACE_ENTRY_LEN;
+            }
+            return b - buf;
+        }
+
+        // checks a dump, returns false if it is not a (complete) trace
+        static bool parseHeader(const uint8_t buf[], size_t len, uint8_t *numIv, uint16_t *cnt) {
+            if(len < PACKET_TRACE_HDR_LEN)
+                return false;
+            if((0 != memcmp(buf, "AHTR", 4)) || (PACKET_TRACE_VERSION != buf[4]))
+                return false;
+            *numIv = buf[5];
+            *cnt   = buf[6] | (buf[7] << 8);
+            return (len >= (size_t)(PACKET_TRACE_HDR_LEN + *numIv * 8 + *cnt * PACKET_TRACE_ENTRY_LEN));
+        }
+
+        static uint64_t parseSerial(const uint8_t buf[], uint8_t i) {
+            uint64_t serial = 0;
+            const uint8_t *b = &buf[PACKET_TRACE_HDR_LEN + i * 8];
+            for(uint8_t j = 0; j < 8; j++)
+                serial |= (uint64_t)b[j] << (j * 8);
+            return serial;
+        }
+
+        static void parseEntry(const uint8_t buf[], uint8_t numIv, uint16_t i, entry_t *e) {
+            const uint8_t *b = &buf[PACKET_TRACE_HDR_LEN + numIv * 8 + i * PACKET_TRACE_ENTRY_LEN];
+            e->ms       = b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+            e->rxMillis = b[4] | (b[5] << 8);
+            e->dir      = static_cast<Dir>(b[6]);
+            e->ch       = b[7];
+            e->rssi     = static_cast<int8_t>(b[8]);
+            e->len      = std::min(b[9], (uint8_t)MAX_RF_PAYLOAD_SIZE);
+            memcpy(e->packet, &b[10], MAX_RF_PAYLOAD_SIZE);
+        }
+
+    private:
+        entry_t *next(void) {
+            entry_t *e = &mEntries[mWr];
+            mWr = (mWr + 1) % PACKET_TRACE_SIZE;
+            if(mCnt < PACKET_TRACE_SIZE)
+                mCnt++;
+            e->ms = millis();
+            return e;
+        }
+
+        inline void copy(entry_t *e, const uint8_t buf[], uint8_t len) {
+            e->len = std::min(len, (uint8_t)MAX_RF_PAYLOAD_SIZE);
+            memcpy(e->packet, buf, e->len);
+            memset(&e->packet[e->len], 0x00, MAX_RF_PAYLOAD_SIZE - e->len);
+        }
+
+    private:
+        entry_t mEntries[PACKET_TRACE_SIZE];
+        uint16_t mWr = 0;
+        uint16_t mCnt = 0;
+};
+
+#endif /*ENABLE_PACKET_TRACE*/
+
+#endif /*__PACKET_TRACE_H__*/
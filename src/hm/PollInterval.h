@@ -0,0 +1,93 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __POLL_INTERVAL_H__
+#define __POLL_INTERVAL_H__
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#define POLL_EWMA_WEIGHT        0.25f   // weight of a new sample
+#define POLL_PWR_CHANGE_PCT     2.0f    // average change of the AC power (% of max power) which gives the min interval
+#define POLL_PWR_MIN_REF        50.0f   // [W] reference power if the max power of the inverter is unknown
+
+//-----------------------------------------------------------------------------
+// adaptive poll interval of one inverter. The interval moves between min and
+// max with the average change of the AC power from poll to poll: no change
+// gives max, a change of POLL_PWR_CHANGE_PCT of the max power or more gives
+// min. A poor radio link stretches the interval towards max, every request
+// costs a lot of retransmits there. Not producing inverters use max, an
+// inverter which is starting min.
+// tick() has to be called every second.
+//-----------------------------------------------------------------------------
+class PollInterval {
+    public:
+        // AC power of a new real time data payload
+        void addPower(float pac) {
+            if(!mHasPower) {
+                mAvgPwr   = pac;
+                mLastPwr  = pac;
+                mPwrDev   = 0;
+                mHasPower = true;
+                return;
+            }
+            float diff = pac - mLastPwr;
+            mPwrDev  += (fabsf(diff) - mPwrDev) * POLL_EWMA_WEIGHT;
+            mAvgPwr  += (pac - mAvgPwr) * POLL_EWMA_WEIGHT;
+            mLastPwr  = pac;
+        }
+
+        // returns true if the inverter has to be polled now
+        bool tick(void) {
+            if(0 != mRemain)
+                mRemain--;
+            return (0 == mRemain);
+        }
+
+        // sets the next poll, 'txCnt' and 'rxSuccess' are the radio statistics of the inverter
+        void start(bool producing, bool starting, uint16_t maxPwr, uint32_t txCnt, uint32_t rxSuccess, uint16_t min, uint16_t max) {
+            if(max < min)
+                max = min;
+
+            uint32_t tx = txCnt - mLastTxCnt;
+            if(0 != tx) {
+                float rate = (float)(rxSuccess - mLastRxSuccess) / tx;
+                mSuccess += (std::min(rate, 1.0f) - mSuccess) * POLL_EWMA_WEIGHT;
+            }
+            mLastTxCnt     = txCnt;
+            mLastRxSuccess = rxSuccess;
+
+            if(starting)
+                mInterval = min;
+            else if(!producing)
+                mInterval = max;
+            else {
+                float ref = (0 != maxPwr) ? maxPwr : std::max(mAvgPwr, POLL_PWR_MIN_REF);
+                float change = mPwrDev / (ref * POLL_PWR_CHANGE_PCT / 100.0f);
+                float intvl = max - (max - min) * std::min(change, 1.0f);
+                intvl += (max - intvl) * (1.0f - mSuccess);
+                mInterval = (uint16_t)lroundf(intvl);
+            }
+            mRemain = mInterval;
+        }
+
+        uint16_t getInterval(void) const {
+            return mInterval;
+        }
+
+    private:
+        float mAvgPwr = 0;
+        float mLastPwr = 0;
+        float mPwrDev = 0;           // average change of AC power between two payloads
+        float mSuccess = 1.0f;       // average share of successful requests
+        bool mHasPower = false;
+        uint32_t mLastTxCnt = 0;
+        uint32_t mLastRxSuccess = 0;
+        uint16_t mInterval = 0;
+        uint16_t mRemain = 0;        // seconds till the next poll
+};
+
+#endif /*__POLL_INTERVAL_H__*/
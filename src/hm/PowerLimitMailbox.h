@@ -0,0 +1,126 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __POWER_LIMIT_MAILBOX_H__
+#define __POWER_LIMIT_MAILBOX_H__
+
+#include <Arduino.h>
+#include <cstdint>
+
+#if !defined(ESP32)
+    #if !defined(vSemaphoreDelete)
+        #define vSemaphoreDelete(a)
+        #define xSemaphoreTake(a, b) { while(a) { yield(); } a = true; }
+        #define xSemaphoreGive(a) { a = false; }
+    #endif
+#endif
+
+//-----------------------------------------------------------------------------
+// power limit set points of one inverter, the latest one wins: set points
+// which arrive before the request is sent replace the previous one (the
+// request is only queued once). take() copies the set point when the request
+// is sent, so a retry sends the latest one as well. The latency is measured
+// from the oldest set point which wasn't acknowledged yet till the ack.
+// post() runs in the context of the web server or MQTT, take() and ack() in
+// the communication loop or the radio task, limit and control type are only
+// read and written together.
+//-----------------------------------------------------------------------------
+class PowerLimitMailbox {
+    public:
+        typedef struct {
+            uint32_t reqCnt;        // set points
+            uint32_t coalescedCnt;  // replaced a set point which wasn't sent
+            uint32_t sentCnt;       // requests incl. retries
+            uint32_t ackCnt;
+            uint32_t lastMs;        // set point till ack
+            uint32_t maxMs;
+            uint32_t sumMs;
+        } stat_t;
+
+    public:
+        PowerLimitMailbox() {
+            #if defined(ESP32)
+            mutex = xSemaphoreCreateBinaryStatic(&mutex_buffer);
+            xSemaphoreGive(mutex);
+            #else
+            mutex = false;
+            #endif
+        }
+
+        ~PowerLimitMailbox() {
+            vSemaphoreDelete(mutex);
+        }
+
+        void post(uint16_t limit, uint16_t ctrl) {
+            xSemaphoreTake(mutex, portMAX_DELAY);
+            mLimit[0] = limit;
+            mLimit[1] = ctrl;
+            mStat.reqCnt++;
+            if(mPending)
+                mStat.coalescedCnt++;
+            else {
+                mPending   = true;
+                mTsPending = millis();
+            }
+            xSemaphoreGive(mutex);
+        }
+
+        // request is sent now, copies the latest set point to 'data'
+        void take(uint16_t data[2]) {
+            xSemaphoreTake(mutex, portMAX_DELAY);
+            data[0] = mLimit[0];
+            data[1] = mLimit[1];
+            mStat.sentCnt++;
+            if(mPending) {
+                if(!mInFlight)
+                    mTsSent = mTsPending;
+                mPending  = false;
+                mInFlight = true;
+            }
+            xSemaphoreGive(mutex);
+        }
+
+        // accepted by the inverter, returns false if a newer set point is
+        // waiting
+        bool ack(void) {
+            xSemaphoreTake(mutex, portMAX_DELAY);
+            if(mInFlight) {
+                uint32_t ms = millis() - mTsSent;
+                mStat.ackCnt++;
+                mStat.lastMs = ms;
+                mStat.sumMs += ms;
+                if(ms > mStat.maxMs)
+                    mStat.maxMs = ms;
+                mInFlight = false;
+            }
+            bool latest = !mPending;
+            xSemaphoreGive(mutex);
+            return latest;
+        }
+
+        inline bool isPending(void) const {
+            return mPending;
+        }
+
+        inline const stat_t *getStat(void) const {
+            return &mStat;
+        }
+
+    private:
+        uint16_t mLimit[2] = {0xffff, 0};
+        bool mPending = false;      // set point wasn't sent yet
+        bool mInFlight = false;     // sent, not acknowledged
+        uint32_t mTsPending = 0;
+        uint32_t mTsSent = 0;
+        stat_t mStat = {0, 0, 0, 0, 0, 0, 0};
+        #if defined(ESP32)
+        SemaphoreHandle_t mutex;
+        StaticSemaphore_t mutex_buffer;
+        #else
+        bool mutex;
+        #endif
+};
+
+#endif /*__POWER_LIMIT_MAILBOX_H__*/
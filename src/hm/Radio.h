@@ -16,6 +16,8 @@
 #include "../utils/dbg.h"
 #include "../utils/crc.h"
 #include "../utils/timemonitor.h"
+#include "PacketTrace.h"
+#include "PacketRing.h"
 
 enum { IRQ_UNKNOWN = 0, IRQ_OK, IRQ_ERROR };
 
@@ -39,6 +41,7 @@ class Radio {
         Radio() : mTxBuf{} {}
 
         void handleIntr(void) {
+            mIrqMillis = millis();
             mIrqRcvd = true;
             mIrqOk = IRQ_OK;
         }
@@ -80,8 +83,18 @@ class Radio {
             mFramesExpected = framesExpected;
         }
 
+        #if defined(ENABLE_PACKET_TRACE)
+        void setPacketTrace(PacketTrace *trace) {
+            mTrace = trace;
+        }
+
+        PacketTrace *getPacketTrace(void) {
+            return mTrace;
+        }
+        #endif
+
     public:
-        std::queue<packet_t> mBufCtrl;
+        PacketRing<RADIO_RX_BUF_SIZE> mBufCtrl;
         uint8_t mIrqOk = IRQ_UNKNOWN;
         TimeMonitor mRadioWaitTime = TimeMonitor(0, true);  // start as expired (due to code in RESET state)
         uint8_t mTxRetriesNext = 15;                        // let heuristics tell us the next reties count (for nRF type radios only)
@@ -115,6 +128,29 @@ class Radio {
             (*len)++;
         }
 
+        // time from the last TX till the IRQ of the received frame, falls back
+        // to now if the frame was not announced by an IRQ after the TX
+        inline uint16_t getRxMillis(void) const {
+            uint32_t irq = mIrqMillis;
+            if((int32_t)(irq - mMillis) < 0)
+                irq = millis();
+            return irq - mMillis;
+        }
+
+        inline void traceRx(const packet_t *p) {
+            #if defined(ENABLE_PACKET_TRACE)
+            if(nullptr != mTrace)
+                mTrace->addRx(p);
+            #endif
+        }
+
+        inline void traceTx(uint8_t len, uint8_t ch) {
+            #if defined(ENABLE_PACKET_TRACE)
+            if(nullptr != mTrace)
+                mTrace->addTx(mTxBuf.data(), len, ch);
+            #endif
+        }
+
         void generateDtuSn(void) {
             uint32_t chipID = 0;
             #ifdef ESP32
@@ -136,8 +172,13 @@ class Radio {
     protected:
         uint32_t mDtuSn = 0;
         std::atomic<bool> mIrqRcvd = false;
+        std::atomic<uint32_t> mIrqMillis = 0;   // millis() at the last IRQ
+        uint32_t mMillis = 0;                   // millis() at the last TX
         bool *mSerialDebug = nullptr, *mPrivacyMode = nullptr, *mPrintWholeTrace = nullptr;
         std::array<uint8_t, MAX_RF_PAYLOAD_SIZE> mTxBuf;
+        #if defined(ENABLE_PACKET_TRACE)
+        PacketTrace *mTrace = nullptr;
+        #endif
 };
 
 #endif /*__RADIO_H__*/
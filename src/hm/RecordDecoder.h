@@ -0,0 +1,134 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __RECORD_DECODER_H__
+#define __RECORD_DECODER_H__
+
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include "hmDefines.h"
+#include "RecordStorage.h"
+
+//-----------------------------------------------------------------------------
+// Payload decoders generated at compile time out of a constexpr assignment
+// list. Each list entry becomes a fixed big endian load, the signed cast and
+// the division of its field, the loop over the list, the byte counter and the
+// field id comparisons of Inverter::addValue are gone. The decoder writes
+// exactly the same values as addValue, the state of yield day and the
+// correction of yield total are passed in by the inverter. With
+// ENABLE_FIXED_POINT_RECORD the raw values are stored at the offsets given by
+// RecordStorage.h, the division is left to the output.
+//-----------------------------------------------------------------------------
+
+typedef struct {
+    const double *yieldCor; // config: yield total correction per channel
+    float *lastYD;          // last yield day per channel (inverter)
+    float *offYD;           // yield day offset per channel (inverter)
+} decodeCtx_t;
+
+#if defined(ENABLE_FIXED_POINT_RECORD)
+template<class T>
+using decoder_t = void (*)(const uint8_t buf[], uint8_t raw[], decodeCtx_t *ctx);
+#else
+template<class T>
+using decoder_t = void (*)(const uint8_t buf[], T record[], decodeCtx_t *ctx);
+#endif
+
+namespace decoder {
+    template<uint8_t start, uint8_t num>
+    inline uint32_t load(const uint8_t buf[]) {
+        if constexpr (2 == num)
+            return ((uint32_t)buf[start] << 8) | buf[start + 1];
+        else if constexpr (4 == num)
+            return ((uint32_t)buf[start] << 24) | ((uint32_t)buf[start + 1] << 16)
+                | ((uint32_t)buf[start + 2] << 8) | buf[start + 3];
+        else {
+            uint32_t val = 0;
+            for(uint8_t i = 0; i < num; i++)
+                val = (val << 8) | buf[start + i];
+            return val;
+        }
+    }
+
+    #if defined(ENABLE_FIXED_POINT_RECORD)
+    template<class T, const byteAssign_t *assign, std::size_t length, std::size_t pos>
+    inline void field(const uint8_t buf[], uint8_t raw[], decodeCtx_t *ctx) {
+        constexpr byteAssign_t a = assign[pos];
+        if constexpr (CMD_CALC != a.div) {
+            static_assert((a.num > 0) && (a.num <= 4), "field exceeds 32 bit");
+            constexpr uint8_t ofs = fixedRec::getOffset(assign, length, pos);
+            constexpr bool wide   = fixedRec::isWide(a);
+            constexpr bool sign   = fixedRec::isSigned(a.fieldId);
+            uint32_t val = load<a.start, a.num>(buf);
+
+            if constexpr (sign) {
+                fixedRec::store(raw, ofs, wide, sign, (int16_t)val);
+            } else if constexpr (FLD_YT == a.fieldId) {
+                static_assert(a.ch > CH0, "yield total of channel 0 must be calculated");
+                fixedRec::store(raw, ofs, wide, sign, (int64_t)val + llround(ctx->yieldCor[a.ch - 1] * a.div));
+            } else if constexpr (FLD_YD == a.fieldId) {
+                static_assert(a.ch > CH0, "yield day of channel 0 must be calculated");
+                constexpr uint8_t idx = a.ch - 1;
+                float actYD = (T)(val) / (T)(a.div);
+                if (ctx->lastYD[idx] > actYD)
+                    ctx->offYD[idx] += ctx->lastYD[idx];
+                ctx->lastYD[idx] = actYD;
+                fixedRec::store(raw, ofs, wide, sign, llroundf((ctx->offYD[idx] + actYD) * a.div));
+            } else {
+                fixedRec::store(raw, ofs, wide, sign, val);
+            }
+        }
+    }
+    #else
+    template<class T, const byteAssign_t *assign, std::size_t length, std::size_t pos>
+    inline void field(const uint8_t buf[], T record[], decodeCtx_t *ctx) {
+        constexpr byteAssign_t a = assign[pos];
+        if constexpr (CMD_CALC != a.div) {
+            static_assert((a.num > 0) && (a.num <= 4), "field exceeds 32 bit");
+            uint32_t val = load<a.start, a.num>(buf);
+
+            if constexpr ((FLD_T == a.fieldId) || (FLD_Q == a.fieldId) || (FLD_PF == a.fieldId)) {
+                record[pos] = ((T)((int16_t)val)) / (T)(a.div);
+            } else if constexpr (FLD_YT == a.fieldId) {
+                static_assert(a.ch > CH0, "yield total of channel 0 must be calculated");
+                record[pos] = ((T)(val) / (T)(a.div)) + ((T)ctx->yieldCor[a.ch - 1]);
+            } else if constexpr (FLD_YD == a.fieldId) {
+                static_assert(a.ch > CH0, "yield day of channel 0 must be calculated");
+                constexpr uint8_t idx = a.ch - 1;
+                float actYD = (T)(val) / (T)(a.div);
+                if (ctx->lastYD[idx] > actYD)
+                    ctx->offYD[idx] += ctx->lastYD[idx];
+                ctx->lastYD[idx] = actYD;
+                record[pos] = ctx->offYD[idx] + actYD;
+            } else if constexpr (a.div > 1) {
+                record[pos] = (T)(val) / (T)(a.div);
+            } else {
+                record[pos] = (T)(val);
+            }
+        }
+    }
+    #endif
+
+    template<class T, const byteAssign_t *assign, std::size_t length, class S, std::size_t... pos>
+    inline void fields(const uint8_t buf[], S record[], decodeCtx_t *ctx, std::index_sequence<pos...>) {
+        (field<T, assign, length, pos>(buf, record, ctx), ...);
+    }
+}
+
+// decoder for one assignment list, use as 'decode<REC_TYP, hm1chAssignment, HM1CH_LIST_LEN>'
+#if defined(ENABLE_FIXED_POINT_RECORD)
+template<class T, const byteAssign_t *assign, std::size_t length>
+void decode(const uint8_t buf[], uint8_t raw[], decodeCtx_t *ctx) {
+    decoder::fields<T, assign, length>(buf, raw, ctx, std::make_index_sequence<length>{});
+}
+#else
+template<class T, const byteAssign_t *assign, std::size_t length>
+void decode(const uint8_t buf[], T record[], decodeCtx_t *ctx) {
+    decoder::fields<T, assign, length>(buf, record, ctx, std::make_index_sequence<length>{});
+}
+#endif
+
+#endif /*__RECORD_DECODER_H__*/
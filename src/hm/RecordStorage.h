@@ -0,0 +1,102 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __RECORD_STORAGE_H__
+#define __RECORD_STORAGE_H__
+
+#if defined(ENABLE_FIXED_POINT_RECORD)
+
+#include <cstdint>
+#include <cstring>
+#include "hmDefines.h"
+
+//-----------------------------------------------------------------------------
+// Fixed point storage of the record values. A value is kept as raw integer,
+// the real value is raw / divisor of its byteAssign_t. Calculated values have
+// no divisor, they get a fixed resolution per unit (3 decimals for the
+// percentages, the API and MQTT show 3 decimals). Values which are 32 bit in
+// the payload, the yields, the sums of channel 0 and the calculated
+// percentages use 4 bytes (unsigned), all others 2 bytes.
+// The 4 byte values are placed first, the layout only depends on the
+// assignment list and is shared by all records using the list.
+//-----------------------------------------------------------------------------
+namespace fixedRec {
+    constexpr bool isWide(const byteAssign_t &a) {
+        if(CMD_CALC == a.div)
+            return (CALC_YT_CH0 == a.start) || (CALC_YD_CH0 == a.start) || (CALC_PDC_CH0 == a.start) || (UNIT_PCT == a.unitId);
+        return (a.num > 2) || (FLD_YD == a.fieldId);
+    }
+
+    constexpr bool isSigned(uint8_t fieldId) {
+        return (FLD_T == fieldId) || (FLD_Q == fieldId) || (FLD_PF == fieldId) || (FLD_MT == fieldId);
+    }
+
+    // resolution of calculated values
+    constexpr uint16_t getDiv(const byteAssign_t &a) {
+        if(CMD_CALC != a.div)
+            return (0 == a.div) ? 1 : a.div;
+        switch(a.unitId) {
+            case UNIT_A:   return 100;
+            case UNIT_KWH: return 1000;
+            case UNIT_HZ:  return 100;
+            case UNIT_PCT: return 1000; // efficiency, irradiation
+            case UNIT_WH:  return 1;
+            default:       return 10; // V, W, °C, var
+        }
+    }
+
+    // bytes used by the 4 byte values at the start of the storage
+    constexpr uint8_t getWideBytes(const byteAssign_t assign[], uint8_t length) {
+        uint8_t bytes = 0;
+        for(uint8_t i = 0; i < length; i++) {
+            if(isWide(assign[i]))
+                bytes += 4;
+        }
+        return bytes;
+    }
+
+    constexpr uint8_t getOffset(const byteAssign_t assign[], uint8_t length, uint8_t pos) {
+        uint8_t ofs = isWide(assign[pos]) ? 0 : getWideBytes(assign, length);
+        for(uint8_t i = 0; i < pos; i++) {
+            if(isWide(assign[i]) == isWide(assign[pos]))
+                ofs += isWide(assign[i]) ? 4 : 2;
+        }
+        return ofs;
+    }
+
+    constexpr uint16_t getSize(const byteAssign_t assign[], uint8_t length) {
+        return getWideBytes(assign, length) + (length - getWideBytes(assign, length) / 4) * 2;
+    }
+
+    // values are saturated to the range of their storage
+    inline void store(uint8_t raw[], uint8_t ofs, bool wide, bool sign, int64_t val) {
+        if(wide) {
+            uint32_t v = (val < 0) ? 0 : ((val > UINT32_MAX) ? UINT32_MAX : val);
+            memcpy(&raw[ofs], &v, 4);
+            return;
+        }
+        if(sign)
+            val = (val < INT16_MIN) ? INT16_MIN : ((val > INT16_MAX) ? INT16_MAX : val);
+        else
+            val = (val < 0) ? 0 : ((val > UINT16_MAX) ? UINT16_MAX : val);
+        uint16_t v = (uint16_t)val;
+        memcpy(&raw[ofs], &v, 2);
+    }
+
+    inline int64_t load(const uint8_t raw[], uint8_t ofs, bool wide, bool sign) {
+        if(wide) {
+            uint32_t v;
+            memcpy(&v, &raw[ofs], 4);
+            return v;
+        }
+        uint16_t v;
+        memcpy(&v, &raw[ofs], 2);
+        return sign ? (int64_t)(int16_t)v : (int64_t)v;
+    }
+}
+
+#endif /*ENABLE_FIXED_POINT_RECORD*/
+
+#endif /*__RECORD_STORAGE_H__*/
@@ -60,6 +60,7 @@ enum {FLD_UDC = 0, FLD_IDC, FLD_PDC, FLD_YD, FLD_YW, FLD_YT,
         FLD_FW_BUILD_MONTH_DAY, FLD_FW_BUILD_HOUR_MINUTE, FLD_BOOTLOADER_VER,
         FLD_ACT_ACTIVE_PWR_LIMIT, FLD_PART_NUM, FLD_HW_VERSION, FLD_GRID_PROFILE_CODE,
         FLD_GRID_PROFILE_VERSION,  /*FLD_ACT_REACTIVE_PWR_LIMIT, FLD_ACT_PF,*/ FLD_LAST_ALARM_CODE, FLD_MP, FLD_MT};
+#define FLD_CNT     (FLD_MT + 1) // number of field ids, keep in sync with the last field
 
 const char* const fields[] = {"U_DC", "I_DC", "P_DC", "YieldDay", "YieldWeek", "YieldTotal",
         "U_AC", "U_AC_1N", "U_AC_2N", "U_AC_3N", "U_AC_12", "U_AC_23", "U_AC_31", "I_AC",
@@ -114,11 +115,20 @@ enum {INV_TYPE_1CH = 0, INV_TYPE_2CH, INV_TYPE_4CH, INV_TYPE_6CH};
 enum {INV_RADIO_TYPE_UNKNOWN = 0, INV_RADIO_TYPE_NRF, INV_RADIO_TYPE_CMT};
 
 
+// timings can be overwritten by build flags, e.g. to compare them using a packet trace replay
+#ifndef DURATION_ONEFRAME
 #define DURATION_ONEFRAME       50 // timeout parameter for each expected frame (ms)
+#endif
 //#define DURATION_RESERVE  {90,120} // timeout parameter to still wait after last expected frame (ms)
+#ifndef DURATION_TXFRAME
 #define DURATION_TXFRAME        85 // timeout parameter for first transmission and first expected frame (time to first channel switch from tx start!) (ms)
+#endif
+#ifndef DURATION_LISTEN_MIN
 #define DURATION_LISTEN_MIN      5 // time to stay at least on a listening channel (ms)
+#endif
+#ifndef DURATION_PAUSE_LASTFR
 #define DURATION_PAUSE_LASTFR   45 // how long to pause after last frame (ms)
+#endif
 const uint8_t duration_reserve[2] = {65, 115};
 
 #define LIMIT_FAST_IV           85 // time limit to qualify an inverter as very fast answering inverter
@@ -187,7 +197,7 @@ const byteAssign_t AlarmDataAssignment[] = {
 //-------------------------------------
 // HM300, HM350, HM400
 //-------------------------------------
-const byteAssign_t hm1chAssignment[] = {
+constexpr byteAssign_t hm1chAssignment[] = {
     { FLD_UDC, UNIT_V,    CH1,  2, 2, 10   },
     { FLD_IDC, UNIT_A,    CH1,  4, 2, 100  },
     { FLD_PDC, UNIT_W,    CH1,  6, 2, 10   },
@@ -218,7 +228,7 @@ const byteAssign_t hm1chAssignment[] = {
 //-------------------------------------
 // HM600, HM700, HM800
 //-------------------------------------
-const byteAssign_t hm2chAssignment[] = {
+constexpr byteAssign_t hm2chAssignment[] = {
     { FLD_UDC, UNIT_V,    CH1,  2, 2, 10   },
     { FLD_IDC, UNIT_A,    CH1,  4, 2, 100  },
     { FLD_PDC, UNIT_W,    CH1,  6, 2, 10   },
@@ -258,7 +268,7 @@ const byteAssign_t hm2chAssignment[] = {
 //-------------------------------------
 // HM1200, HM1500
 //-------------------------------------
-const byteAssign_t hm4chAssignment[] = {
+constexpr byteAssign_t hm4chAssignment[] = {
     { FLD_UDC, UNIT_V,    CH1,  2, 2, 10   },
     { FLD_IDC, UNIT_A,    CH1,  4, 2, 100  },
     { FLD_PDC, UNIT_W,    CH1,  8, 2, 10   },
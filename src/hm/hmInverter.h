@@ -16,6 +16,9 @@
 #include "hmDefines.h"
 #include "../appInterface.h"
 #include "HeuristicInv.h"
+#include "PollInterval.h"
+#include "PowerLimitMailbox.h"
+#include "RecordDecoder.h"
 #include "../hms/hmsDefines.h"
 #include <memory>
 #include <queue>
@@ -86,12 +89,23 @@ template<class T=float>
 struct record_t {
     byteAssign_t* assign = nullptr; // assignment of bytes in payload
     uint8_t length = 0;             // length of the assignment list
+    #if defined(ENABLE_FIXED_POINT_RECORD)
+    uint8_t *raw = nullptr;         // fixed point values, see RecordStorage.h
+    const uint8_t *rawOfs = nullptr; // [pos] -> byte offset in raw
+    uint8_t rawWide = 0;            // bytes of 32 bit values at the start of raw
+    #else
     T *record = nullptr;            // data pointer
+    #endif
     uint32_t ts = 0;                // Timestamp of last received payload
     uint8_t pyldLen = 0;            // expected payload length for plausibility check
     MqttSentStatus mqttSentStatus = MqttSentStatus:: NEW_DATA; // indicates the current MqTT sent status
+    const uint8_t *fieldPos = nullptr; // [channel][fieldId] -> pos, see Inverter::getFieldIndex
+    uint8_t fieldPosCh = 0;         // number of channels (rows) in fieldPos
+    decoder_t<T> decode = nullptr;  // generated decoder of the assignment list, see RecordDecoder.h
 };
 
+#define FIELD_INDEX_CACHE_SIZE  16 // distinct assignment lists, currently 12
+
 template<class T=float>
 struct history_t {
     bool initialized;
@@ -156,7 +170,8 @@ class Inverter {
         uint8_t       id = 0;                               // unique id
         uint8_t       type = INV_TYPE_1CH;                  // integer which refers to inverter type
         uint16_t      alarmMesIndex = 0;                    // Last recorded Alarm Message Index
-        uint16_t      powerLimit[2] = {0xffff, AbsolutNonPersistent}; // limit power output (multiplied by 10)
+        uint16_t      powerLimit[2] = {0xffff, AbsolutNonPersistent}; // last sent limit power output (multiplied by 10)
+        PowerLimitMailbox limitBox;                         // power limit set points, see setPowerLimitRequest()
         uint16_t      actPowerLimit = 0xffff;               // actual power limit
         bool          powerLimitAck = false;                // acknowledged power limit
         uint8_t       devControlCmd = InitDataState;        // carries the requested cmd
@@ -182,6 +197,7 @@ class Inverter {
         Radio         *radio = nullptr;                     // pointer to associated radio class
         statistics_t  radioStatistics;                      // information about transmitted, failed, ... packets
         HeuristicInv  heuristics;                           // heuristic information / logic
+        PollInterval  pollIntvl;                            // adaptive poll interval
         uint8_t       curCmtFreq = 0;                       // current used CMT frequency, used to check if freq. was changed during runtime
         uint32_t      tsMaxAcPower = 0;                     // holds the Timestamp when the MaxAC power was seen
         uint32_t      tsMaxTemperature = 0;                 // holds the Timestamp when the max temperature was seen
@@ -197,6 +213,12 @@ class Inverter {
             mGridProfile.fill(0);
         }
 
+        // next poll of the adaptive interval, call once the poll is due, before its requests are added to the queue
+        void startPollInterval(uint16_t min, uint16_t max) {
+            pollIntvl.start((InverterStatus::PRODUCING == status), (InverterStatus::STARTING == status),
+                getMaxPower(), radioStatistics.txCnt, radioStatistics.rxSuccess, min, max);
+        }
+
         void tickSend(std::function<void(uint8_t cmd, bool isDevControl)> cb) {
             if(mDevControlRequest) {
                 if(InverterStatus::OFF != status) {
@@ -279,6 +301,12 @@ class Inverter {
             if(nullptr == rec)
                 return 0xff;
 
+            if(nullptr != rec->fieldPos) {
+                if((channel >= rec->fieldPosCh) || (fieldId >= FLD_CNT))
+                    return 0xff;
+                return rec->fieldPos[channel * FLD_CNT + fieldId];
+            }
+
             uint8_t pos = 0;
             for(; pos < rec->length; pos++) {
                 if((rec->assign[pos].ch == channel) && (rec->assign[pos].fieldId == fieldId))
@@ -320,6 +348,14 @@ class Inverter {
             return false;
         }
 
+        // the latest limit is sent, limits of a waiting request are replaced
+        bool setPowerLimitRequest(uint16_t limit, uint16_t ctrl) {
+            if(InverterStatus::OFF == status)
+                return false;
+            limitBox.post(limit, ctrl);
+            return setDevControlRequest(ActivePowerContr);
+        }
+
         bool setDevCommand(uint8_t cmd) {
             bool retval = (InverterStatus::OFF != status);
             if(retval)
@@ -341,6 +377,23 @@ class Inverter {
                         val |= buf[ptr];
                     } while(++ptr != end);
 
+                    #if defined(ENABLE_FIXED_POINT_RECORD)
+                    int64_t raw = val;
+                    if ((FLD_T == rec->assign[pos].fieldId) || (FLD_Q == rec->assign[pos].fieldId) || (FLD_PF == rec->assign[pos].fieldId)) {
+                        // temperature, Qvar, and power factor are a signed values
+                        raw = (int16_t)val;
+                    } else if (FLD_YT == rec->assign[pos].fieldId) {
+                        raw += llround(config->yieldCor[rec->assign[pos].ch-1] * div);
+                    } else if (FLD_YD == rec->assign[pos].fieldId) {
+                        float actYD = (REC_TYP)(val) / (REC_TYP)(div);
+                        uint8_t idx = rec->assign[pos].ch - 1;
+                        if (mLastYD[idx] > actYD)
+                            mOffYD[idx] += mLastYD[idx];
+                        mLastYD[idx] = actYD;
+                        raw = llroundf((mOffYD[idx] + actYD) * div);
+                    }
+                    setRaw(pos, rec, raw);
+                    #else
                     if ((FLD_T == rec->assign[pos].fieldId) || (FLD_Q == rec->assign[pos].fieldId) || (FLD_PF == rec->assign[pos].fieldId)) {
                         // temperature, Qvar, and power factor are a signed values
                         rec->record[pos] = ((REC_TYP)((int16_t)val)) / (REC_TYP)(div);
@@ -359,14 +412,15 @@ class Inverter {
                         else
                             rec->record[pos] = (REC_TYP)(val);
                     }
+                    #endif
                 }
 
                 if(rec == &recordMeas) {
                     DPRINTLN(DBG_VERBOSE, "add real time");
                     // get last alarm message index and save it in the inverter object
                     if (getPosByChFld(0, FLD_EVT, rec) == pos) {
-                        if (alarmMesIndex < rec->record[pos]) {
-                            alarmMesIndex = rec->record[pos];
+                        if (alarmMesIndex < getValue(pos, rec)) {
+                            alarmMesIndex = getValue(pos, rec);
 
                             DPRINT(DBG_INFO, "alarm ID incremented to ");
                             DBGPRINTLN(String(alarmMesIndex));
@@ -382,7 +436,7 @@ class Inverter {
                     } else if (rec->assign == SystemConfigParaAssignment) {
                         DPRINTLN(DBG_DEBUG, "add config");
                         if (getPosByChFld(0, FLD_ACT_ACTIVE_PWR_LIMIT, rec) == pos) {
-                            actPowerLimit = rec->record[pos];
+                            actPowerLimit = getValue(pos, rec);
                             DPRINT(DBG_DEBUG, F("Inverter actual power limit: "));
                             DPRINTLN(DBG_DEBUG, String(actPowerLimit, 1));
                         }
@@ -398,30 +452,65 @@ class Inverter {
             isProducing();
         }
 
+        // adds all values of a payload, uses the generated decoder if there is
+        // one for the assignment list (real time data)
+        void addValues(const uint8_t buf[], record_t<> *rec) {
+            if(nullptr == rec) {
+                DPRINTLN(DBG_ERROR, F("addValues: assignment not found"));
+                return;
+            }
+
+            if(nullptr == rec->decode) {
+                for(uint8_t i = 0; i < rec->length; i++) {
+                    addValue(i, buf, rec);
+                    yield();
+                }
+                return;
+            }
+
+            decodeCtx_t ctx = {config->yieldCor, mLastYD, mOffYD};
+            #if defined(ENABLE_FIXED_POINT_RECORD)
+            rec->decode(buf, rec->raw, &ctx);
+            #else
+            rec->decode(buf, rec->record, &ctx);
+            #endif
+
+            if(rec == &recordMeas) {
+                // get last alarm message index and save it in the inverter object
+                uint8_t pos = getPosByChFld(0, FLD_EVT, rec);
+                if((0xff != pos) && (alarmMesIndex < getValue(pos, rec))) {
+                    alarmMesIndex = getValue(pos, rec);
+
+                    DPRINT(DBG_INFO, "alarm ID incremented to ");
+                    DBGPRINTLN(String(alarmMesIndex));
+                }
+            }
+
+            // update status state-machine
+            isProducing();
+        }
+
         bool setValue(uint8_t pos, record_t<> *rec, REC_TYP val) {
             DPRINTLN(DBG_VERBOSE, F("hmInverter.h:setValue"));
             if(nullptr == rec)
                 return false;
+            #if defined(ENABLE_FIXED_POINT_RECORD)
+            if(pos >= rec->length)
+                return false;
+            setRaw(pos, rec, llroundf(val * fixedRec::getDiv(rec->assign[pos])));
+            #else
             if(pos > rec->length)
                 return false;
             rec->record[pos] = val;
+            #endif
             return true;
         }
 
         REC_TYP getChannelFieldValue(uint8_t channel, uint8_t fieldId, record_t<> *rec) {
-            if(NULL != rec) {
-                uint8_t pos = 0;
-                for(; pos < rec->length; pos++) {
-                    if((rec->assign[pos].ch == channel) && (rec->assign[pos].fieldId == fieldId))
-                        break;
-                }
-
-                if(pos >= rec->length)
-                    return 0;
-
-                return rec->record[pos];
-            } else
+            uint8_t pos = getPosByChFld(channel, fieldId, rec);
+            if(0xff == pos)
                 return 0;
+            return getValue(pos, rec);
         }
 
         uint32_t getChannelFieldValueInt(uint8_t channel, uint8_t fieldId, record_t<> *rec) {
@@ -432,17 +521,32 @@ class Inverter {
             DPRINTLN(DBG_VERBOSE, F("hmInverter.h:getValue"));
             if(NULL == rec)
                 return 0;
+            #if defined(ENABLE_FIXED_POINT_RECORD)
+            if(pos >= rec->length)
+                return 0;
+            const byteAssign_t *a = &rec->assign[pos];
+            uint8_t ofs = rec->rawOfs[pos];
+            return (REC_TYP)fixedRec::load(rec->raw, ofs, (ofs < rec->rawWide), fixedRec::isSigned(a->fieldId)) / (REC_TYP)fixedRec::getDiv(*a);
+            #else
             if(pos > rec->length)
                 return 0;
             return rec->record[pos];
+            #endif
+        }
+
+        #if defined(ENABLE_FIXED_POINT_RECORD)
+        void setRaw(uint8_t pos, record_t<> *rec, int64_t raw) {
+            uint8_t ofs = rec->rawOfs[pos];
+            fixedRec::store(rec->raw, ofs, (ofs < rec->rawWide), fixedRec::isSigned(rec->assign[pos].fieldId), raw);
         }
+        #endif
 
         void doCalculations() {
             DPRINTLN(DBG_VERBOSE, F("hmInverter.h:doCalculations"));
             record_t<> *rec = getRecordStruct(RealTimeRunData_Debug);
             for(uint8_t i = 0; i < rec->length; i++) {
                 if(CMD_CALC == rec->assign[i].div) {
-                    rec->record[i] = calcFunctions<REC_TYP>[rec->assign[i].start].func(this, rec->assign[i].num);
+                    setValue(i, rec, calcFunctions<REC_TYP>[rec->assign[i].start].func(this, rec->assign[i].num));
                 }
                 yield();
             }
@@ -466,8 +570,12 @@ class Inverter {
                         status = InverterStatus::OFF;
                         actPowerLimit = 0xffff; // power limit will be read once inverter becomes available
                         alarmMesIndex = 0;
-                        if(INV_RADIO_TYPE_NRF == ivRadioType)
-                            heuristics.clear();
+                        if(INV_RADIO_TYPE_NRF == ivRadioType) {
+                            if((nullptr != ChSelect) && (RF_CH_SEL_UCB == *ChSelect))
+                                heuristics.decay(RF_DECAY_OFF); // keep the learned channels for the next day
+                            else
+                                heuristics.clear();
+                        }
                     }
                 } else
                     status = InverterStatus::WAS_ON;
@@ -759,6 +867,7 @@ class Inverter {
             DPRINTLN(DBG_VERBOSE, F("hmInverter.h:initAssignment"));
             rec->ts     = 0;
             rec->length = 0;
+            rec->decode = nullptr;
             rec->mqttSentStatus = MqttSentStatus::DATA_SENT; // nothing new to transmit
             switch (cmd) {
                 case RealTimeRunData_Debug:
@@ -766,10 +875,12 @@ class Inverter {
                         if((IV_HM == ivGen) || (IV_MI == ivGen)) {
                             rec->length  = (uint8_t)(HM1CH_LIST_LEN);
                             rec->assign  = reinterpret_cast<byteAssign_t*>(const_cast<byteAssign_t*>(hm1chAssignment));
+                            rec->decode  = decode<REC_TYP, hm1chAssignment, HM1CH_LIST_LEN>;
                             rec->pyldLen = HM1CH_PAYLOAD_LEN;
                         } else if(IV_HMS == ivGen) {
                             rec->length  = (uint8_t)(HMS1CH_LIST_LEN);
                             rec->assign  = reinterpret_cast<byteAssign_t*>(const_cast<byteAssign_t*>(hms1chAssignment));
+                            rec->decode  = decode<REC_TYP, hms1chAssignment, HMS1CH_LIST_LEN>;
                             rec->pyldLen = HMS1CH_PAYLOAD_LEN;
                         }
                         channels = 1;
@@ -778,10 +889,12 @@ class Inverter {
                         if((IV_HM == ivGen) || (IV_MI == ivGen)) {
                             rec->length  = (uint8_t)(HM2CH_LIST_LEN);
                             rec->assign  = reinterpret_cast<byteAssign_t*>(const_cast<byteAssign_t*>(hm2chAssignment));
+                            rec->decode  = decode<REC_TYP, hm2chAssignment, HM2CH_LIST_LEN>;
                             rec->pyldLen = HM2CH_PAYLOAD_LEN;
                         } else if(IV_HMS == ivGen) {
                             rec->length  = (uint8_t)(HMS2CH_LIST_LEN);
                             rec->assign  = reinterpret_cast<byteAssign_t*>(const_cast<byteAssign_t*>(hms2chAssignment));
+                            rec->decode  = decode<REC_TYP, hms2chAssignment, HMS2CH_LIST_LEN>;
                             rec->pyldLen = HMS2CH_PAYLOAD_LEN;
                         }
                         channels = 2;
@@ -790,14 +903,17 @@ class Inverter {
                         if((IV_HM == ivGen) || (IV_MI == ivGen)) {
                             rec->length  = (uint8_t)(HM4CH_LIST_LEN);
                             rec->assign  = reinterpret_cast<byteAssign_t*>(const_cast<byteAssign_t*>(hm4chAssignment));
+                            rec->decode  = decode<REC_TYP, hm4chAssignment, HM4CH_LIST_LEN>;
                             rec->pyldLen = HM4CH_PAYLOAD_LEN;
                         } else if(IV_HMS == ivGen) {
                             rec->length  = (uint8_t)(HMS4CH_LIST_LEN);
                             rec->assign  = reinterpret_cast<byteAssign_t*>(const_cast<byteAssign_t*>(hms4chAssignment));
+                            rec->decode  = decode<REC_TYP, hms4chAssignment, HMS4CH_LIST_LEN>;
                             rec->pyldLen = HMS4CH_PAYLOAD_LEN;
                         } else if(IV_HMT == ivGen){
                             rec->length  = (uint8_t)(HMT4CH_LIST_LEN);
                             rec->assign  = reinterpret_cast<byteAssign_t*>(const_cast<byteAssign_t*>(hmt4chAssignment));
+                            rec->decode  = decode<REC_TYP, hmt4chAssignment, HMT4CH_LIST_LEN>;
                             rec->pyldLen = HMT4CH_PAYLOAD_LEN;
                         }
                         channels = 4;
@@ -805,6 +921,7 @@ class Inverter {
                     else if (INV_TYPE_6CH == type) {
                         rec->length  = (uint8_t)(HMT6CH_LIST_LEN);
                         rec->assign  = reinterpret_cast<byteAssign_t*>(const_cast<byteAssign_t*>(hmt6chAssignment));
+                        rec->decode  = decode<REC_TYP, hmt6chAssignment, HMT6CH_LIST_LEN>;
                         rec->pyldLen = HMT6CH_PAYLOAD_LEN;
                         channels = 6;
                     }
@@ -841,11 +958,92 @@ class Inverter {
             }
 
             if(0 != rec->length) {
+                #if defined(ENABLE_FIXED_POINT_RECORD)
+                uint16_t size = fixedRec::getSize(rec->assign, rec->length);
+                rec->raw = new uint8_t[size];
+                memset(rec->raw, 0, size);
+                rec->rawOfs  = getRawOffsets(rec->assign, rec->length);
+                rec->rawWide = fixedRec::getWideBytes(rec->assign, rec->length);
+                #else
                 rec->record = new REC_TYP[rec->length];
                 memset(rec->record, 0, sizeof(REC_TYP) * rec->length);
+                #endif
+            }
+            rec->fieldPos = getFieldIndex(rec->assign, rec->length, &rec->fieldPosCh);
+        }
+
+        // The lookup table only depends on the (constant) assignment list, it
+        // is built once and shared by all records and inverters using the list.
+        // Returns nullptr if the cache is full, getPosByChFld then falls back
+        // to the linear search
+        static const uint8_t *getFieldIndex(const byteAssign_t *assign, uint8_t length, uint8_t *channels) {
+            typedef struct {
+                const byteAssign_t *assign;
+                uint8_t channels;
+                uint8_t *pos;
+            } fieldIndex_t;
+            static std::array<fieldIndex_t, FIELD_INDEX_CACHE_SIZE> cache = {};
+
+            *channels = 0;
+            if((nullptr == assign) || (0 == length))
+                return nullptr;
+
+            for(fieldIndex_t &idx : cache) {
+                if(nullptr == idx.assign) {
+                    uint8_t maxCh = 0;
+                    for(uint8_t i = 0; i < length; i++) {
+                        if(assign[i].ch > maxCh)
+                            maxCh = assign[i].ch;
+                    }
+                    idx.channels = maxCh + 1;
+                    idx.pos = new uint8_t[idx.channels * FLD_CNT];
+                    memset(idx.pos, 0xff, idx.channels * FLD_CNT);
+                    for(uint8_t i = 0; i < length; i++) {
+                        uint8_t *p = &idx.pos[assign[i].ch * FLD_CNT + assign[i].fieldId];
+                        if(0xff == *p) // first match wins, same as the linear search
+                            *p = i;
+                    }
+                    idx.assign = assign;
+                }
+
+                if(idx.assign == assign) {
+                    *channels = idx.channels;
+                    return idx.pos;
+                }
             }
+            return nullptr;
         }
 
+        #if defined(ENABLE_FIXED_POINT_RECORD)
+        // byte offset of each value in the fixed point storage, shared the
+        // same way as the field index. If the cache is full the record gets
+        // its own table
+        static const uint8_t *getRawOffsets(const byteAssign_t *assign, uint8_t length) {
+            typedef struct {
+                const byteAssign_t *assign;
+                uint8_t *ofs;
+            } rawLayout_t;
+            static std::array<rawLayout_t, FIELD_INDEX_CACHE_SIZE> cache = {};
+
+            rawLayout_t *empty = nullptr;
+            for(rawLayout_t &l : cache) {
+                if(l.assign == assign)
+                    return l.ofs;
+                if((nullptr == l.assign) && (nullptr == empty))
+                    empty = &l;
+            }
+
+            uint8_t *ofs = new uint8_t[length];
+            for(uint8_t i = 0; i < length; i++)
+                ofs[i] = fixedRec::getOffset(assign, length, i);
+            if(nullptr != empty) {
+                empty->assign = assign;
+                empty->ofs    = ofs;
+            }
+            return ofs;
+        }
+        #endif
+
         void resetAlarms(bool clearTs = false) {
             lastAlarm.fill({0, 0, 0});
             mAlarmNxtWrPos = 0;
@@ -1113,6 +1311,7 @@ class Inverter {
         static uint32_t  *Timestamp;     // system timestamp
         static cfgInst_t *GeneralConfig; // general inverter configuration from setup
         static IApp *App;
+        static const uint8_t *ChSelect; // nRF channel selection, set by Communication
 
         uint16_t mDtuRxCnt = 0;
         uint16_t mDtuTxCnt = 0;
@@ -1135,6 +1334,8 @@ template <class REC_TYP>
 cfgInst_t *Inverter<REC_TYP>::GeneralConfig {0};
 template <class REC_TYP>
 IApp *Inverter<REC_TYP>::App {nullptr};
+template <class REC_TYP>
+const uint8_t *Inverter<REC_TYP>::ChSelect {nullptr};
 
 
 /**
@@ -1143,7 +1344,7 @@ IApp *Inverter<REC_TYP>::App {nullptr};
  * The special command 0xff (CMDFF) must be used.
  */
 
-template<class T=float>
+template<class T>
 T calcYieldTotalCh0(Inverter<> *iv, uint8_t arg0) {
     DPRINTLN(DBG_VERBOSE, F("hmInverter.h:calcYieldTotalCh0"));
     if(NULL != iv) {
@@ -1157,7 +1358,7 @@ T calcYieldTotalCh0(Inverter<> *iv, uint8_t arg0) {
     return 0.0;
 }
 
-template<class T=float>
+template<class T>
 T calcYieldDayCh0(Inverter<> *iv, uint8_t arg0) {
     DPRINTLN(DBG_VERBOSE, F("hmInverter.h:calcYieldDayCh0"));
     if(NULL != iv) {
@@ -1171,7 +1372,7 @@ T calcYieldDayCh0(Inverter<> *iv, uint8_t arg0) {
     return 0.0;
 }
 
-template<class T=float>
+template<class T>
 T calcUdcCh(Inverter<> *iv, uint8_t arg0) {
     DPRINTLN(DBG_VERBOSE, F("hmInverter.h:calcUdcCh"));
     // arg0 = channel of source
@@ -1185,7 +1386,7 @@ T calcUdcCh(Inverter<> *iv, uint8_t arg0) {
     return 0.0;
 }
 
-template<class T=float>
+template<class T>
 T calcPowerDcCh0(Inverter<> *iv, uint8_t arg0) {
     DPRINTLN(DBG_VERBOSE, F("hmInverter.h:calcPowerDcCh0"));
     if(NULL != iv) {
@@ -1199,7 +1400,7 @@ T calcPowerDcCh0(Inverter<> *iv, uint8_t arg0) {
     return 0.0;
 }
 
-template<class T=float>
+template<class T>
 T calcEffiencyCh0(Inverter<> *iv, uint8_t arg0) {
     DPRINTLN(DBG_VERBOSE, F("hmInverter.h:calcEfficiencyCh0"));
     if(NULL != iv) {
@@ -1215,7 +1416,7 @@ T calcEffiencyCh0(Inverter<> *iv, uint8_t arg0) {
     return 0.0;
 }
 
-template<class T=float>
+template<class T>
 T calcIrradiation(Inverter<> *iv, uint8_t arg0) {
     DPRINTLN(DBG_VERBOSE, F("hmInverter.h:calcIrradiation"));
     // arg0 = channel
@@ -1227,7 +1428,7 @@ T calcIrradiation(Inverter<> *iv, uint8_t arg0) {
     return 0.0;
 }
 
-template<class T=float>
+template<class T>
 T calcMaxPowerAcCh0(Inverter<> *iv, uint8_t arg0) {
     DPRINTLN(DBG_VERBOSE, F("hmInverter.h:calcMaxPowerAcCh0"));
     T acMaxPower = 0.0;
@@ -1248,7 +1449,7 @@ T calcMaxPowerAcCh0(Inverter<> *iv, uint8_t arg0) {
     return acMaxPower;
 }
 
-template<class T=float>
+template<class T>
 T calcMaxPowerDc(Inverter<> *iv, uint8_t arg0) {
     DPRINTLN(DBG_VERBOSE, F("hmInverter.h:calcMaxPowerDc"));
     // arg0 = channel
@@ -1268,7 +1469,7 @@ T calcMaxPowerDc(Inverter<> *iv, uint8_t arg0) {
     return dcMaxPower;
 }
 
-template<class T=float>
+template<class T>
 T calcMaxTemperature(Inverter<> *iv, uint8_t arg0) {
     DPRINTLN(DBG_VERBOSE, F("hmInverter.h:calcMaxTemperature"));
     // arg0 = channel
@@ -47,10 +47,7 @@ class Simulator {
 
             record_t<> *rec = iv->getRecordStruct(cmd);
             rec->ts = *mTimestamp;
-            for (uint8_t i = 0; i < rec->length; i++) {
-                iv->addValue(i, payload, rec);
-                yield();
-            }
+            iv->addValues(payload, rec);
             iv->doCalculations();
 
             if((nullptr != mCbPayload) && (GridOnProFilePara != cmd))
@@ -160,6 +160,7 @@ class CmtRadio : public Radio {
                 }
             }
 
+            traceTx(len, mCmt.getCurrentChannel());
             CmtStatus status = mCmt.tx(mTxBuf.data(), len);
             mMillis = millis();
             if(CmtStatus::SUCCESS != status) {
@@ -214,16 +215,18 @@ class CmtRadio : public Radio {
         }
 
         inline void getRx(void) {
-            packet_t p;
-            p.millis = millis() - mMillis;
-            if(CmtStatus::SUCCESS == mCmt.getRx(p.packet, &p.len, 28, &p.rssi)) {
-                p.ch = 0; // not used for CMT inverters
-                mBufCtrl.push(p);
-            }
-
-            if(p.packet[9] > ALL_FRAMES) { // indicates last frame
-                setExpectedFrames(p.packet[9] - ALL_FRAMES);
-                mRadioWaitTime.startTimeMonitor(2); // let the inverter first get back to rx mode?
+            packet_t *p = mBufCtrl.reserve(); // filled in place
+            p->millis = getRxMillis();
+            if(CmtStatus::SUCCESS == mCmt.getRx(p->packet, &p->len, 28, &p->rssi)) {
+                p->ch = 0; // not used for CMT inverters
+                traceRx(p);
+                if(!mBufCtrl.commit())
+                    DPRINTLN(DBG_WARN, F("RX buffer full"));
+
+                if(p->packet[9] > ALL_FRAMES) { // indicates last frame
+                    setExpectedFrames(p->packet[9] - ALL_FRAMES);
+                    mRadioWaitTime.startTimeMonitor(2); // let the inverter first get back to rx mode?
+                }
             }
         }
 
@@ -231,7 +234,6 @@ class CmtRadio : public Radio {
         cfgCmt_t *mCfg = nullptr;
         bool mCmtAvail = false;
         bool mRqstGetRx = false;
-        uint32_t mMillis = 0;
 
         Inverter<> *mCatchIv = nullptr;
         uint8_t mCatchIvCh = 0;
@@ -11,7 +11,7 @@
 //-------------------------------------
 // HMS-350, HMS-500
 //-------------------------------------
-const byteAssign_t hms1chAssignment[] = {
+constexpr byteAssign_t hms1chAssignment[] = {
     { FLD_UDC, UNIT_V,    CH1,  2, 2,   10 },
     { FLD_IDC, UNIT_A,    CH1,  4, 2,  100 },
     { FLD_PDC, UNIT_W,    CH1,  6, 2,   10 },
@@ -42,7 +42,7 @@ const byteAssign_t hms1chAssignment[] = {
 //-------------------------------------
 // HMS-800, HMS-1000
 //-------------------------------------
-const byteAssign_t hms2chAssignment[] = {
+constexpr byteAssign_t hms2chAssignment[] = {
     { FLD_UDC, UNIT_V,    CH1,  2, 2,   10 },
     { FLD_IDC, UNIT_A,    CH1,  6, 2,  100 },
     { FLD_PDC, UNIT_W,    CH1, 10, 2,   10 },
@@ -80,7 +80,7 @@ const byteAssign_t hms2chAssignment[] = {
 //-------------------------------------
 // HMS-1800, HMS-2000
 //-------------------------------------
-const byteAssign_t hms4chAssignment[] = {
+constexpr byteAssign_t hms4chAssignment[] = {
     { FLD_UDC, UNIT_V,    CH1,  2, 2,   10 },
     { FLD_IDC, UNIT_A,    CH1,  6, 2,  100 },
     { FLD_PDC, UNIT_W,    CH1, 10, 2,   10 },
@@ -134,7 +134,7 @@ const byteAssign_t hms4chAssignment[] = {
 //-------------------------------------
 // HMT-1600, HMT-1800, HMT-2000
 //-------------------------------------
-const byteAssign_t hmt4chAssignment[] = {
+constexpr byteAssign_t hmt4chAssignment[] = {
     { FLD_UDC, UNIT_V,   CH1,  2, 2,   10 },
     { FLD_IDC, UNIT_A,   CH1,  4, 2,  100 },
     { FLD_PDC, UNIT_W,   CH1,  8, 2,   10 },
@@ -195,7 +195,7 @@ const byteAssign_t hmt4chAssignment[] = {
 //-------------------------------------
 // HMT-1800, HMT-2250
 //-------------------------------------
-const byteAssign_t hmt6chAssignment[] = {
+constexpr byteAssign_t hmt6chAssignment[] = {
     { FLD_UDC, UNIT_V,   CH1,  2, 2,   10 },
     { FLD_IDC, UNIT_A,   CH1,  4, 2,  100 },
     { FLD_PDC, UNIT_W,   CH1,  8, 2,   10 },
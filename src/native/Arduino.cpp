@@ -0,0 +1,67 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#include <cstdarg>
+#include "Arduino.h"
+#include "LittleFS.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+NativeFS LittleFS;
+
+static uint64_t mVirtualMicros = 0;
+
+namespace native {
+    void advanceMicros(uint64_t us) {
+        mVirtualMicros += us;
+    }
+
+    void advanceMillis(uint32_t ms) {
+        mVirtualMicros += (uint64_t)ms * 1000ULL;
+    }
+
+    uint64_t getMicros(void) {
+        return mVirtualMicros;
+    }
+}
+
+uint32_t millis(void) {
+    return (uint32_t)(mVirtualMicros / 1000ULL);
+}
+
+uint32_t micros(void) {
+    return (uint32_t)mVirtualMicros;
+}
+
+void delay(uint32_t ms) {
+    native::advanceMillis(ms);
+}
+
+void delayMicroseconds(uint32_t us) {
+    native::advanceMicros(us);
+}
+
+size_t Print::printf(const char *fmt, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if(len < 0)
+        return 0;
+    return write(reinterpret_cast<const uint8_t *>(buf), std::min((size_t)len, sizeof(buf) - 1));
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t size) {
+    return fwrite(buf, 1, size, stdout);
+}
+
+void HardwareSerial::flush(void) {
+    fflush(stdout);
+}
@@ -0,0 +1,255 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+// minimal Arduino API for the host build ([env:native]), only what the
+// communication stack (hm/, hms/, utils/) needs. Time is virtual and is
+// advanced by the driver, see native::advanceMicros()
+
+#ifndef __NATIVE_ARDUINO_H__
+#define __NATIVE_ARDUINO_H__
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cassert>
+#include <string>
+#include <algorithm>
+#include <type_traits>
+#include <queue>
+#include <memory>
+#include <functional>
+
+#define HEX 16
+#define DEC 10
+#define OCT 8
+#define BIN 2
+
+#define HIGH            0x1
+#define LOW             0x0
+#define INPUT           0x01
+#define OUTPUT          0x03
+#define INPUT_PULLUP    0x04
+#define RISING          0x01
+#define FALLING         0x02
+
+#define PROGMEM
+#define PGM_P                   const char *
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+#define pgm_read_byte(addr)     (*reinterpret_cast<const uint8_t *>(addr))
+#define pgm_read_word(addr)     (*reinterpret_cast<const uint16_t *>(addr))
+#define pgm_read_dword(addr)    (*reinterpret_cast<const uint32_t *>(addr))
+#define strlen_P                strlen
+#define strncpy_P               strncpy
+#define strcmp_P                strcmp
+#define memcpy_P                memcpy
+
+// there is no flash on the host, F() strings are plain C strings
+typedef char __FlashStringHelper;
+#define F(sl) (sl)
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+//-----------------------------------------------------------------------------
+namespace native {
+    void advanceMicros(uint64_t us);
+    void advanceMillis(uint32_t ms);
+    uint64_t getMicros(void);
+}
+
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+inline void yield(void) {}
+
+inline void pinMode(uint8_t pin, uint8_t mode) {}
+inline void digitalWrite(uint8_t pin, uint8_t val) {}
+inline int digitalRead(uint8_t pin) { return LOW; }
+inline void analogWrite(uint8_t pin, int val) {}
+inline void attachInterrupt(uint8_t irq, std::function<void(void)> cb, int mode) {}
+inline uint8_t digitalPinToInterrupt(uint8_t pin) { return pin; }
+
+//-----------------------------------------------------------------------------
+class String {
+    public:
+        String() {}
+        String(const char *str) : mStr((nullptr == str) ? "" : str) {}
+        String(const std::string &str) : mStr(str) {}
+        explicit String(char c) : mStr(1, c) {}
+
+        template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, char>::value, int>::type = 0>
+        explicit String(T val, unsigned char base = 10) {
+            char buf[68];
+            if((10 == base) && std::is_signed<T>::value)
+                snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(val));
+            else
+                toBase(static_cast<unsigned long long>(val), base, buf);
+            mStr = buf;
+        }
+
+        explicit String(double val, unsigned int decimalPlaces = 2) {
+            char buf[40];
+            snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, val);
+            mStr = buf;
+        }
+
+        const char *c_str() const { return mStr.c_str(); }
+        unsigned int length() const { return mStr.length(); }
+        bool isEmpty() const { return mStr.empty(); }
+        bool reserve(unsigned int size) { mStr.reserve(size); return true; }
+
+        bool concat(const String &str) { mStr += str.mStr; return true; }
+        bool concat(const char *str) { if(nullptr != str) mStr += str; return true; }
+        bool concat(char c) { mStr += c; return true; }
+
+        String& operator += (const String &str) { concat(str); return *this; }
+        String& operator += (const char *str) { concat(str); return *this; }
+        String& operator += (char c) { concat(c); return *this; }
+
+        bool operator == (const String &rhs) const { return mStr == rhs.mStr; }
+        bool operator == (const char *rhs) const { return mStr == ((nullptr == rhs) ? "" : rhs); }
+        bool operator != (const String &rhs) const { return mStr != rhs.mStr; }
+        bool operator != (const char *rhs) const { return !(*this == rhs); }
+        bool operator < (const String &rhs) const { return mStr < rhs.mStr; }
+
+        char operator [] (unsigned int index) const { return (index < mStr.length()) ? mStr[index] : 0; }
+        char charAt(unsigned int index) const { return (*this)[index]; }
+
+        int indexOf(char c, unsigned int from = 0) const {
+            size_t pos = mStr.find(c, from);
+            return (std::string::npos == pos) ? -1 : static_cast<int>(pos);
+        }
+        int indexOf(const String &str, unsigned int from = 0) const {
+            size_t pos = mStr.find(str.mStr, from);
+            return (std::string::npos == pos) ? -1 : static_cast<int>(pos);
+        }
+        String substring(unsigned int from) const {
+            return (from >= mStr.length()) ? String() : String(mStr.substr(from));
+        }
+        String substring(unsigned int from, unsigned int to) const {
+            if(from > to)
+                std::swap(from, to);
+            return (from >= mStr.length()) ? String() : String(mStr.substr(from, to - from));
+        }
+        bool startsWith(const String &str) const { return 0 == mStr.rfind(str.mStr, 0); }
+        bool endsWith(const String &str) const {
+            return (mStr.length() >= str.mStr.length())
+                && (0 == mStr.compare(mStr.length() - str.mStr.length(), str.mStr.length(), str.mStr));
+        }
+        void replace(const String &find, const String &repl) {
+            if(find.mStr.empty())
+                return;
+            size_t pos = 0;
+            while(std::string::npos != (pos = mStr.find(find.mStr, pos))) {
+                mStr.replace(pos, find.mStr.length(), repl.mStr);
+                pos += repl.mStr.length();
+            }
+        }
+        void toUpperCase() { std::transform(mStr.begin(), mStr.end(), mStr.begin(), ::toupper); }
+        void toLowerCase() { std::transform(mStr.begin(), mStr.end(), mStr.begin(), ::tolower); }
+        void trim() {
+            mStr.erase(0, mStr.find_first_not_of(" \t\r\n"));
+            mStr.erase(mStr.find_last_not_of(" \t\r\n") + 1);
+        }
+        long toInt() const { return atol(mStr.c_str()); }
+        float toFloat() const { return static_cast<float>(atof(mStr.c_str())); }
+
+    private:
+        static void toBase(unsigned long long val, unsigned char base, char *buf) {
+            char tmp[66];
+            uint8_t i = 0;
+            if((base < 2) || (base > 36))
+                base = 10;
+            do {
+                uint8_t d = val % base;
+                tmp[i++] = (d < 10) ? ('0' + d) : ('a' + d - 10);
+                val /= base;
+            } while(0 != val);
+            for(uint8_t j = 0; j < i; j++)
+                buf[j] = tmp[i - 1 - j];
+            buf[i] = '\0';
+        }
+
+    private:
+        std::string mStr;
+};
+
+class StringSumHelper : public String {
+    public:
+        StringSumHelper(const String &s) : String(s) {}
+        StringSumHelper(const char *s) : String(s) {}
+};
+
+inline StringSumHelper operator + (const String &lhs, const String &rhs) { String s(lhs); s += rhs; return s; }
+inline StringSumHelper operator + (const String &lhs, const char *rhs) { String s(lhs); s += rhs; return s; }
+inline StringSumHelper operator + (const char *lhs, const String &rhs) { String s(lhs); s += rhs; return s; }
+inline StringSumHelper operator + (const String &lhs, char rhs) { String s(lhs); s += rhs; return s; }
+
+//-----------------------------------------------------------------------------
+class Print {
+    public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t *buf, size_t size) {
+            size_t n = 0;
+            while(size--)
+                n += write(*buf++);
+            return n;
+        }
+
+        size_t print(const String &str) { return write(reinterpret_cast<const uint8_t *>(str.c_str()), str.length()); }
+        size_t print(const char *str) { return write(reinterpret_cast<const uint8_t *>(str), strlen(str)); }
+        size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+        template <typename T, typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, char>::value, int>::type = 0>
+        size_t print(T val, int base = DEC) {
+            if(std::is_floating_point<T>::value)
+                return print(String(static_cast<double>(val), (DEC == base) ? 2 : base));
+            return print(String(static_cast<long long>(val), static_cast<unsigned char>(base)));
+        }
+
+        size_t println(void) { return print("\r\n"); }
+        template <typename T>
+        size_t println(T val) { size_t n = print(val); return n + println(); }
+        template <typename T>
+        size_t println(T val, int base) { size_t n = print(val, base); return n + println(); }
+
+        size_t printf(const char *fmt, ...) __attribute__ ((format (printf, 2, 3)));
+
+        virtual void flush(void) {}
+};
+
+class HardwareSerial : public Print {
+    public:
+        void begin(unsigned long baud) {}
+        int available(void) { return 0; }
+        int read(void) { return -1; }
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t *buf, size_t size) override;
+        void flush(void) override;
+        operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+//-----------------------------------------------------------------------------
+class EspClass {
+    public:
+        uint32_t getFreeHeap(void) { return 200000; }
+        uint32_t getMaxFreeBlockSize(void) { return 100000; }
+        uint32_t getMaxAllocHeap(void) { return 100000; }
+        uint8_t getHeapFragmentation(void) { return 0; }
+        uint32_t getChipId(void) { return 0x00c0ffee; }
+        uint64_t getEfuseMac(void) { return 0x0000c0ffee00ULL; }
+        uint32_t getCpuFreqMHz(void) { return 0; }
+        void restart(void) { exit(0); }
+};
+
+extern EspClass ESP;
+
+#endif /*__NATIVE_ARDUINO_H__*/
@@ -0,0 +1,17 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+// the web server is not part of the host build, appInterface.h only needs
+// ArduinoJson to be available at this point
+
+#ifndef __NATIVE_ESP_ASYNC_WEBSERVER_H__
+#define __NATIVE_ESP_ASYNC_WEBSERVER_H__
+
+#include "Arduino.h"
+#include <ArduinoJson.h>
+
+class AsyncWebServerRequest;
+
+#endif /*__NATIVE_ESP_ASYNC_WEBSERVER_H__*/
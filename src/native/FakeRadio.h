@@ -0,0 +1,258 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __FAKE_RADIO_H__
+#define __FAKE_RADIO_H__
+
+#include <array>
+#include <map>
+#include <vector>
+#include "../hm/hmInverter.h"
+#include "../hm/Radio.h"
+
+#define FAKE_FRAGMENT_LEN       16  // payload bytes per fragment, like HM inverters
+#define FAKE_MAX_PENDING        MAX_PAYLOAD_ENTRIES
+
+//-----------------------------------------------------------------------------
+// scriptable radio for the host build. Answers all requests of HM / HMS / HMT
+// type inverters with synthesized or preset payloads. Timing, fragment loss and
+// CRC errors are configurable, all random decisions are deterministic (seed)
+//-----------------------------------------------------------------------------
+class FakeRadio : public Radio {
+    public:
+        typedef struct {
+            uint16_t firstFrameMs = 20;  // time from TX till first fragment
+            uint16_t nextFrameMs  = 6;   // time between fragments
+            uint8_t dropRate      = 0;   // fragment loss in percent
+            uint8_t crcErrRate    = 0;   // fragments with broken CRC8 in percent
+            uint8_t noAnswerRate  = 0;   // requests without any answer in percent
+            uint8_t chDropRate[RF_MAX_CHANNEL_ID] = {0}; // additional loss per TX channel id
+            uint32_t stableIvMask = 0;   // inverters (bit per id) which answer constant values
+            uint8_t rxOffset      = 3;   // channel id offset of the answers to the TX channel
+        } profile_t;
+
+        typedef struct {
+            uint32_t txCnt;
+            uint32_t rxCnt;
+            uint32_t dropCnt;
+            uint32_t crcErrCnt;
+            uint32_t noAnswerCnt;
+        } stats_t;
+
+    public:
+        FakeRadio() {
+            memset(&mStats, 0, sizeof(stats_t));
+        }
+
+        void setup(bool *serialDebug, bool *privacyMode, bool *printWholeTrace, uint32_t seed = 1) {
+            mSerialDebug     = serialDebug;
+            mPrivacyMode     = privacyMode;
+            mPrintWholeTrace = printWholeTrace;
+            mRand            = (0 == seed) ? 1 : seed;
+            generateDtuSn();
+            mIrqOk = IRQ_OK;
+        }
+
+        void loop(void) override {
+            while(mPendingRd < mPending.size()) {
+                pending_t *p = &mPending[mPendingRd];
+                if((int32_t)(millis() - p->due) < 0)
+                    return;
+                mPendingRd++;
+                deliver(p);
+            }
+        }
+
+        bool isChipConnected(void) const override {
+            return true;
+        }
+
+        void sendControlPacket(Inverter<> *iv, uint8_t cmd, uint16_t *data, bool isRetransmit) override {
+            initPacket(iv->radioId.u64, TX_REQ_DEVCONTROL, SINGLE_FRAME);
+            uint8_t cnt = 10;
+            mTxBuf[cnt++] = cmd;
+            mTxBuf[cnt++] = 0x00;
+            if(cmd >= ActivePowerContr && cmd <= PFSet) {
+                mTxBuf[cnt++] = (data[0] >> 8) & 0xff;
+                mTxBuf[cnt++] = (data[0]     ) & 0xff;
+                mTxBuf[cnt++] = (data[1] >> 8) & 0xff;
+                mTxBuf[cnt++] = (data[1]     ) & 0xff;
+            }
+            sendPacket(iv, cnt, isRetransmit, true);
+        }
+
+        // preset the answer for a command, otherwise a payload is synthesized
+        void setPayload(uint8_t cmd, const uint8_t buf[], uint8_t len) {
+            mPreset[cmd].assign(buf, buf + len);
+        }
+
+        profile_t *getProfile(void) {
+            return &mProfile;
+        }
+
+        const stats_t *getStats(void) const {
+            return &mStats;
+        }
+
+        bool isIdle(void) const {
+            return mPendingRd >= mPending.size();
+        }
+
+    private:
+        typedef struct {
+            Inverter<> *iv;
+            uint32_t due;
+            uint8_t txChId;
+            bool isLast;
+            packet_t p;
+        } pending_t;
+
+        void sendPacket(Inverter<> *iv, uint8_t len, bool isRetransmit, bool appendCrc16=true) override {
+            updateCrcs(&len, appendCrc16);
+            traceTx(len, mRfChLst[iv->heuristics.txRfChId % RF_MAX_CHANNEL_ID]);
+            mStats.txCnt++;
+            iv->mDtuTxCnt++;
+            mTxMillis = millis();
+
+            // a new request always aborts the outstanding answer
+            mPending.clear();
+            mPendingRd = 0;
+
+            if(IV_MI == iv->ivGen)
+                return; // MI protocol is not simulated
+
+            if(random(100) < mProfile.noAnswerRate) {
+                mStats.noAnswerCnt++;
+                return;
+            }
+
+            if(TX_REQ_DEVCONTROL == mTxBuf[0]) {
+                uint8_t pld[4] = {0x00, 0x00, mTxBuf[10], 0x00};
+                addFragment(iv, TX_REQ_DEVCONTROL + ALL_FRAMES, SINGLE_FRAME, pld, 4, 0, true);
+            } else if(TX_REQ_INFO == mTxBuf[0]) {
+                if(ALL_FRAMES == mTxBuf[9]) {
+                    buildAnswer(iv, mTxBuf[10]);
+                    uint8_t frames = (mAnswerLen + FAKE_FRAGMENT_LEN - 1) / FAKE_FRAGMENT_LEN;
+                    for(uint8_t i = 0; i < frames; i++)
+                        addFragmentOfAnswer(iv, i, frames, i, false);
+                } else if(mTxBuf[9] > ALL_FRAMES) { // retransmit of a single fragment
+                    uint8_t frames = (mAnswerLen + FAKE_FRAGMENT_LEN - 1) / FAKE_FRAGMENT_LEN;
+                    uint8_t i = mTxBuf[9] - SINGLE_FRAME;
+                    if(i < frames)
+                        addFragmentOfAnswer(iv, i, frames, 0, true);
+                }
+            }
+        }
+
+        uint64_t getIvId(Inverter<> *iv) const override {
+            return iv->radioId.u64;
+        }
+
+        uint8_t getIvGen(Inverter<> *iv) const override {
+            return iv->ivGen;
+        }
+
+        void buildAnswer(Inverter<> *iv, uint8_t cmd) {
+            if(mPreset.end() != mPreset.find(cmd)) {
+                mAnswerLen = mPreset[cmd].size();
+                std::copy(mPreset[cmd].begin(), mPreset[cmd].end(), mAnswer.begin());
+            } else {
+                record_t<> *rec = iv->getRecordStruct(cmd);
+                switch(cmd) {
+                    case GridOnProFilePara: mAnswerLen = 70; break;
+                    case GetLossRate:       mAnswerLen = HMGETLOSSRATE_PAYLOAD_LEN; break;
+                    case AlarmData:         mAnswerLen = 2; break; // no alarm entries
+                    default:
+                        mAnswerLen = ((nullptr != rec) && (0 != rec->pyldLen)) ? rec->pyldLen : 14;
+                        break;
+                }
+
+                // small but changing values to keep all calculations in range
+                uint8_t cnt = (mProfile.stableIvMask & (1UL << iv->id)) ? 0 : ++mAnswerCnt;
+                for(uint8_t i = 0; i < mAnswerLen; i++)
+                    mAnswer[i] = (i & 0x01) ? ((i * 7 + cnt) & 0x7f) : 0x00;
+            }
+
+            uint16_t crc = ah::crc16(mAnswer.data(), mAnswerLen);
+            mAnswer[mAnswerLen++] = (crc >> 8) & 0xff;
+            mAnswer[mAnswerLen++] = (crc     ) & 0xff;
+        }
+
+        void addFragmentOfAnswer(Inverter<> *iv, uint8_t i, uint8_t frames, uint8_t slot, bool single) {
+            uint8_t pos = i * FAKE_FRAGMENT_LEN;
+            uint8_t len = std::min((uint8_t)FAKE_FRAGMENT_LEN, (uint8_t)(mAnswerLen - pos));
+            bool isLast = ((i + 1) == frames);
+            uint8_t frameId = (i + 1) | (isLast ? ALL_FRAMES : 0x00);
+            addFragment(iv, TX_REQ_INFO + ALL_FRAMES, frameId, &mAnswer[pos], len, slot, (isLast || single));
+        }
+
+        void addFragment(Inverter<> *iv, uint8_t mid, uint8_t frameId, const uint8_t pld[], uint8_t len, uint8_t slot, bool isLast) {
+            if(mPending.size() >= FAKE_MAX_PENDING)
+                return;
+
+            pending_t f;
+            f.iv     = iv;
+            f.due    = mTxMillis + mProfile.firstFrameMs + slot * mProfile.nextFrameMs;
+            f.isLast = isLast;
+            f.txChId = iv->heuristics.txRfChId % RF_MAX_CHANNEL_ID;
+            f.p.ch   = mRfChLst[(f.txChId + mProfile.rxOffset) % RF_MAX_CHANNEL_ID];
+            f.p.rssi = -64;
+            f.p.packet[0] = mid;
+            CP_U32_BigEndian(&f.p.packet[1], iv->radioId.u64 >> 8);
+            CP_U32_LittleEndian(&f.p.packet[5], mDtuSn);
+            f.p.packet[9] = frameId;
+            memcpy(&f.p.packet[10], pld, len);
+            f.p.len = 10 + len;
+            f.p.packet[f.p.len] = ah::crc8(f.p.packet, f.p.len);
+            f.p.len++;
+            mPending.push_back(f);
+        }
+
+        void deliver(pending_t *f) {
+            uint8_t drop = mProfile.dropRate + mProfile.chDropRate[f->txChId];
+            if(random(100) < drop) {
+                mStats.dropCnt++;
+                return;
+            }
+            if(random(100) < mProfile.crcErrRate) {
+                mStats.crcErrCnt++;
+                f->p.packet[f->p.len - 1] ^= 0xff;
+            }
+
+            f->p.millis = millis() - mTxMillis;
+            f->iv->mGotFragment = true;
+            traceRx(&f->p);
+            mBufCtrl.push(f->p);
+            mStats.rxCnt++;
+
+            if(f->isLast) {
+                f->iv->mGotLastMsg = true;
+                mRadioWaitTime.startTimeMonitor(DURATION_PAUSE_LASTFR); // same as NrfRadio after the last fragment
+            }
+        }
+
+        // xorshift32, reproducible for a given seed
+        uint32_t random(uint32_t max) {
+            mRand ^= mRand << 13;
+            mRand ^= mRand >> 17;
+            mRand ^= mRand << 5;
+            return mRand % max;
+        }
+
+    private:
+        profile_t mProfile;
+        stats_t mStats;
+        uint32_t mRand = 1;
+        uint32_t mTxMillis = 0;
+        std::vector<pending_t> mPending;
+        size_t mPendingRd = 0;
+        std::map<uint8_t, std::vector<uint8_t>> mPreset;
+        std::array<uint8_t, MAX_PAYLOAD_ENTRIES * FAKE_FRAGMENT_LEN> mAnswer;
+        uint8_t mAnswerLen = 0;
+        uint8_t mAnswerCnt = 0;
+        const uint8_t mRfChLst[RF_MAX_CHANNEL_ID] = {03, 23, 40, 61, 75};
+};
+
+#endif /*__FAKE_RADIO_H__*/
@@ -0,0 +1,135 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+// host replacement for LittleFS, files are stored below a local directory
+
+#ifndef __NATIVE_LITTLEFS_H__
+#define __NATIVE_LITTLEFS_H__
+
+#include <cstdio>
+#include <string>
+#include <sys/stat.h>
+#include "Arduino.h"
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File {
+    public:
+        File() {}
+        explicit File(FILE *fp) : mFp(fp) {}
+        File(const File&) = delete;
+        File& operator=(const File&) = delete;
+        File(File&& other) : mFp(other.mFp) { other.mFp = nullptr; }
+        File& operator=(File&& other) {
+            std::swap(mFp, other.mFp);
+            return *this;
+        }
+        ~File() { close(); }
+
+        operator bool() const { return nullptr != mFp; }
+
+        int read(void) {
+            return (nullptr == mFp) ? -1 : fgetc(mFp);
+        }
+
+        size_t read(uint8_t *buf, size_t size) {
+            return (nullptr == mFp) ? 0 : fread(buf, 1, size, mFp);
+        }
+
+        size_t readBytes(char *buf, size_t size) {
+            return read(reinterpret_cast<uint8_t *>(buf), size);
+        }
+
+        size_t write(uint8_t c) {
+            return write(&c, 1);
+        }
+
+        size_t write(const uint8_t *buf, size_t size) {
+            return (nullptr == mFp) ? 0 : fwrite(buf, 1, size, mFp);
+        }
+
+        bool seek(uint32_t pos, SeekMode mode = SeekSet) {
+            return (nullptr != mFp) && (0 == fseek(mFp, pos, mode));
+        }
+
+        size_t size(void) {
+            if(nullptr == mFp)
+                return 0;
+            long cur = ftell(mFp);
+            fseek(mFp, 0, SEEK_END);
+            long len = ftell(mFp);
+            fseek(mFp, cur, SEEK_SET);
+            return len;
+        }
+
+        int available(void) {
+            return (nullptr == mFp) ? 0 : (size() - ftell(mFp));
+        }
+
+        void close(void) {
+            if(nullptr != mFp)
+                fclose(mFp);
+            mFp = nullptr;
+        }
+
+    private:
+        FILE *mFp = nullptr;
+};
+
+class LittleFSConfig {
+    public:
+        void setAutoFormat(bool enable) {}
+};
+
+class NativeFS {
+    public:
+        void setRoot(const char *root) {
+            mRoot = root;
+        }
+
+        bool begin(bool formatOnFail = false) {
+            ::mkdir(mRoot.c_str(), 0755);
+            return true;
+        }
+
+        void end(void) {}
+        bool format(void) { return true; }
+        void setConfig(const LittleFSConfig &cfg) {}
+
+        File open(const char *path, const char *mode) {
+            std::string m(mode);
+            if(std::string::npos == m.find('b'))
+                m += 'b';
+            return File(fopen(toHost(path).c_str(), m.c_str()));
+        }
+
+        bool exists(const char *path) {
+            struct stat st;
+            return 0 == stat(toHost(path).c_str(), &st);
+        }
+
+        bool remove(const char *path) {
+            return 0 == ::remove(toHost(path).c_str());
+        }
+
+        bool rename(const char *from, const char *to) {
+            return 0 == ::rename(toHost(from).c_str(), toHost(to).c_str());
+        }
+
+        bool mkdir(const char *path) {
+            return 0 == ::mkdir(toHost(path).c_str(), 0755);
+        }
+
+    private:
+        std::string toHost(const char *path) const {
+            return mRoot + ((path[0] == '/') ? "" : "/") + path;
+        }
+
+        std::string mRoot = "native_fs";
+};
+
+extern NativeFS LittleFS;
+
+#endif /*__NATIVE_LITTLEFS_H__*/
@@ -0,0 +1,195 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __REPLAY_RADIO_H__
+#define __REPLAY_RADIO_H__
+
+#include <vector>
+#include "../hm/hmInverter.h"
+#include "../hm/Radio.h"
+#include "../hm/PacketTrace.h"
+
+//-----------------------------------------------------------------------------
+// answers requests with the RX frames of a recorded packet trace. Each TX is
+// matched against the next recorded TX with the same header (mid, inverter,
+// frame id, command); the RX frames of that inverter till its next recorded
+// TX are delivered with their original delay. Unmatched requests stay
+// unanswered. A trace of nRF and CMT inverters needs one instance per radio
+// type, each loaded with the whole trace
+//-----------------------------------------------------------------------------
+class ReplayRadio : public Radio {
+    public:
+        typedef PacketTrace::entry_t entry_t;
+
+        typedef struct {
+            uint32_t txCnt;
+            uint32_t matchCnt;
+            uint32_t missCnt;
+            uint32_t rxCnt;
+        } stats_t;
+
+    public:
+        ReplayRadio() {
+            memset(&mStats, 0, sizeof(stats_t));
+        }
+
+        bool load(const uint8_t buf[], size_t len) {
+            uint8_t numIv;
+            uint16_t cnt;
+            if(!PacketTrace::parseHeader(buf, len, &numIv, &cnt))
+                return false;
+
+            mSerial.resize(numIv);
+            for(uint8_t i = 0; i < numIv; i++)
+                mSerial[i] = PacketTrace::parseSerial(buf, i);
+            mEntries.resize(cnt);
+            for(uint16_t i = 0; i < cnt; i++)
+                PacketTrace::parseEntry(buf, numIv, i, &mEntries[i]);
+            mPos = 0;
+            return true;
+        }
+
+        void setup(bool *serialDebug, bool *privacyMode, bool *printWholeTrace) {
+            mSerialDebug     = serialDebug;
+            mPrivacyMode     = privacyMode;
+            mPrintWholeTrace = printWholeTrace;
+            generateDtuSn();
+            mIrqOk = IRQ_OK;
+        }
+
+        void loop(void) override {
+            while(mPendingRd < mPending.size()) {
+                pending_t *p = &mPending[mPendingRd];
+                if((int32_t)(millis() - p->due) < 0)
+                    return;
+                mPendingRd++;
+                deliver(p);
+            }
+        }
+
+        bool isChipConnected(void) const override {
+            return true;
+        }
+
+        void sendControlPacket(Inverter<> *iv, uint8_t cmd, uint16_t *data, bool isRetransmit) override {
+            initPacket(iv->radioId.u64, TX_REQ_DEVCONTROL, SINGLE_FRAME);
+            uint8_t cnt = 10;
+            mTxBuf[cnt++] = cmd;
+            mTxBuf[cnt++] = 0x00;
+            if(cmd >= ActivePowerContr && cmd <= PFSet) {
+                mTxBuf[cnt++] = (data[0] >> 8) & 0xff;
+                mTxBuf[cnt++] = (data[0]     ) & 0xff;
+                mTxBuf[cnt++] = (data[1] >> 8) & 0xff;
+                mTxBuf[cnt++] = (data[1]     ) & 0xff;
+            }
+            sendPacket(iv, cnt, isRetransmit, true);
+        }
+
+        const std::vector<entry_t> *getEntries(void) const {
+            return &mEntries;
+        }
+
+        const std::vector<uint64_t> *getSerials(void) const {
+            return &mSerial;
+        }
+
+        const stats_t *getStats(void) const {
+            return &mStats;
+        }
+
+        // true if the last recorded TX was matched
+        bool isDone(void) const {
+            return mPos >= mEntries.size();
+        }
+
+        // same fields as used by the matching of a TX frame
+        static bool isSameRequest(const uint8_t a[], const uint8_t b[]) {
+            return (0 == memcmp(a, b, 5)) && (a[9] == b[9]) && (a[10] == b[10]);
+        }
+
+    private:
+        typedef struct {
+            Inverter<> *iv;
+            uint32_t due;
+            bool isLast;
+            packet_t p;
+        } pending_t;
+
+        void sendPacket(Inverter<> *iv, uint8_t len, bool isRetransmit, bool appendCrc16=true) override {
+            updateCrcs(&len, appendCrc16);
+            traceTx(len, 0);
+            mStats.txCnt++;
+            iv->mDtuTxCnt++;
+
+            // a new request aborts the outstanding answer of this radio
+            mPending.clear();
+            mPendingRd = 0;
+
+            size_t tx = mPos;
+            for(; tx < mEntries.size(); tx++) {
+                if((PacketTrace::Dir::TX == mEntries[tx].dir) && isSameRequest(mEntries[tx].packet, mTxBuf.data()))
+                    break;
+            }
+            if(tx >= mEntries.size()) {
+                mStats.missCnt++;
+                return;
+            }
+            mStats.matchCnt++;
+
+            uint32_t now = millis();
+            bool singleFrame = (mTxBuf[9] > ALL_FRAMES);
+            mPos = tx + 1;
+            for(size_t i = mPos; i < mEntries.size(); i++) {
+                const entry_t *e = &mEntries[i];
+                if(0 != memcmp(&e->packet[1], &mTxBuf[1], 4))
+                    continue; // other inverter, e.g. on the other radio
+                if(PacketTrace::Dir::TX == e->dir)
+                    break;
+
+                pending_t f;
+                f.iv       = iv;
+                f.due      = now + e->rxMillis;
+                f.p.ch     = e->ch;
+                f.p.rssi   = e->rssi;
+                f.p.len    = e->len;
+                memcpy(f.p.packet, e->packet, MAX_RF_PAYLOAD_SIZE);
+                f.isLast   = singleFrame || (e->packet[9] > ALL_FRAMES) || ((TX_REQ_DEVCONTROL + ALL_FRAMES) == e->packet[0]);
+                mPending.push_back(f);
+            }
+            mTxMillis = now;
+        }
+
+        uint64_t getIvId(Inverter<> *iv) const override {
+            return iv->radioId.u64;
+        }
+
+        uint8_t getIvGen(Inverter<> *iv) const override {
+            return iv->ivGen;
+        }
+
+        void deliver(pending_t *f) {
+            f->p.millis = millis() - mTxMillis;
+            f->iv->mGotFragment = true;
+            traceRx(&f->p);
+            mBufCtrl.push(f->p);
+            mStats.rxCnt++;
+
+            if(f->isLast) {
+                f->iv->mGotLastMsg = true;
+                mRadioWaitTime.startTimeMonitor(DURATION_PAUSE_LASTFR); // same as NrfRadio after the last fragment
+            }
+        }
+
+    private:
+        stats_t mStats;
+        std::vector<uint64_t> mSerial;
+        std::vector<entry_t> mEntries;
+        size_t mPos = 0;
+        std::vector<pending_t> mPending;
+        size_t mPendingRd = 0;
+        uint32_t mTxMillis = 0;
+};
+
+#endif /*__REPLAY_RADIO_H__*/
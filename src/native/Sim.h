@@ -0,0 +1,235 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __NATIVE_SIM_H__
+#define __NATIVE_SIM_H__
+
+#include <algorithm>
+#include <map>
+#include <vector>
+#include "../hm/hmSystem.h"
+#include "../hm/Communication.h"
+#include "FakeRadio.h"
+
+#define SIM_START_TIMESTAMP     1717236000 // 2024-06-01 10:00:00 UTC
+
+//-----------------------------------------------------------------------------
+// complete communication stack (HmSystem, Communication, Heuristic) in front of
+// a radio. Time is virtual, one call of loop() is one millisecond.
+// Large (queue and records of all inverters), keep it in static storage
+// interval 0 disables the periodic requests, use enqueue() instead
+//-----------------------------------------------------------------------------
+class Sim {
+    public:
+        typedef HmSystem<MAX_NUM_INVERTERS> HmSystemType;
+
+    public:
+        // default inverters are HM-300, HM-800 and HM-1500 in turn
+        // CMT inverters (HMS / HMT) use 'cmtRadio' if set, otherwise 'radio'
+        void setup(Radio *radio, uint8_t numIv, uint16_t interval, bool serialDebug, const uint64_t serial[] = nullptr, Radio *cmtRadio = nullptr) {
+            mRadio       = radio;
+            mCmtRadio    = cmtRadio;
+            mSerialDebug = serialDebug;
+            mTimestamp   = SIM_START_TIMESTAMP;
+            mNextTick    = millis();
+            mInterval    = interval;
+            mNumIv       = std::min(numIv, (uint8_t)MAX_NUM_INVERTERS);
+            setDebugEn(serialDebug);
+
+            const uint16_t types[] = {0x1121, 0x1141, 0x1161};
+            mCfg.sendInterval = interval;
+            mCfg.readGrid     = true;
+            mCfg.adaptiveInterval = false;
+            mCfg.limitFastPath = false;
+            for(uint8_t i = 0; i < mNumIv; i++) {
+                cfgIv_t *cfg = &mCfg.iv[i];
+                cfg->enabled    = true;
+                if(nullptr != serial)
+                    cfg->serial.u64 = serial[i];
+                else
+                    cfg->serial.u64 = ((uint64_t)types[i % 3] << 32) | (0x80000000 + i);
+                cfg->powerLevel = 0xff;
+                snprintf(cfg->name, MAX_NAME_LENGTH, "sim%d", i);
+                for(uint8_t ch = 0; ch < 6; ch++)
+                    cfg->chMaxPwr[ch] = 400;
+            }
+
+            mSys.setup(&mTimestamp, &mCfg, nullptr);
+            for(uint8_t i = 0; i < mNumIv; i++)
+                mSys.addInverter(i, [this](Inverter<> *iv) {
+                    iv->radio = ((INV_RADIO_TYPE_CMT == iv->ivRadioType) && (nullptr != mCmtRadio)) ? mCmtRadio : mRadio;
+                });
+
+            #if defined(ENABLE_PACKET_TRACE)
+            mTrace.clear();
+            mRadio->setPacketTrace(&mTrace);
+            if(nullptr != mCmtRadio)
+                mCmtRadio->setPacketTrace(&mTrace);
+            #endif
+
+            mCommunication.setup(&mTimestamp, &mSerialDebug, &mPrivacyMode, &mPrintWholeTrace);
+            mCommunication.setChannelSelection(&mChSelect);
+            mCommunication.setLimitFastPath(&mCfg.limitFastPath);
+            mCommunication.addPayloadListener([this](uint8_t cmd, Inverter<> *iv) { onPayload(cmd, iv); });
+            mCommunication.addPowerLimitAckListener([](Inverter<> *iv) {});
+            mCommunication.addAlarmListener([](Inverter<> *iv) {});
+        }
+
+        // RF_CH_SEL_QUALITY or RF_CH_SEL_UCB, like cfgNrf24_t::chSelect
+        void setChannelSelection(uint8_t mode) {
+            mChSelect = mode;
+        }
+
+        // poll interval per inverter between min and max (cfgInst_t::adaptiveInterval)
+        void setAdaptiveInterval(uint16_t min, uint16_t max) {
+            mCfg.adaptiveInterval = true;
+            mCfg.minInterval      = min;
+            mCfg.maxInterval      = max;
+        }
+
+        // cfgInst_t::limitFastPath
+        void setLimitFastPath(bool en) {
+            mCfg.limitFastPath = en;
+        }
+
+        // like RestApi::setCtrl() 'limit_nonpersistent_absolute', 'limit' in 0.1 W
+        bool setPowerLimit(uint8_t id, uint16_t limit) {
+            Inverter<> *iv = mSys.getInverterByPos(id);
+            if((nullptr == iv) || (InverterStatus::OFF == iv->status))
+                return false;
+            iv->limitBox.post(limit, AbsolutNonPersistent);
+            mCommunication.addImportant(iv, ActivePowerContr);
+            return true;
+        }
+
+        // same as app::tickSend / app::sendIv
+        void tickSend(void) {
+            for(uint8_t i = 0; i < mNumIv; i++) {
+                Inverter<> *iv = mSys.getInverterByPos(i);
+                if(nullptr == iv)
+                    continue;
+                if(mCfg.adaptiveInterval) {
+                    if(!iv->pollIntvl.tick())
+                        continue;
+                    iv->startPollInterval(mCfg.minInterval, mCfg.maxInterval);
+                }
+                iv->tickSend([this, iv](uint8_t cmd, bool isDevControl) {
+                    enqueue(iv, cmd, isDevControl);
+                });
+            }
+        }
+
+        void enqueue(Inverter<> *iv, uint8_t cmd, bool isDevControl) {
+            uint16_t key = (iv->id << 8) | cmd;
+            if(mEnqueued.end() == mEnqueued.find(key))
+                mEnqueued[key] = millis();
+            if(isDevControl)
+                mCommunication.addImportant(iv, cmd);
+            else
+                mCommunication.add(iv, cmd);
+        }
+
+        void loop(void) {
+            if((0 != mInterval) && ((int32_t)(millis() - mNextTick) >= 0)) {
+                mNextTick += (mCfg.adaptiveInterval ? 1 : mInterval) * 1000;
+                tickSend();
+            }
+            mRadio->loop();
+            if(nullptr != mCmtRadio)
+                mCmtRadio->loop();
+            mCommunication.loop();
+            native::advanceMillis(1);
+            mTimestamp = SIM_START_TIMESTAMP + millis() / 1000;
+        }
+
+        void run(uint32_t durationMs) {
+            while(millis() < durationMs)
+                loop();
+        }
+
+        Inverter<> *getInverter(uint8_t id) {
+            return mSys.getInverterByPos(id);
+        }
+
+        uint8_t getNumInverters(void) const {
+            return mNumIv;
+        }
+
+        uint32_t getPayloadCnt(void) const {
+            return mPayloadCnt;
+        }
+
+        // request latency from enqueue till payload was received
+        std::vector<uint32_t> *getLatencies(void) {
+            return &mLatencies;
+        }
+
+        HmSystemType *getSystem(void) {
+            return &mSys;
+        }
+
+        uint32_t getTimestamp(void) const {
+            return mTimestamp;
+        }
+
+        Communication *getCommunication(void) {
+            return &mCommunication;
+        }
+
+        #if defined(ENABLE_PACKET_TRACE)
+        PacketTrace *getTrace(void) {
+            return &mTrace;
+        }
+
+        // writes the trace in the same format as the '/trace' download
+        bool saveTrace(const char *path) {
+            uint64_t serial[MAX_NUM_INVERTERS];
+            for(uint8_t i = 0; i < mNumIv; i++)
+                serial[i] = mCfg.iv[i].serial.u64;
+
+            std::vector<uint8_t> buf(mTrace.getDumpSize(mNumIv));
+            mTrace.dump(buf.data(), serial, mNumIv);
+            FILE *fp = fopen(path, "wb");
+            if(nullptr == fp)
+                return false;
+            bool ok = (buf.size() == fwrite(buf.data(), 1, buf.size(), fp));
+            fclose(fp);
+            return ok;
+        }
+        #endif
+
+    private:
+        void onPayload(uint8_t cmd, Inverter<> *iv) {
+            mPayloadCnt++;
+            if(RealTimeRunData_Debug == cmd)
+                iv->pollIntvl.addPower(iv->getChannelFieldValue(CH0, FLD_PAC, iv->getRecordStruct(RealTimeRunData_Debug)));
+            auto it = mEnqueued.find((iv->id << 8) | cmd);
+            if(mEnqueued.end() != it) {
+                mLatencies.push_back(millis() - it->second);
+                mEnqueued.erase(it);
+            }
+        }
+
+    private:
+        Radio *mRadio = nullptr;
+        Radio *mCmtRadio = nullptr;
+        HmSystemType mSys;
+        Communication mCommunication;
+        cfgInst_t mCfg;
+        uint32_t mTimestamp = 0;
+        uint16_t mInterval = SEND_INTERVAL;
+        uint32_t mNextTick = 0;
+        uint8_t mChSelect = RF_CH_SEL_QUALITY;
+        uint8_t mNumIv = 0;
+        bool mSerialDebug = false, mPrivacyMode = false, mPrintWholeTrace = false;
+        std::map<uint16_t, uint32_t> mEnqueued;
+        std::vector<uint32_t> mLatencies;
+        uint32_t mPayloadCnt = 0;
+        #if defined(ENABLE_PACKET_TRACE)
+        PacketTrace mTrace;
+        #endif
+};
+
+#endif /*__NATIVE_SIM_H__*/
@@ -0,0 +1,73 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+// host replacement for TimeLib + Timezone, only the calls used by utils/helper
+
+#ifndef __NATIVE_TIMEZONE_H__
+#define __NATIVE_TIMEZONE_H__
+
+#include <ctime>
+#include "Arduino.h"
+
+enum week_t {Last, First, Second, Third, Fourth};
+enum dow_t {Sun = 1, Mon, Tue, Wed, Thu, Fri, Sat};
+enum month_t {Jan = 1, Feb, Mar, Apr, May, Jun, Jul, Aug, Sep, Oct, Nov, Dec};
+
+struct TimeChangeRule {
+    char abbrev[6];
+    uint8_t week;
+    uint8_t dow;
+    uint8_t month;
+    uint8_t hour;
+    int offset;
+};
+
+namespace native {
+    inline struct tm breakTime(time_t t) {
+        struct tm tm;
+        gmtime_r(&t, &tm);
+        return tm;
+    }
+}
+
+inline int year(time_t t)      { return native::breakTime(t).tm_year + 1900; }
+inline int month(time_t t)     { return native::breakTime(t).tm_mon + 1; }
+inline int day(time_t t)       { return native::breakTime(t).tm_mday; }
+inline int hour(time_t t)      { return native::breakTime(t).tm_hour; }
+inline int minute(time_t t)    { return native::breakTime(t).tm_min; }
+inline int second(time_t t)    { return native::breakTime(t).tm_sec; }
+inline int dayOfWeek(time_t t) { return native::breakTime(t).tm_wday + 1; }
+inline int weekday(time_t t)   { return dayOfWeek(t); }
+
+inline const char *dayShortStr(uint8_t day) {
+    static const char *names[] = {"Err", "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+    return (day < 8) ? names[day] : names[0];
+}
+
+inline const char *monthShortStr(uint8_t month) {
+    static const char *names[] = {"Err", "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    return (month < 13) ? names[month] : names[0];
+}
+
+// the host always runs in UTC, the rules are only stored
+class Timezone {
+    public:
+        Timezone(TimeChangeRule dstStart, TimeChangeRule stdStart)
+            : mDst(dstStart), mStd(stdStart) {}
+
+        void setRules(TimeChangeRule dstStart, TimeChangeRule stdStart) {
+            mDst = dstStart;
+            mStd = stdStart;
+        }
+
+        time_t toLocal(time_t utc) { return utc; }
+        time_t toUTC(time_t local) { return local; }
+
+    private:
+        TimeChangeRule mDst;
+        TimeChangeRule mStd;
+};
+
+#endif /*__NATIVE_TIMEZONE_H__*/
@@ -0,0 +1,155 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include "native.h"
+#include "Sim.h"
+#include "../web/ApiStream.h"
+#include "../web/LiveDelta.h"
+
+static FakeRadio mRadio;
+static Sim mSim;
+static cfgInst_t mCfg;
+static LiveDelta mDelta;
+
+// size of the JSON document of AsyncJsonResponse in RestApi::onApi()
+#define API_DOC_SIZE_ESP8266    6000
+#define API_DOC_SIZE_ESP32      8000
+
+template<class F>
+static std::string stream(F create, size_t chunk, uint32_t *cnt) {
+    std::string out;
+    std::vector<uint8_t> buf(chunk);
+    std::shared_ptr<ApiStream> s = create();
+    *cnt = 0;
+    size_t len;
+    while(0 != (len = s->fill(buf.data(), chunk))) {
+        out.append(reinterpret_cast<char*>(buf.data()), len);
+        (*cnt)++;
+    }
+    return out;
+}
+
+template<class F>
+static bool bench(const char *name, size_t size, uint32_t rounds, bool verbose, F create) {
+    uint32_t cnt;
+    std::string ref = stream(create, 1 << 20, &cnt);
+    if(verbose)
+        printf("%s\n", ref.c_str());
+    if(stream(create, 61, &cnt) != ref) {
+        printf("%s: output differs from the output without chunks\n", name);
+        return false;
+    }
+
+    std::string out = stream(create, 1436, &cnt);
+    double start = native::wallSec();
+    size_t bytes = 0;
+    for(uint32_t i = 0; i < rounds; i++)
+        bytes += stream(create, 1436, &cnt).size();
+    double ms = (native::wallSec() - start) * 1e3;
+    printf("%-15s %7zu %7d %10zu %12.0f\n", name, ref.size(), cnt, size, (ms > 0) ? (bytes / ms) : 0);
+    return true;
+}
+
+int runApiBench(int argc, char *argv[]) {
+    static bool serialDebug = false, privacyMode = false, printWholeTrace = false;
+    uint8_t numIv   = native::getArg(argc, argv, "--iv", 4);
+    uint32_t rounds = native::getArg(argc, argv, "--rounds", 2000);
+    bool verbose    = native::hasArg(argc, argv, "-v");
+
+    mRadio.setup(&serialDebug, &privacyMode, &printWholeTrace, 1);
+    mSim.setup(&mRadio, numIv, SEND_INTERVAL, false);
+    mSim.run(millis() + 120 * 1000);
+    strncpy(mSim.getInverter(0)->config->chName[0], "south \"roof\"", MAX_NAME_LENGTH);
+    // longest escaped names
+    for(uint8_t i = 1; i < mSim.getNumInverters(); i++) {
+        Inverter<> *iv = mSim.getInverter(i);
+        memset(iv->config->name, '"', MAX_NAME_LENGTH - 1);
+        for(uint8_t ch = 0; ch < iv->channels; ch++)
+            memset(iv->config->chName[ch], '\x01', MAX_NAME_LENGTH - 1);
+    }
+    mCfg.sendInterval = SEND_INTERVAL;
+    mCfg.minInterval  = SEND_INTERVAL_MIN;
+    mCfg.maxInterval  = SEND_INTERVAL;
+
+    printf("memory per request before: JSON document %d (ESP8266) / %d (ESP32) bytes\n", API_DOC_SIZE_ESP8266, API_DOC_SIZE_ESP32);
+    printf("memory per request after:  stream object below, chunk buffer of the web server\n\n");
+    printf("%-15s %7s %7s %10s %12s\n", "endpoint", "bytes", "chunks", "memory", "bytes / ms");
+
+    Sim::HmSystemType *sys = mSim.getSystem();
+    if(!bench("inverter/list", sizeof(InverterListStream<Sim::HmSystemType>), rounds, verbose, [sys]() {
+        return std::make_shared<InverterListStream<Sim::HmSystemType>>(sys, &mCfg);
+    }))
+        return 1;
+
+    for(uint8_t id = 0; id < std::min((uint8_t)3, mSim.getNumInverters()); id++) {
+        char name[20];
+        snprintf(name, sizeof(name), "inverter/id/%d", id);
+        if(!bench(name, sizeof(InverterStream<Sim::HmSystemType>), rounds, verbose, [sys, id]() {
+            return std::make_shared<InverterStream<Sim::HmSystemType>>(sys, id);
+        }))
+            return 1;
+    }
+
+    // measured values of all inverters, binary
+    if(!bench("live/cbor", sizeof(RecordCborStream<Sim::HmSystemType>), rounds, false, [sys]() {
+        return std::make_shared<RecordCborStream<Sim::HmSystemType>>(sys, 1717236000);
+    }))
+        return 1;
+
+    // one scrape of all inverters: inverter/id/<n> of each one or live/cbor
+    uint32_t cnt;
+    size_t jsonBytes = 0, cborBytes = 0;
+    double start = native::wallSec();
+    for(uint32_t i = 0; i < rounds; i++) {
+        for(uint8_t id = 0; id < mSim.getNumInverters(); id++) {
+            jsonBytes += stream([sys, id]() {
+                return std::make_shared<InverterStream<Sim::HmSystemType>>(sys, id);
+            }, 1436, &cnt).size();
+        }
+    }
+    double jsonUs = (native::wallSec() - start) * 1e6 / rounds;
+    start = native::wallSec();
+    for(uint32_t i = 0; i < rounds; i++) {
+        cborBytes += stream([sys]() {
+            return std::make_shared<RecordCborStream<Sim::HmSystemType>>(sys, 1717236000);
+        }, 1436, &cnt).size();
+    }
+    double cborUs = (native::wallSec() - start) * 1e6 / rounds;
+    printf("\nall inverters: JSON %zu bytes in %.1f us, CBOR %zu bytes in %.1f us\n",
+        jsonBytes / rounds, jsonUs, cborBytes / rounds, cborUs);
+
+    // events of the live data pushed after each payload instead of polling
+    // inverter/id of all inverters
+    uint32_t full = 0, events = 0, polls = 0;
+    size_t deltaBytes = 0, pollBytes = 0;
+    char buf[1024];
+    for(uint8_t id = 0; id < mSim.getNumInverters(); id++)
+        full += mDelta.write(mSim.getInverter(id), buf, sizeof(buf));
+    for(uint32_t i = 0; i < 60; i++) {
+        mSim.run(millis() + SEND_INTERVAL * 1000);
+        for(uint8_t id = 0; id < mSim.getNumInverters(); id++) {
+            size_t len = mDelta.write(mSim.getInverter(id), buf, sizeof(buf));
+            if(0 != len) {
+                if(verbose)
+                    printf("%s\n", buf);
+                deltaBytes += len;
+                events++;
+            }
+            uint32_t cnt;
+            pollBytes += stream([sys, id]() {
+                return std::make_shared<InverterStream<Sim::HmSystemType>>(sys, id);
+            }, 1436, &cnt).size();
+            polls++;
+        }
+    }
+    printf("\nlive events: first %d bytes (all inverters), then %zu bytes in %d events (%zu / event)\n",
+        full, deltaBytes, events, (0 == events) ? 0 : (deltaBytes / events));
+    printf("polling:     %zu bytes in %d requests (%zu / request), memory per inverter %zu bytes\n",
+        pollBytes, polls, pollBytes / polls, sizeof(LiveDelta::last_t));
+    return 0;
+}
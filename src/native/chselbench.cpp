@@ -0,0 +1,125 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#include <cstdio>
+#include "native.h"
+#include "Sim.h"
+#include "../hm/HeuristicStore.h"
+
+typedef struct {
+    const char *name;
+    uint8_t dropRate;
+    uint8_t chDrop[RF_MAX_CHANNEL_ID];      // first half
+    uint8_t chDropLate[RF_MAX_CHANNEL_ID];  // second half
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+    {"uniform",     15, { 0,  0,  0,  0,  0}, { 0,  0,  0,  0,  0}},
+    {"one good",     5, {60, 60,  0, 60, 60}, {60, 60,  0, 60, 60}},
+    {"two bad",      5, { 0, 70,  0, 70,  5}, { 0, 70,  0, 70,  5}},
+    {"graded",       0, {30, 20, 10, 40, 50}, {30, 20, 10, 40, 50}},
+    {"drift",        5, { 0, 50, 50, 50, 50}, {50, 50, 50, 50,  0}}
+};
+
+static const uint8_t modes[] = {RF_CH_SEL_QUALITY, RF_CH_SEL_UCB};
+static const char *modeNames[] = {"quality", "ucb"};
+
+static FakeRadio mRadio[sizeof(scenarios) / sizeof(scenario_t)][2];
+static Sim mSim[sizeof(scenarios) / sizeof(scenario_t)][2];
+static FakeRadio mRestartRadio[sizeof(scenarios) / sizeof(scenario_t)][2];
+static Sim mRestart[sizeof(scenarios) / sizeof(scenario_t)][2];
+
+// first 'duration' seconds after a restart of the learned quality heuristic
+// of 'learned', without and with the values stored 12h before
+static void runRestart(uint8_t s, Sim *learned, uint8_t numIv, uint32_t duration, uint8_t rxOffset) {
+    static bool serialDebug = false, privacyMode = false, printWholeTrace = false;
+    const scenario_t *sc = &scenarios[s];
+
+    LittleFS.remove(HEU_STORE_FILE);
+    HeuristicStore<Sim::HmSystemType> store;
+    store.load(learned->getSystem(), learned->getTimestamp()); // nothing stored: enables saving
+    store.save(learned->getSystem(), learned->getTimestamp());
+
+    double res[2];
+    for(uint8_t warm = 0; warm < 2; warm++) {
+        FakeRadio *radio = &mRestartRadio[s][warm];
+        FakeRadio::profile_t *prof = radio->getProfile();
+        prof->dropRate = sc->dropRate;
+        prof->rxOffset = rxOffset;
+        memcpy(prof->chDropRate, sc->chDropLate, RF_MAX_CHANNEL_ID);
+        radio->setup(&serialDebug, &privacyMode, &printWholeTrace, 100 + s);
+
+        Sim *sim = &mRestart[s][warm];
+        sim->setup(radio, numIv, SEND_INTERVAL, false);
+        if(warm) {
+            HeuristicStore<Sim::HmSystemType> restore;
+            restore.load(sim->getSystem(), learned->getTimestamp() + 12 * 3600);
+        }
+        sim->run(millis() + duration * 1000);
+
+        uint32_t tx = 0, success = 0;
+        for(uint8_t i = 0; i < sim->getNumInverters(); i++) {
+            tx      += sim->getInverter(i)->mDtuTxCnt;
+            success += sim->getInverter(i)->radioStatistics.rxSuccess;
+        }
+        res[warm] = (0 != success) ? ((double)tx / success) : 0.0;
+    }
+    printf("%-10s %13.2f %13.2f\n", sc->name, res[0], res[1]);
+}
+
+int runChSelBench(int argc, char *argv[]) {
+    uint8_t numIv     = native::getArg(argc, argv, "--iv", 4);
+    uint32_t duration = native::getArg(argc, argv, "--duration", 4 * 3600);
+    uint8_t rxOffset  = native::getArg(argc, argv, "--rxofs", 3);
+    uint32_t restart  = native::getArg(argc, argv, "--restart", 300);
+
+    static bool serialDebug = false, privacyMode = false, printWholeTrace = false;
+    printf("nRF TX channel selection, %d inverters, %us per run, answers at RX offset %d\n", numIv, duration, rxOffset);
+    printf("scenario   mode      tx / payload  success [%%]  rx offset (learned)\n");
+    for(uint8_t s = 0; s < sizeof(scenarios) / sizeof(scenario_t); s++) {
+        const scenario_t *sc = &scenarios[s];
+        for(uint8_t m = 0; m < 2; m++) {
+            FakeRadio *radio = &mRadio[s][m];
+            FakeRadio::profile_t *prof = radio->getProfile();
+            prof->dropRate = sc->dropRate;
+            prof->rxOffset = rxOffset;
+            memcpy(prof->chDropRate, sc->chDrop, RF_MAX_CHANNEL_ID);
+            radio->setup(&serialDebug, &privacyMode, &printWholeTrace, 1 + s);
+
+            Sim *sim = &mSim[s][m];
+            sim->setup(radio, numIv, SEND_INTERVAL, false);
+            sim->setChannelSelection(modes[m]);
+            uint32_t start = millis();
+            sim->run(start + duration * 500);
+            memcpy(prof->chDropRate, sc->chDropLate, RF_MAX_CHANNEL_ID);
+            sim->run(start + duration * 1000);
+
+            uint32_t tx = 0, req = 0, success = 0;
+            char ofs[MAX_NUM_INVERTERS * 2 + 1] = {0};
+            for(uint8_t i = 0; i < sim->getNumInverters(); i++) {
+                Inverter<> *iv = sim->getInverter(i);
+                tx      += iv->mDtuTxCnt;
+                req     += iv->radioStatistics.txCnt;
+                success += iv->radioStatistics.rxSuccess;
+                uint8_t o = iv->heuristics.rxOffset;
+                ofs[i * 2]     = (RF_RX_OFFSET_NA == o) ? '-' : ('0' + o);
+                ofs[i * 2 + 1] = ' ';
+            }
+            printf("%-10s %-8s %13.2f %12.1f  %s\n", sc->name, modeNames[m],
+                (0 != success) ? ((double)tx / success) : 0.0,
+                (0 != req) ? (100.0 * success / req) : 0.0, ofs);
+        }
+    }
+
+    if(0 == restart)
+        return 0;
+    LittleFS.begin();
+    printf("\nfirst %us after a restart (quality), tx / payload\n", restart);
+    printf("scenario   cold start   stored (12h)\n");
+    for(uint8_t s = 0; s < sizeof(scenarios) / sizeof(scenario_t); s++)
+        runRestart(s, &mSim[s][0], numIv, restart, rxOffset);
+    LittleFS.remove(HEU_STORE_FILE);
+    return 0;
+}
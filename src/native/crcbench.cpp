@@ -0,0 +1,111 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#include <cstdio>
+#include <vector>
+#include "native.h"
+#include "../utils/crc.h"
+
+// bit by bit implementations up to version 0.8.152 as reference
+static uint8_t crc8Ref(const uint8_t buf[], uint8_t len) {
+    uint8_t crc = CRC8_INIT;
+    for(uint8_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for(uint8_t b = 0; b < 8; b ++) {
+            crc = (crc << 1) ^ ((crc & 0x80) ? CRC8_POLY : 0x00);
+        }
+    }
+    return crc;
+}
+
+static uint16_t crc16Ref(const uint8_t buf[], uint16_t len, uint16_t start = 0xffff) {
+    uint16_t crc = start;
+    uint8_t shift;
+
+    for(uint16_t i = 0; i < len; i ++) {
+        crc = crc ^ buf[i];
+        for(uint8_t bit = 0; bit < 8; bit ++) {
+            shift = (crc & 0x0001);
+            crc = crc >> 1;
+            if(shift != 0)
+                crc = crc ^ CRC16_MODBUS_POLYNOM;
+        }
+    }
+    return crc;
+}
+
+static volatile uint32_t mSink; // keeps the compiler from removing the loops
+
+template<class F>
+static double bytesPerUs(uint16_t len, uint32_t rounds, F fn) {
+    double start = native::wallSec();
+    for(uint32_t i = 0; i < rounds; i++)
+        mSink += fn();
+    double us = (native::wallSec() - start) * 1e6;
+    return (us > 0) ? ((double)len * rounds / us) : 0;
+}
+
+static bool verify(std::vector<uint8_t> *buf) {
+    for(uint16_t len = 0; len < buf->size(); len++) {
+        if(len < 256) {
+            if(crc8Ref(buf->data(), len) != ah::crc8(buf->data(), len))
+                return false;
+        }
+        if(crc16Ref(buf->data(), len) != ah::crc16(buf->data(), len))
+            return false;
+
+        // incremental in fragments of 16 bytes (HM inverter payload)
+        ah::Crc16 crc;
+        for(uint16_t pos = 0; pos < len; pos += 16)
+            crc.update(&(*buf)[pos], std::min(16, len - pos));
+        if(crc.get() != crc16Ref(buf->data(), len))
+            return false;
+    }
+    return true;
+}
+
+int runCrcBench(int argc, char *argv[]) {
+    uint32_t rounds = native::getArg(argc, argv, "--rounds", 200000);
+
+    std::vector<uint8_t> buf(512);
+    uint32_t x = 1;
+    for(uint8_t &b : buf) {
+        x = x * 1103515245 + 12345;
+        b = x >> 16;
+    }
+
+    if(!verify(&buf)) {
+        printf("crc: result differs from reference implementation\n");
+        return 1;
+    }
+
+    #if defined(CRC16_SLICE_BY_4)
+    printf("crc16: slice-by-4");
+    #else
+    printf("crc16: 256 entry table");
+    #endif
+    #if defined(CRC_TABLE_IN_FLASH)
+    printf(" (flash)\n");
+    #else
+    printf(" (ram)\n");
+    #endif
+
+    // TX frame, one fragment, whole RealTimeRunData_Debug payload of a HM-1500
+    const uint16_t sizes[] = {27, 16, 62, 200};
+    printf("          len   ref [B/us]   table [B/us]   speedup\n");
+    for(uint16_t len : sizes) {
+        const uint8_t *b = buf.data();
+        double ref = bytesPerUs(len, rounds, [b, len]() { return crc8Ref(b, len); });
+        double tab = bytesPerUs(len, rounds, [b, len]() { return ah::crc8(b, len); });
+        printf("crc8  %7d %12.1f %14.1f %9.1fx\n", len, ref, tab, (ref > 0) ? (tab / ref) : 0);
+    }
+    for(uint16_t len : sizes) {
+        const uint8_t *b = buf.data();
+        double ref = bytesPerUs(len, rounds, [b, len]() { return crc16Ref(b, len); });
+        double tab = bytesPerUs(len, rounds, [b, len]() { return ah::crc16(b, len); });
+        printf("crc16 %7d %12.1f %14.1f %9.1fx\n", len, ref, tab, (ref > 0) ? (tab / ref) : 0);
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#include <cstdio>
+#include <vector>
+#include "native.h"
+#include "Sim.h"
+
+#define DECODE_BENCH_PAYLOADS   64
+
+typedef struct {
+    uint64_t serial;
+    const char *name;
+} model_t;
+
+// one inverter per RealTimeRunData_Debug assignment list
+static const model_t models[] = {
+    {0x112100000001ULL, "HM-300"},
+    {0x114100000002ULL, "HM-800"},
+    {0x116100000003ULL, "HM-1500"},
+    {0x112400000004ULL, "HMS-500"},
+    {0x114400000005ULL, "HMS-1000"},
+    {0x116400000006ULL, "HMS-2000"},
+    {0x136100000007ULL, "HMT-1600"},
+    {0x138200000008ULL, "HMT-2250"}
+};
+
+static FakeRadio mRadio;
+static Sim mSim[(sizeof(models) / sizeof(model_t) + MAX_NUM_INVERTERS - 1) / MAX_NUM_INVERTERS];
+
+static void decodeRef(Inverter<> *iv, const uint8_t buf[], record_t<> *rec) {
+    for(uint8_t i = 0; i < rec->length; i++)
+        iv->addValue(i, buf, rec);
+}
+
+static void getValues(Inverter<> *iv, record_t<> *rec, std::vector<float> *val) {
+    for(uint8_t i = 0; i < rec->length; i++)
+        val->push_back(iv->getValue(i, rec));
+}
+
+// both paths have to produce the same values for the same sequence of payloads
+// (yield day offset), CMD_CALC fields are not touched by either
+static bool verify(Inverter<> *iv, const std::vector<std::vector<uint8_t>> *pld) {
+    record_t<> *rec = iv->getRecordStruct(RealTimeRunData_Debug);
+    std::vector<float> ref;
+
+    iv->resetAlarms();
+    iv->alarmMesIndex = 0;
+    for(const std::vector<uint8_t> &p : *pld) {
+        decodeRef(iv, p.data(), rec);
+        getValues(iv, rec, &ref);
+    }
+    uint16_t refAlarmIdx = iv->alarmMesIndex;
+
+    iv->resetAlarms();
+    iv->alarmMesIndex = 0;
+    std::vector<float> dec;
+    for(const std::vector<uint8_t> &p : *pld) {
+        iv->addValues(p.data(), rec);
+        getValues(iv, rec, &dec);
+    }
+    if(0 != memcmp(ref.data(), dec.data(), ref.size() * sizeof(float)))
+        return false;
+    return (refAlarmIdx == iv->alarmMesIndex);
+}
+
+// calculated values keep the resolution of the float record: efficiency
+// 5.5 W / 9.9 W and irradiation 9.9 W / 400 W with 3 decimals
+static bool verifyCalc(Inverter<> *iv) {
+    record_t<> *rec = iv->getRecordStruct(RealTimeRunData_Debug);
+    iv->config->chMaxPwr[0] = 400;
+    iv->setValue(iv->getPosByChFld(CH0, FLD_PAC, rec), rec, 5.5f);
+    iv->setValue(iv->getPosByChFld(CH1, FLD_PDC, rec), rec, 9.9f);
+    iv->doCalculations();
+    long eff = lroundf(iv->getChannelFieldValue(CH0, FLD_EFF, rec) * 1000.0f);
+    long irr = lroundf(iv->getChannelFieldValue(CH1, FLD_IRR, rec) * 1000.0f);
+    if((55556 == eff) && (2475 == irr))
+        return true;
+    printf("calculated values: efficiency %ld, irradiation %ld (x 1000), expected 55556, 2475\n", eff, irr);
+    return false;
+}
+
+template<class F>
+static double nsPerPayload(uint32_t rounds, const std::vector<std::vector<uint8_t>> *pld, F fn) {
+    double start = native::wallSec();
+    for(uint32_t i = 0; i < rounds; i++)
+        fn((*pld)[i % pld->size()].data());
+    double ns = (native::wallSec() - start) * 1e9;
+    return ns / rounds;
+}
+
+int runDecodeBench(int argc, char *argv[]) {
+    uint32_t rounds = native::getArg(argc, argv, "--rounds", 200000);
+    const uint8_t numModels = sizeof(models) / sizeof(model_t);
+
+    static bool serialDebug = false, privacyMode = false, printWholeTrace = false;
+    mRadio.setup(&serialDebug, &privacyMode, &printWholeTrace);
+
+    printf("RealTimeRunData_Debug decode [ns / payload]\n");
+    printf("model      len  fields  rec bytes   addValue   decoder   speedup\n");
+    uint32_t x = 1;
+    for(uint8_t s = 0; (s * MAX_NUM_INVERTERS) < numModels; s++) {
+        uint8_t num = std::min(numModels - s * MAX_NUM_INVERTERS, MAX_NUM_INVERTERS);
+        uint64_t serial[MAX_NUM_INVERTERS];
+        for(uint8_t i = 0; i < num; i++)
+            serial[i] = models[s * MAX_NUM_INVERTERS + i].serial;
+        mSim[s].setup(&mRadio, num, 0, false, serial);
+
+        for(uint8_t i = 0; i < num; i++) {
+            Inverter<> *iv = mSim[s].getInverter(i);
+            record_t<> *rec = iv->getRecordStruct(RealTimeRunData_Debug);
+            for(uint8_t ch = 0; ch < 6; ch++)
+                iv->config->yieldCor[ch] = 100.5 * ch;
+
+            std::vector<std::vector<uint8_t>> pld(DECODE_BENCH_PAYLOADS, std::vector<uint8_t>(rec->pyldLen));
+            for(std::vector<uint8_t> &p : pld) {
+                for(uint8_t &b : p) {
+                    x = x * 1103515245 + 12345;
+                    b = x >> 16;
+                }
+            }
+
+            const char *name = models[s * MAX_NUM_INVERTERS + i].name;
+            if((nullptr == rec->decode) || !verify(iv, &pld)) {
+                printf("%s: decoder differs from addValue\n", name);
+                return 1;
+            }
+            if((0 == s) && (0 == i) && !verifyCalc(iv))
+                return 1;
+
+            uint8_t fields = 0;
+            for(uint8_t j = 0; j < rec->length; j++) {
+                if(CMD_CALC != rec->assign[j].div)
+                    fields++;
+            }
+
+            #if defined(ENABLE_FIXED_POINT_RECORD)
+            uint16_t recBytes = fixedRec::getSize(rec->assign, rec->length);
+            #else
+            uint16_t recBytes = rec->length * sizeof(float);
+            #endif
+
+            double ref = nsPerPayload(rounds, &pld, [iv, rec](const uint8_t *b) { decodeRef(iv, b, rec); iv->isProducing(); });
+            double dec = nsPerPayload(rounds, &pld, [iv, rec](const uint8_t *b) { iv->addValues(b, rec); });
+            printf("%-9s %4d %7d %10d %10.1f %9.1f %8.1fx\n", name, rec->pyldLen, fields, recBytes, ref, dec, (dec > 0) ? (ref / dec) : 0);
+        }
+    }
+    return 0;
+}
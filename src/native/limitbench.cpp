@@ -0,0 +1,56 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#include <cstdio>
+#include "native.h"
+#include "Sim.h"
+
+static FakeRadio mRadio[2];
+static Sim mSim[2];
+
+// energy manager which sends a new limit to inverter 0 every 'period' ms
+static void run(bool fast, uint8_t numIv, uint32_t duration, uint32_t period, uint8_t noAnswer) {
+    static bool serialDebug = false, privacyMode = false, printWholeTrace = false;
+    FakeRadio *radio = &mRadio[fast];
+    radio->getProfile()->noAnswerRate = noAnswer;
+    radio->setup(&serialDebug, &privacyMode, &printWholeTrace, 1);
+
+    Sim *sim = &mSim[fast];
+    sim->setup(radio, numIv, SEND_INTERVAL, false);
+    sim->setLimitFastPath(fast);
+    sim->run(millis() + 60 * 1000); // inverters are available
+
+    uint32_t end = millis() + duration * 1000, next = millis();
+    uint16_t limit = 3000;
+    while(millis() < end) {
+        if((int32_t)(millis() - next) >= 0) {
+            next += period;
+            limit = (limit >= 6000) ? 3000 : (limit + 10);
+            sim->setPowerLimit(0, limit);
+        }
+        sim->loop();
+    }
+    sim->run(millis() + 5000); // last ack
+
+    Inverter<> *iv = sim->getInverter(0);
+    const PowerLimitMailbox::stat_t *st = iv->limitBox.getStat();
+    printf("%-9s %7d %9d %7d %7d %9d %9d %8d %9d\n", fast ? "fast path" : "queued",
+        st->reqCnt, st->coalescedCnt, st->sentCnt, st->ackCnt,
+        (0 == st->ackCnt) ? 0 : (st->sumMs / st->ackCnt), st->maxMs,
+        sim->getCommunication()->getPreemptCnt(), sim->getPayloadCnt());
+}
+
+int runLimitBench(int argc, char *argv[]) {
+    uint8_t numIv     = native::getArg(argc, argv, "--iv", 4);
+    uint32_t duration = native::getArg(argc, argv, "--duration", 600);
+    uint32_t period   = native::getArg(argc, argv, "--period", 300);
+    uint8_t noAnswer  = native::getArg(argc, argv, "--noanswer", 5);
+
+    printf("limit of inverter 0 every %d ms for %d s, %d inverter(s):\n", period, duration, numIv);
+    printf("%-9s %7s %9s %7s %7s %9s %9s %8s %9s\n", "mode", "limits", "coalesced", "sent", "acked", "avg ms", "max ms", "preempt", "payloads");
+    run(false, numIv, duration, period, noAnswer);
+    run(true, numIv, duration, period, noAnswer);
+    return 0;
+}
@@ -0,0 +1,54 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+// host entry point, build with "pio run -e native" and run
+// ".pio/build/native/program <command> [options]"
+
+#include <cstdio>
+#include <cstring>
+#include "native.h"
+
+typedef struct {
+    const char *name;
+    int (*fn)(int argc, char *argv[]);
+    const char *help;
+} command_t;
+
+static const command_t commands[] = {
+    {"sim", runSim, "run the communication stack against FakeRadio\n"
+                    "        --iv <n> --hms <n> --duration <s> --interval <s> --seed <n>\n"
+                    "        --drop <%> --crc <%> --noanswer <%> --trace <file> -v\n"
+                    "        --min <s> --max <s> (adaptive interval) --stable <n>"},
+    {"replay", runReplay, "feed a packet trace (/trace download) through the communication stack\n"
+                    "        --in <file> --gap <ms> --tail <ms> --out <file> -v\n"
+                    "        --mixed <n> --duration <s> --drop <%> --noanswer <%> (records n HM and n HMS inverters first)"},
+    {"crc", runCrcBench, "CRC8 / CRC16 throughput compared to the bitwise versions\n"
+                    "        --rounds <n>"},
+    {"decode", runDecodeBench, "RealTimeRunData_Debug decode time, addValue compared to the generated decoders\n"
+                    "        --rounds <n>"},
+    {"chsel", runChSelBench, "TX frames per payload of the nRF channel selections in several RF scenarios\n"
+                    "        --iv <n> --duration <s> --rxofs <n> --restart <s>"},
+    {"metrics", runMetricsBench, "Prometheus /metrics output, bytes per ms by chunk size\n"
+                    "        --iv <n> --rounds <n> -v"},
+    {"api", runApiBench, "streamed /api responses: size, memory per request, bytes per ms\n"
+                    "        --iv <n> --rounds <n> -v"},
+    {"mqtt", runMqttBench, "MQTT live data per inverter: one message per field compared to one batch message\n"
+                    "        --iv <n> --rounds <n> -v"},
+    {"limit", runLimitBench, "power limit ack latency of a zero export controller, with and without fast path\n"
+                    "        --iv <n> --duration <s> --period <ms> --noanswer <%>"}
+};
+
+int main(int argc, char *argv[]) {
+    const char *cmd = (argc > 1) ? argv[1] : "sim";
+    for(const command_t &c : commands) {
+        if(0 == strcmp(c.name, cmd))
+            return c.fn(argc - 1, &argv[1]);
+    }
+
+    printf("usage: %s <command> [options]\n", argv[0]);
+    for(const command_t &c : commands)
+        printf("    %s: %s\n", c.name, c.help);
+    return 1;
+}
@@ -0,0 +1,72 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#include <cstdio>
+#include <string>
+#include "native.h"
+#include "Sim.h"
+#include "../web/Prometheus.h"
+
+static FakeRadio mRadio;
+static Sim mSim;
+static Prometheus<Sim::HmSystemType> mProm;
+
+static const promInfo_t info = {"0.8.153", "AHOY-DTU", 23456, 86400, -67};
+
+// complete output in chunks of 'chunk' bytes, the number of chunks is
+// returned in 'cnt'
+static std::string scrape(size_t chunk, uint32_t *cnt) {
+    std::string out;
+    std::vector<uint8_t> buf(chunk);
+    mProm.start(info);
+    *cnt = 0;
+    size_t len;
+    while(0 != (len = mProm.fill(buf.data(), chunk))) {
+        out.append(reinterpret_cast<char*>(buf.data()), len);
+        (*cnt)++;
+    }
+    return out;
+}
+
+int runMetricsBench(int argc, char *argv[]) {
+    static bool serialDebug = false, privacyMode = false, printWholeTrace = false;
+    uint8_t numIv   = native::getArg(argc, argv, "--iv", 4);
+    uint32_t rounds = native::getArg(argc, argv, "--rounds", 2000);
+
+    mRadio.setup(&serialDebug, &privacyMode, &printWholeTrace, 1);
+    mSim.setup(&mRadio, numIv, SEND_INTERVAL, false);
+    mSim.run(millis() + 120 * 1000); // some values and statistics
+    strncpy(mSim.getInverter(0)->config->chName[0], "south", MAX_NAME_LENGTH);
+    mProm.setup(mSim.getSystem());
+
+    uint32_t cnt;
+    std::string ref = scrape(1 << 20, &cnt);
+    if(native::hasArg(argc, argv, "-v"))
+        printf("%s\n", ref.c_str());
+    printf("metrics: %d inverter(s), %zu bytes\n\n", mSim.getNumInverters(), ref.size());
+
+    // chunk sizes: tiny, TCP MSS of ESP8266 and ESP32, larger buffer
+    const size_t chunks[] = {61, 536, 1436, 5744};
+    printf("%6s %7s %12s\n", "chunk", "chunks", "bytes / ms");
+    for(size_t chunk : chunks) {
+        if(scrape(chunk, &cnt) != ref) {
+            printf("%zu: output differs from the output without chunks\n", chunk);
+            return 1;
+        }
+
+        std::vector<uint8_t> buf(chunk);
+        size_t bytes = 0;
+        double start = native::wallSec();
+        for(uint32_t i = 0; i < rounds; i++) {
+            mProm.start(info);
+            size_t len;
+            while(0 != (len = mProm.fill(buf.data(), chunk)))
+                bytes += len;
+        }
+        double ms = (native::wallSec() - start) * 1e3;
+        printf("%6zu %7d %12.0f\n", chunk, cnt, (ms > 0) ? (bytes / ms) : 0);
+    }
+    return 0;
+}
@@ -0,0 +1,178 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#include <cstdio>
+#include "native.h"
+#include "Sim.h"
+#include "../publisher/pubMqttBatch.h"
+#include "../publisher/pubMqttDiscovery.h"
+#include "../publisher/pubMqttRxQueue.h"
+
+static FakeRadio mRadio;
+static Sim mSim;
+static PubMqttBatch mBatch;
+static PubMqttDiscovery mDiscovery;
+static cfgMqtt_t mCfg;
+static cfgInst_t mCfgInst;
+
+#define TOPIC   "inverter"
+
+typedef struct {
+    uint32_t msgs;
+    size_t bytes;   // PUBLISH packets (QoS 0)
+} result_t;
+
+static void addPacket(result_t *res, const char *subTopic, const char *payload) {
+    size_t len = 2 + strlen(TOPIC) + 1 + strlen(subTopic) + strlen(payload);
+    res->bytes += 1 + ((len < 128) ? 1 : 2) + len;
+    res->msgs++;
+}
+
+// per field path of PubMqttIvData::stateSend() without JSON: one topic per
+// value and the radio statistics
+static void perField(Inverter<> *iv, record_t<> *rec, result_t *res) {
+    char subTopic[32 + MAX_NAME_LENGTH + 1];
+    char val[300];
+    for(uint8_t pos = 0; pos < rec->length; pos++) {
+        uint8_t fld = rec->assign[pos].fieldId;
+        snprintf(subTopic, sizeof(subTopic), "%s/ch%d/%s", iv->config->name, rec->assign[pos].ch, fields[fld]);
+        snprintf(val, sizeof(val), "%g", ah::round3(iv->getValue(pos, rec)));
+        if((FLD_EVT != fld) && (FLD_LAST_ALARM_CODE != fld))
+            addPacket(res, subTopic, val);
+    }
+    snprintf(subTopic, sizeof(subTopic), "%s/radio_stat", iv->config->name);
+    snprintf(val, sizeof(val), "{\"tx\":%d,\"success\":%d,\"fail\":%d,\"no_answer\":%d,\"retransmits\":%d,\"lossIvRx\":%d,\"lossIvTx\":%d,\"lossDtuRx\":%d,\"lossDtuTx\":%d}",
+        iv->radioStatistics.txCnt, iv->radioStatistics.rxSuccess, iv->radioStatistics.rxFail,
+        iv->radioStatistics.rxFailNoAnswer, iv->radioStatistics.retransmits, iv->radioStatistics.ivLoss,
+        iv->radioStatistics.ivSent, iv->radioStatistics.dtuLoss, iv->radioStatistics.dtuSent);
+    addPacket(res, subTopic, val);
+}
+
+static void batch(Inverter<> *iv, record_t<> *rec, result_t *res) {
+    char subTopic[32 + MAX_NAME_LENGTH + 1];
+    const char *msg = mBatch.format(iv, rec);
+    snprintf(subTopic, sizeof(subTopic), "%s/data", iv->config->name);
+    if(nullptr != msg)
+        addPacket(res, subTopic, msg);
+}
+
+template<class F>
+static void bench(const char *name, uint32_t rounds, F fn) {
+    result_t res = {0, 0};
+    uint8_t num = mSim.getNumInverters();
+    double start = native::wallSec();
+    for(uint32_t i = 0; i < rounds; i++) {
+        for(uint8_t id = 0; id < num; id++) {
+            Inverter<> *iv = mSim.getInverter(id);
+            fn(iv, iv->getRecordStruct(RealTimeRunData_Debug), &res);
+        }
+    }
+    double us = (native::wallSec() - start) * 1e6 / rounds / num;
+    printf("%-10s %9.1f %9zu %9d\n", name, us, res.bytes / rounds / num, res.msgs / rounds / num);
+}
+
+// Home Assistant discovery: everything is published on the first sweep, on
+// reconnect only the hashes of the inverters are compared
+static void discovery(uint32_t rounds, bool verbose) {
+    char topic[MQTT_DISCOVERY_TOPIC_LEN], buf[MQTT_DISCOVERY_BUF_SIZE];
+    result_t res = {0, 0};
+    uint8_t num = mSim.getNumInverters();
+    uint32_t hash = 0;
+    double start = native::wallSec();
+    for(uint32_t i = 0; i < rounds; i++) {
+        for(uint8_t id = 0; id <= num; id++) {
+            Inverter<> *iv = (id < num) ? mSim.getInverter(id) : nullptr;
+            uint8_t cnt = (nullptr != iv) ? iv->getRecordStruct(RealTimeRunData_Debug)->length : MQTT_DISCOVERY_TOTAL_CNT;
+            hash = PubMqttDiscovery::HASH_INIT;
+            for(uint8_t sub = 0; sub < cnt; sub++) {
+                bool ok = (nullptr != iv) ? mDiscovery.format(iv, sub, topic, buf) : mDiscovery.formatTotal(sub, topic, buf);
+                if(!ok)
+                    continue;
+                hash = PubMqttDiscovery::hash(PubMqttDiscovery::hash(hash, topic), buf);
+                if((0 == i) && ((nullptr == iv) || (FLD_EVT != iv->getRecordStruct(RealTimeRunData_Debug)->assign[sub].fieldId))) {
+                    size_t len = 2 + strlen(topic) + strlen(buf);
+                    res.bytes += 1 + ((len < 128) ? 1 : 2) + len;
+                    res.msgs++;
+                    if(verbose)
+                        printf("%s %s\n", topic, buf);
+                }
+            }
+        }
+    }
+    double us = (native::wallSec() - start) * 1e6 / rounds;
+    printf("discovery of %d inverter(s) and total: %d messages, %zu bytes, %.1f us to hash (last %08x)\n", num, res.msgs, res.bytes, us, hash);
+}
+
+// burst of power limits for all inverters (energy manager) and a few other
+// control messages before the loop gets the queue
+static void rxBurst(uint8_t num, uint16_t limits) {
+    PubMqttRxQueue queue;
+    PubMqttRxQueue::message_t msg;
+    char topic[MQTT_RX_TOPIC_LEN], val[16];
+    uint32_t handled = 0;
+    for(uint16_t i = 0; i < limits; i++) {
+        snprintf(topic, sizeof(topic), "%s/ctrl/limit/%d", TOPIC, i % num);
+        snprintf(val, sizeof(val), "%dW", 200 + i);
+        queue.push(topic, (const uint8_t*)val, strlen(val), 0, strlen(val));
+        if(0 == (i % 25)) {
+            snprintf(topic, sizeof(topic), "%s/ctrl/restart/%d", TOPIC, i % 7);
+            queue.push(topic, (const uint8_t*)"1", 1, 0, 1);
+        }
+    }
+    while(queue.pop(&msg))
+        handled++;
+    printf("rx burst of %d limits: %d handled, %d merged, %d dropped, %zu bytes static\n", limits, handled, queue.getCoalescedCnt(), queue.getDroppedCnt(), sizeof(queue));
+}
+
+// limit, restart, limit of one inverter: the restart is handled before the
+// newer limit, a payload larger than a slot is counted
+static bool rxOrder(void) {
+    PubMqttRxQueue queue;
+    PubMqttRxQueue::message_t msg;
+    const char *seq[][2] = {{"ctrl/limit/0", "100W"}, {"ctrl/restart/0", "1"}, {"ctrl/limit/0", "200W"}};
+    char topic[MQTT_RX_TOPIC_LEN];
+    for(const auto &m : seq) {
+        snprintf(topic, sizeof(topic), "%s/%s", TOPIC, m[0]);
+        queue.push(topic, (const uint8_t*)m[1], strlen(m[1]), 0, strlen(m[1]));
+    }
+    uint8_t large[MQTT_RX_PAYLOAD_LEN + 1] = {0};
+    queue.push(topic, large, sizeof(large), 0, sizeof(large));
+
+    bool ok = queue.pop(&msg) && (nullptr != strstr(msg.topic, "restart"));
+    ok = ok && queue.pop(&msg) && (4 == msg.len) && (0 == memcmp(msg.payload, "200W", 4));
+    ok = ok && !queue.pop(&msg) && (1 == queue.getTooLargeCnt());
+    if(!ok)
+        printf("rx queue: wrong order of limit and restart or too large payload not counted\n");
+    return ok;
+}
+
+int runMqttBench(int argc, char *argv[]) {
+    static bool serialDebug = false, privacyMode = false, printWholeTrace = false;
+    uint8_t numIv   = native::getArg(argc, argv, "--iv", 4);
+    uint32_t rounds = native::getArg(argc, argv, "--rounds", 5000);
+
+    snprintf(mCfg.topic, MQTT_TOPIC_LEN, "%s", TOPIC);
+    mCfgInst.sendInterval = SEND_INTERVAL;
+    mDiscovery.setup(&mCfg, &mCfgInst, "AHOY-DTU");
+    mDiscovery.setIp("192.168.0.10");
+    mRadio.setup(&serialDebug, &privacyMode, &printWholeTrace, 1);
+    mSim.setup(&mRadio, numIv, SEND_INTERVAL, false);
+    mSim.run(millis() + 120 * 1000);
+
+    if(native::hasArg(argc, argv, "-v")) {
+        for(uint8_t id = 0; id < mSim.getNumInverters(); id++) {
+            Inverter<> *iv = mSim.getInverter(id);
+            printf("%s/data %s\n", iv->config->name, mBatch.format(iv, iv->getRecordStruct(RealTimeRunData_Debug)));
+        }
+    }
+
+    printf("live data of %d inverter(s), per inverter and cycle:\n", mSim.getNumInverters());
+    printf("%-10s %9s %9s %9s\n", "path", "us", "bytes", "messages");
+    bench("per field", rounds, perField);
+    bench("batch", rounds, batch);
+    discovery(rounds / 10, native::hasArg(argc, argv, "-v"));
+    rxBurst(mSim.getNumInverters(), 200);
+    return rxOrder() ? 0 : 1;
+}
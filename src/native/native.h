@@ -0,0 +1,58 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __NATIVE_H__
+#define __NATIVE_H__
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+namespace native {
+    // returns the value following 'name' or 'def' if the option is not given
+    inline long getArg(int argc, char *argv[], const char *name, long def) {
+        for(int i = 0; i < (argc - 1); i++) {
+            if(0 == strcmp(argv[i], name))
+                return strtol(argv[i+1], nullptr, 0);
+        }
+        return def;
+    }
+
+    inline const char *getArgStr(int argc, char *argv[], const char *name, const char *def) {
+        for(int i = 0; i < (argc - 1); i++) {
+            if(0 == strcmp(argv[i], name))
+                return argv[i+1];
+        }
+        return def;
+    }
+
+    inline bool hasArg(int argc, char *argv[], const char *name) {
+        for(int i = 0; i < argc; i++) {
+            if(0 == strcmp(argv[i], name))
+                return true;
+        }
+        return false;
+    }
+
+    // wall clock, independent of the virtual millis()
+    inline double wallSec(void) {
+        using namespace std::chrono;
+        return duration<double>(steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+// sub commands, see main.cpp
+int runSim(int argc, char *argv[]);
+int runReplay(int argc, char *argv[]);
+int runCrcBench(int argc, char *argv[]);
+int runDecodeBench(int argc, char *argv[]);
+int runChSelBench(int argc, char *argv[]);
+int runMetricsBench(int argc, char *argv[]);
+int runApiBench(int argc, char *argv[]);
+int runMqttBench(int argc, char *argv[]);
+int runLimitBench(int argc, char *argv[]);
+
+#endif /*__NATIVE_H__*/
@@ -0,0 +1,217 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#include "native.h"
+#include "Sim.h"
+#include "ReplayRadio.h"
+
+typedef struct {
+    uint32_t ms;        // relative to the first trace entry
+    uint8_t ivPos;
+    uint8_t cmd;
+    uint32_t duration;  // first TX till last RX frame
+} request_t;
+
+static ReplayRadio mRadio;
+static ReplayRadio mCmtRadio;
+static Sim mSim;
+
+static int8_t findInverter(const uint8_t packet[]) {
+    for(uint8_t i = 0; i < mSim.getNumInverters(); i++) {
+        uint8_t id[4];
+        CP_U32_BigEndian(id, mSim.getInverter(i)->radioId.u64 >> 8);
+        if(0 == memcmp(id, &packet[1], 4))
+            return i;
+    }
+    return -1;
+}
+
+// Extracts the requests out of the recorded TX frames. A repeated request to
+// the same inverter with the same command is a retransmit as long as it is
+// not more than 'gap' ms apart from the previous one
+static void getRequests(const std::vector<ReplayRadio::entry_t> *e, std::vector<request_t> *req, uint32_t gap) {
+    std::vector<int32_t> last(MAX_NUM_INVERTERS, -1); // index of the last request per inverter
+    std::vector<uint32_t> lastTx(MAX_NUM_INVERTERS, 0);
+    uint32_t start = (*e)[0].ms;
+
+    for(const ReplayRadio::entry_t &en : *e) {
+        int8_t pos = findInverter(en.packet);
+        if(pos < 0)
+            continue;
+
+        if(PacketTrace::Dir::RX == en.dir) {
+            if(last[pos] >= 0)
+                (*req)[last[pos]].duration = en.ms - start - (*req)[last[pos]].ms;
+            continue;
+        }
+
+        if((TX_REQ_INFO != en.packet[0]) || (ALL_FRAMES != en.packet[9]))
+            continue; // only information requests, no retransmits of single frames
+        bool isNew = (last[pos] < 0) || ((*req)[last[pos]].cmd != en.packet[10]) || ((en.ms - lastTx[pos]) > gap);
+        lastTx[pos] = en.ms;
+        if(!isNew)
+            continue;
+        last[pos] = req->size();
+        req->push_back({en.ms - start, (uint8_t)pos, en.packet[10], 0});
+    }
+}
+
+static void printStats(const char *name, std::vector<uint32_t> *lat) {
+    if(lat->empty()) {
+        printf("%s: n/a\n", name);
+        return;
+    }
+    std::sort(lat->begin(), lat->end());
+    uint64_t sum = 0;
+    for(uint32_t l : *lat)
+        sum += l;
+    printf("%s [ms]: n %zu, sum %llu, avg %.1f, p50 %u, p95 %u, max %u\n",
+        name, lat->size(), (unsigned long long)sum, (double)sum / lat->size(), (*lat)[lat->size() / 2],
+        (*lat)[(lat->size() * 95) / 100], lat->back());
+}
+
+static void printCycles(const char *name, const std::vector<request_t> *req) {
+    std::vector<uint32_t> lat;
+    for(const request_t &r : *req) {
+        if(0 != r.duration)
+            lat.push_back(r.duration);
+    }
+    printStats(name, &lat);
+}
+
+static bool readTrace(const char *path, std::vector<uint8_t> *buf) {
+    FILE *fp = fopen(path, "rb");
+    if(nullptr == fp)
+        return false;
+    uint8_t tmp[1024];
+    size_t len;
+    while((len = fread(tmp, 1, sizeof(tmp), fp)) > 0)
+        buf->insert(buf->end(), tmp, tmp + len);
+    fclose(fp);
+    return true;
+}
+
+// records 'num' HM and 'num' HMS inverters on two FakeRadios, the trace is
+// the same as the '/trace' download of a DTU with nRF and CMT module
+static uint32_t recordMixed(uint8_t num, uint32_t duration, int argc, char *argv[], std::vector<uint8_t> *buf) {
+    static FakeRadio radio, cmtRadio;
+    static Sim sim;
+    static bool serialDebug = false, privacyMode = false, printWholeTrace = false;
+    for(FakeRadio *r : {&radio, &cmtRadio}) {
+        r->getProfile()->dropRate     = native::getArg(argc, argv, "--drop", 0);
+        r->getProfile()->noAnswerRate = native::getArg(argc, argv, "--noanswer", 0);
+    }
+    radio.setup(&serialDebug, &privacyMode, &printWholeTrace, 1);
+    cmtRadio.setup(&serialDebug, &privacyMode, &printWholeTrace, 2);
+
+    uint64_t serial[MAX_NUM_INVERTERS];
+    num = std::min(num, (uint8_t)(MAX_NUM_INVERTERS / 2));
+    for(uint8_t i = 0; i < 2 * num; i++)
+        serial[i] = ((uint64_t)((i < num) ? 0x1141 : 0x1144) << 32) | (0x80000000 + i);
+    sim.setup(&radio, 2 * num, SEND_INTERVAL, false, serial, &cmtRadio);
+    sim.run(millis() + duration * 1000);
+
+    PacketTrace *trace = sim.getTrace();
+    buf->resize(trace->getDumpSize(2 * num));
+    trace->dump(buf->data(), serial, 2 * num);
+    return sim.getPayloadCnt();
+}
+
+int runReplay(int argc, char *argv[]) {
+    const char *in  = native::getArgStr(argc, argv, "--in", nullptr);
+    uint32_t gap    = native::getArg(argc, argv, "--gap", 5000);
+    uint32_t tail   = native::getArg(argc, argv, "--tail", 30000);
+    uint8_t mixed   = native::getArg(argc, argv, "--mixed", 0);
+    bool verbose    = native::hasArg(argc, argv, "-v");
+    if((nullptr == in) && (0 == mixed)) {
+        printf("missing --in <trace> or --mixed <n>\n");
+        return 1;
+    }
+
+    std::vector<uint8_t> buf;
+    uint32_t recPayloads = 0;
+    if(nullptr == in) {
+        in = "mixed trace";
+        recPayloads = recordMixed(mixed, native::getArg(argc, argv, "--duration", 600), argc, argv, &buf);
+    } else if(!readTrace(in, &buf)) {
+        printf("can't open %s\n", in);
+        return 1;
+    }
+
+    // both radios get the whole trace, each matches the requests of its inverters
+    if(!mRadio.load(buf.data(), buf.size()) || mRadio.getEntries()->empty() || !mCmtRadio.load(buf.data(), buf.size())) {
+        printf("%s is not a packet trace or empty\n", in);
+        return 1;
+    }
+
+    static bool serialDebug = verbose, privacyMode = false, printWholeTrace = false;
+    mRadio.setup(&serialDebug, &privacyMode, &printWholeTrace);
+    mCmtRadio.setup(&serialDebug, &privacyMode, &printWholeTrace);
+    const std::vector<uint64_t> *serial = mRadio.getSerials();
+    mSim.setup(&mRadio, serial->size(), 0, verbose, serial->data(), &mCmtRadio);
+
+    std::vector<request_t> req;
+    getRequests(mRadio.getEntries(), &req, gap);
+    if(req.empty()) {
+        printf("no requests found in trace\n");
+        return 1;
+    }
+
+    uint32_t base = millis();
+    double start = native::wallSec();
+    for(const request_t &r : req) {
+        mSim.run(base + r.ms);
+        mSim.enqueue(mSim.getInverter(r.ivPos), r.cmd, false);
+    }
+    mSim.run(base + req.back().ms + tail);
+    double wall = native::wallSec() - start;
+
+    const std::vector<ReplayRadio::entry_t> *e = mRadio.getEntries();
+    uint32_t recTx = 0;
+    for(const ReplayRadio::entry_t &en : *e) {
+        if(PacketTrace::Dir::TX == en.dir)
+            recTx++;
+    }
+
+    printf("replay: %zu entries, %zu requests, %u inverters, %.1fs trace, wall time %.3fs\n",
+        e->size(), req.size(), mSim.getNumInverters(), (e->back().ms - e->front().ms) / 1000.0, wall);
+    printf("timings [ms]: TXFRAME %d, ONEFRAME %d, LISTEN_MIN %d, PAUSE_LASTFR %d\n",
+        DURATION_TXFRAME, DURATION_ONEFRAME, DURATION_LISTEN_MIN, DURATION_PAUSE_LASTFR);
+
+    ReplayRadio::stats_t st = *mRadio.getStats();
+    const ReplayRadio::stats_t *cmt = mCmtRadio.getStats();
+    st.txCnt    += cmt->txCnt;
+    st.matchCnt += cmt->matchCnt;
+    st.missCnt  += cmt->missCnt;
+    st.rxCnt    += cmt->rxCnt;
+    printf("recorded: tx %u, rx %zu\n", recTx, e->size() - recTx);
+    printf("replayed: tx %u (matched %u, unanswered %u), rx %u, payloads %u\n",
+        st.txCnt, st.matchCnt, st.missCnt, st.rxCnt, mSim.getPayloadCnt());
+
+    // cycle: first TX of a request till its last RX frame, same definition for both traces
+    std::vector<ReplayRadio::entry_t> replayed;
+    PacketTrace *trace = mSim.getTrace();
+    for(uint16_t i = 0; i < trace->getCount(); i++)
+        replayed.push_back(*trace->get(i));
+    std::vector<request_t> replayedReq;
+    if(!replayed.empty())
+        getRequests(&replayed, &replayedReq, gap);
+    printCycles("recorded cycle", &req);
+    printCycles("replayed cycle", &replayedReq);
+    printStats("replayed enqueue to payload", mSim.getLatencies());
+
+    const char *out = native::getArgStr(argc, argv, "--out", nullptr);
+    if((nullptr != out) && !mSim.saveTrace(out)) {
+        printf("can't write %s\n", out);
+        return 1;
+    }
+
+    // a recorded mixed trace has to give the same payloads again
+    if((0 != recPayloads) && (mSim.getPayloadCnt() < recPayloads)) {
+        printf("mixed trace: %u of %u payloads replayed\n", mSim.getPayloadCnt(), recPayloads);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,102 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#include "native.h"
+#include "Sim.h"
+
+static FakeRadio mRadio;
+static FakeRadio mCmtRadio;
+static Sim mSim;
+
+static void printLatency(std::vector<uint32_t> *lat) {
+    if(lat->empty()) {
+        printf("latency: n/a\n");
+        return;
+    }
+    std::sort(lat->begin(), lat->end());
+    uint64_t sum = 0;
+    for(uint32_t l : *lat)
+        sum += l;
+    printf("latency [ms]: avg %.1f, p50 %u, p95 %u, max %u\n",
+        (double)sum / lat->size(), (*lat)[lat->size() / 2],
+        (*lat)[(lat->size() * 95) / 100], lat->back());
+}
+
+int runSim(int argc, char *argv[]) {
+    uint8_t numIv     = native::getArg(argc, argv, "--iv", 4);
+    uint8_t numHms    = native::getArg(argc, argv, "--hms", 0); // last inverters are HMS-1000 on a second radio
+    uint32_t duration = native::getArg(argc, argv, "--duration", 3600);
+    uint16_t interval = native::getArg(argc, argv, "--interval", SEND_INTERVAL);
+    uint16_t intvlMax = native::getArg(argc, argv, "--max", 0); // adaptive interval if set
+    uint16_t intvlMin = native::getArg(argc, argv, "--min", SEND_INTERVAL_MIN);
+    uint8_t numStable = native::getArg(argc, argv, "--stable", 0); // first inverters answer constant values
+    bool verbose      = native::hasArg(argc, argv, "-v");
+
+    for(FakeRadio *radio : {&mRadio, &mCmtRadio}) {
+        FakeRadio::profile_t *prof = radio->getProfile();
+        prof->dropRate     = native::getArg(argc, argv, "--drop", 0);
+        prof->crcErrRate   = native::getArg(argc, argv, "--crc", 0);
+        prof->noAnswerRate = native::getArg(argc, argv, "--noanswer", 0);
+        prof->stableIvMask = (1UL << numStable) - 1;
+    }
+
+    static bool serialDebug = verbose, privacyMode = false, printWholeTrace = false;
+    uint32_t seed = native::getArg(argc, argv, "--seed", 1);
+    mRadio.setup(&serialDebug, &privacyMode, &printWholeTrace, seed);
+    mCmtRadio.setup(&serialDebug, &privacyMode, &printWholeTrace, seed + 1);
+
+    const uint16_t types[] = {0x1121, 0x1141, 0x1161};
+    uint64_t serial[MAX_NUM_INVERTERS];
+    numIv  = std::min(numIv, (uint8_t)MAX_NUM_INVERTERS);
+    numHms = std::min(numHms, numIv);
+    for(uint8_t i = 0; i < numIv; i++) {
+        uint16_t type = (i >= (numIv - numHms)) ? 0x1144 : types[i % 3];
+        serial[i] = ((uint64_t)type << 32) | (0x80000000 + i);
+    }
+    mSim.setup(&mRadio, numIv, interval, verbose, serial, &mCmtRadio);
+    if(0 != intvlMax)
+        mSim.setAdaptiveInterval(intvlMin, intvlMax);
+
+    double start = native::wallSec();
+    mSim.run(duration * 1000);
+    double wall = native::wallSec() - start;
+
+    const FakeRadio::stats_t *st = mRadio.getStats();
+    printf("sim: %d inverters, %us simulated, interval %ds\n", mSim.getNumInverters(), duration, interval);
+    printf("wall time: %.3fs (%.0fx real time)\n", wall, (wall > 0) ? (duration / wall) : 0);
+    printf("radio: tx %u, rx %u, dropped %u, crc err %u, no answer %u\n",
+        st->txCnt, st->rxCnt, st->dropCnt, st->crcErrCnt, st->noAnswerCnt);
+    if(0 != numHms) {
+        st = mCmtRadio.getStats();
+        printf("radio cmt: tx %u, rx %u, dropped %u, crc err %u, no answer %u\n",
+            st->txCnt, st->rxCnt, st->dropCnt, st->crcErrCnt, st->noAnswerCnt);
+    }
+    printf("payloads: %u (%.1f / min)\n", mSim.getPayloadCnt(), mSim.getPayloadCnt() * 60.0 / duration);
+    printLatency(mSim.getLatencies());
+
+    const char *prioNames[] = {"dev control", "realtime", "info"};
+    printf("queue        cnt   avg [ms]  max [ms]  dropped\n");
+    for(uint8_t i = 0; i < Communication::PrioCnt; i++) {
+        const Communication::queueStat_t *qs = mSim.getCommunication()->getQueueStat(static_cast<Communication::Prio>(i));
+        printf("%-11s %6u %9.1f %9u %8u\n", prioNames[i], qs->cnt, (0 == qs->cnt) ? 0.0 : ((double)qs->sumMs / qs->cnt), qs->maxMs, qs->dropCnt);
+    }
+
+    printf("id  txCnt  success  fail  noAnswer  retransmits  interval\n");
+    for(uint8_t i = 0; i < mSim.getNumInverters(); i++) {
+        Inverter<> *iv = mSim.getInverter(i);
+        printf("%2d %6u %8u %5u %9u %12u %9u\n", i, iv->radioStatistics.txCnt, iv->radioStatistics.rxSuccess,
+            iv->radioStatistics.rxFail, iv->radioStatistics.rxFailNoAnswer, iv->radioStatistics.retransmits,
+            (0 != intvlMax) ? iv->pollIntvl.getInterval() : interval);
+    }
+
+    #if defined(ENABLE_PACKET_TRACE)
+    const char *trace = native::getArgStr(argc, argv, "--trace", nullptr);
+    if((nullptr != trace) && !mSim.saveTrace(trace)) {
+        printf("can't write %s\n", trace);
+        return 1;
+    }
+    #endif
+    return 0;
+}
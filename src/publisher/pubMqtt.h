@@ -30,14 +30,19 @@
 
 #include "pubMqttDefs.h"
 #include "pubMqttIvData.h"
+#include "pubMqttDiscovery.h"
+#include "pubMqttRxQueue.h"
 
 typedef std::function<void(JsonObject)> subscriptionCb;
 
 typedef struct {
     bool running;
+    bool publish;   // hash of inverter changed, sensors are published
+    bool complete;  // all sensors of the inverter were published while connected
     uint8_t lastIvId;
     uint8_t sub;
     uint8_t foundIvCnt;
+    uint32_t hash;
 } discovery_t;
 
 template<class HMSYSTEM>
@@ -68,7 +73,7 @@ class PubMqtt {
             #endif
         }
 
-        void setup(IApp *app, cfgMqtt_t *cfg_mqtt, const char *devName, const char *version, HMSYSTEM *sys, uint32_t *utcTs, uint32_t *uptime) {
+        void setup(IApp *app, cfgMqtt_t *cfg_mqtt, cfgInst_t *cfg_inst, const char *devName, const char *version, HMSYSTEM *sys, uint32_t *utcTs, uint32_t *uptime) {
             mApp             = app;
             mCfgMqtt         = cfg_mqtt;
             mDevName         = devName;
@@ -83,6 +88,8 @@ class PubMqtt {
                 publish(subTopic, payload, retained, true, qos);
             });
             mDiscovery.running = false;
+            mDiscoveryFmt.setup(cfg_mqtt, cfg_inst, devName);
+            mDiscoveryHash.fill(0);
 
             snprintf(mLwtTopic.data(), mLwtTopic.size(), "%s/mqtt", mCfgMqtt->topic);
 
@@ -112,16 +119,28 @@ class PubMqtt {
         }
 
         void loop() {
-            std::queue<message_s> queue;
+            PubMqttRxQueue::message_t msg;
+            while(true) {
+                xSemaphoreTake(mutex, portMAX_DELAY);
+                bool avail = mReceiveQueue.pop(&msg);
+                xSemaphoreGive(mutex);
+                if(!avail)
+                    break;
+                handleMessage(msg.topic, msg.payload, msg.len);
+            }
+
             xSemaphoreTake(mutex, portMAX_DELAY);
-            queue.swap(mReceiveQueue);
+            bool connected = mConnectEvt, disconnected = mDisconnectEvt;
+            mConnectEvt    = false;
+            mDisconnectEvt = false;
             xSemaphoreGive(mutex);
-
-            while (!queue.empty()) {
-                message_s *entry = &queue.front();
-                handleMessage(entry->topic, entry->payload, entry->len, entry->index, entry->total);
-                queue.pop();
-            }
+            if(disconnected)
+                mDiscovery.running = false; // unfinished inverters keep the hash published last
+            if(connected)
+                SendIvData.publishAll();
+            // only inverters whose config or the IP address changed meanwhile
+            if(connected && mDiscoverySent)
+                sendDiscoveryConfig(false);
 
             SendIvData.loop();
 
@@ -265,12 +284,31 @@ class PubMqtt {
             return mRxCnt;
         }
 
-        void sendDiscoveryConfig(void) {
+        inline uint32_t getRxDroppedCnt(void) {
+            return mReceiveQueue.getDroppedCnt();
+        }
+
+        inline uint32_t getRxCoalescedCnt(void) {
+            return mReceiveQueue.getCoalescedCnt();
+        }
+
+        inline uint32_t getRxTooLargeCnt(void) {
+            return mReceiveQueue.getTooLargeCnt();
+        }
+
+        // 'force' publishes all sensors, otherwise only the ones of inverters
+        // whose config changed since it was published last
+        void sendDiscoveryConfig(bool force = true) {
             DPRINTLN(DBG_VERBOSE, F("sendMqttDiscoveryConfig"));
+            if(force)
+                mDiscoveryHash.fill(0);
+            mDiscoveryFmt.setIp(mApp->getIp().c_str());
             mDiscovery.running  = true;
+            mDiscovery.publish  = false;
             mDiscovery.lastIvId = 0;
             mDiscovery.sub = 0;
             mDiscovery.foundIvCnt = 0;
+            mDiscoverySent = true;
         }
 
         void setPowerLimitAck(Inverter<> *iv) {
@@ -303,9 +341,20 @@ class PubMqtt {
                 subscribe(mVal.data());
             }
             subscribe(subscr[MQTT_SUBS_SET_TIME]);
+
+            // on ESP32 this runs in the task of espMqttClient, the discovery
+            // is started by loop()
+            xSemaphoreTake(mutex, portMAX_DELAY);
+            mConnectEvt = true;
+            xSemaphoreGive(mutex);
         }
 
         void onDisconnect(espMqttClientTypes::DisconnectReason reason) {
+            xSemaphoreTake(mutex, portMAX_DELAY);
+            mConnectEvt    = false;
+            mDisconnectEvt = true;
+            xSemaphoreGive(mutex);
+
             DPRINT(DBG_INFO, F("MQTT disconnected, reason: "));
             switch (reason) {
                 case espMqttClientTypes::DisconnectReason::TCP_DISCONNECTED:
@@ -336,23 +385,28 @@ class PubMqtt {
                 return;
 
             xSemaphoreTake(mutex, portMAX_DELAY);
-            mReceiveQueue.push(message_s(topic, payload, len, index, total));
+            bool queued = mReceiveQueue.push(topic, payload, len, index, total);
             xSemaphoreGive(mutex);
-
+            if(!queued) {
+                if((len > MQTT_RX_PAYLOAD_LEN) || (total > MQTT_RX_PAYLOAD_LEN))
+                    DPRINTLN(DBG_WARN, F("MQTT message too large, dropped"));
+                else
+                    DPRINTLN(DBG_WARN, F("MQTT message dropped"));
+            }
         }
 
-        inline void handleMessage(const char* topic, const uint8_t* payload, size_t len, size_t index, size_t total) {
+        inline void handleMessage(const char* topic, const uint8_t* payload, size_t len) {
             DPRINT(DBG_INFO, mqttStr[MQTT_STR_GOT_TOPIC]);
             DBGPRINTLN(String(topic));
             if(NULL == mSubscriptionCb)
                 return;
 
-            DynamicJsonDocument json(128);
+            StaticJsonDocument<128> json;
             JsonObject root = json.to<JsonObject>();
 
             bool limitAbs = false;
             if(len > 0) {
-                char *pyld = new char[len + 1];
+                char pyld[MQTT_RX_PAYLOAD_LEN + 1];
                 memcpy(pyld, payload, len);
                 pyld[len] = '\0';
                 if(NULL == strstr(topic, "limit"))
@@ -362,7 +416,6 @@ class PubMqtt {
 
                 if(pyld[len-1] == 'W')
                     limitAbs = true;
-                delete[] pyld;
             }
 
             const char *p = topic + strlen(mCfgMqtt->topic);
@@ -374,7 +427,7 @@ class PubMqtt {
                     memcpy(tmp, p, pos);
                     tmp[pos] = '\0';
                     switch(elm++) {
-                        case 1: root[F("path")] = String(tmp); break;
+                        case 1: root[F("path")] = (char*)tmp; break; // char* is copied
                         case 2:
                             if(strncmp("limit", tmp, 5) == 0) {
                                 if(limitAbs)
@@ -382,7 +435,7 @@ class PubMqtt {
                                 else
                                     root[F("cmd")] = F("limit_nonpersistent_relative");
                             } else
-                                root[F("cmd")] = String(tmp);
+                                root[F("cmd")] = (char*)tmp;
                             break;
                         case 3: root[F("id")] = atoi(tmp);   break;
                         default: break;
@@ -404,122 +457,80 @@ class PubMqtt {
         }
 
         void discoveryConfigLoop(void) {
-            DynamicJsonDocument doc(256);
-
-            constexpr static uint8_t fldTotal[] = {FLD_PAC, FLD_YT, FLD_YD, FLD_PDC};
-
-            String node_id = String(mDevName) + "_TOTAL";
             bool total = (mDiscovery.lastIvId == MAX_NUM_INVERTERS);
-
-            Inverter<> *iv = mSys->getInverterByPos(mDiscovery.lastIvId);
-            record_t<> *rec = nullptr;
-            if (nullptr != iv) {
-                rec = iv->getRecordStruct(RealTimeRunData_Debug);
-                if(0 == mDiscovery.sub)
-                    mDiscovery.foundIvCnt++;
-            }
-
-            if ((nullptr != iv) || total) {
-                if (!total) {
-                    doc[F("name")] = iv->config->name;
-                    doc[F("ids")] = String(iv->config->serial.u64, HEX);
-                    doc[F("mdl")] = iv->config->name;
-                } else {
-                    doc[F("name")] = node_id;
-                    doc[F("ids")] = node_id;
-                    doc[F("mdl")] = node_id;
+            Inverter<> *iv = nullptr;
+            if(!total) {
+                iv = mSys->getInverterByPos(mDiscovery.lastIvId);
+                if(nullptr == iv) {
+                    checkDiscoveryEnd();
+                    return;
                 }
+            }
 
-                doc[F("cu")] = F("http://") +  mApp->getIp();
-                doc[F("mf")] = F("Hoymiles");
-                JsonObject deviceObj = doc.as<JsonObject>(); // deviceObj is only pointer!?
-
-                std::array<char, 64> topic;
-                std::array<char, 32> name;
-                std::array<char, 32> uniq_id;
-                std::array<char, 350> buf;
-                topic.fill(0);
-                name.fill(0);
-                uniq_id.fill(0);
-                buf.fill(0);
-                const char *devCls, *stateCls;
-
-                if (!total) {
-                    if (rec->assign[mDiscovery.sub].ch == CH0)
-                        snprintf(name.data(), name.size(), "%s", iv->getFieldName(mDiscovery.sub, rec));
-                    else
-                        snprintf(name.data(), name.size(), "CH%d_%s", rec->assign[mDiscovery.sub].ch, iv->getFieldName(mDiscovery.sub, rec));
-                    if (!mCfgMqtt->json)
-                        snprintf(topic.data(), name.size(), "/ch%d/%s", rec->assign[mDiscovery.sub].ch, iv->getFieldName(mDiscovery.sub, rec));
-                    else
-                        snprintf(topic.data(), name.size(), "/ch%d", rec->assign[mDiscovery.sub].ch);
-                    snprintf(uniq_id.data(), uniq_id.size(), "ch%d_%s", rec->assign[mDiscovery.sub].ch, iv->getFieldName(mDiscovery.sub, rec));
-
-                    devCls = getFieldDeviceClass(rec->assign[mDiscovery.sub].fieldId);
-                    stateCls = getFieldStateClass(rec->assign[mDiscovery.sub].fieldId);
-                }
-                else { // total values
-                    snprintf(name.data(), name.size(), "Total %s", fields[fldTotal[mDiscovery.sub]]);
-                    snprintf(topic.data(), topic.size(), "/%s", fields[fldTotal[mDiscovery.sub]]);
-                    snprintf(uniq_id.data(), uniq_id.size(), "total_%s", fields[fldTotal[mDiscovery.sub]]);
-                    devCls = getFieldDeviceClass(fldTotal[mDiscovery.sub]);
-                    stateCls = getFieldStateClass(fldTotal[mDiscovery.sub]);
+            if(!mDiscovery.publish) {
+                // compare the config of the whole inverter with the one published last
+                if(!total)
+                    mDiscovery.foundIvCnt++;
+                uint32_t hash = getDiscoveryHash(iv);
+                if(hash == mDiscoveryHash[mDiscovery.lastIvId])
+                    checkDiscoveryEnd();
+                else {
+                    mDiscovery.publish  = true;
+                    mDiscovery.complete = true;
+                    mDiscovery.hash     = hash;
+                    mDiscovery.sub      = 0;
                 }
+                return;
+            }
 
-                DynamicJsonDocument doc2(512);
-                constexpr static const char* unitTotal[] = {"W", "kWh", "Wh", "W"};
-                doc2[F("name")] = String(name.data());
+            // publish one sensor per loop
+            std::array<char, MQTT_DISCOVERY_TOPIC_LEN> topic;
+            std::array<char, MQTT_DISCOVERY_BUF_SIZE> buf;
+            uint8_t cnt = MQTT_DISCOVERY_TOTAL_CNT;
+            bool ok;
+            if(!total) {
+                record_t<> *rec = iv->getRecordStruct(RealTimeRunData_Debug);
+                cnt = rec->length;
+                ok = mDiscoveryFmt.format(iv, mDiscovery.sub, topic.data(), buf.data());
+                if(FLD_EVT == rec->assign[mDiscovery.sub].fieldId)
+                    ok = false;
+            } else
+                ok = mDiscoveryFmt.formatTotal(mDiscovery.sub, topic.data(), buf.data());
 
-                if (mCfgMqtt->json) {
-                    if (total) {
-                        doc2[F("val_tpl")] = String("{{ value_json.") + fields[fldTotal[mDiscovery.sub]] + String(" }}");
-                        doc2[F("stat_t")] = String(mCfgMqtt->topic) + "/" + "total";
-                    }
-                    else {
-                        doc2[F("val_tpl")] = String("{{ value_json.") + iv->getFieldName(mDiscovery.sub, rec) + String(" }}");
-                        doc2[F("stat_t")] = String(mCfgMqtt->topic) + "/" + String(iv->config->name) + String(topic.data());
-                    }
-                }
-                else {
-                    doc2[F("stat_t")] = String(mCfgMqtt->topic) + "/" + ((!total) ? String(iv->config->name) : "total" ) + String(topic.data());
-                }
-                doc2[F("unit_of_meas")] = ((!total) ? (iv->getUnit(mDiscovery.sub, rec)) : (unitTotal[mDiscovery.sub]));
-                doc2[F("uniq_id")] = ((!total) ? (String(iv->config->serial.u64, HEX)) : (node_id)) + "_" + uniq_id.data();
-                doc2[F("dev")] = deviceObj;
-
-                if (!(String(stateCls) == String("total_increasing")))
-                    doc2[F("exp_aft")] = MQTT_INTERVAL + 5;  // add 5 sec if connection is bad or ESP too slow @TODO: stimmt das wirklich als expire!?
-                if (devCls != nullptr)
-                    doc2[F("dev_cla")] = String(devCls);
-                if (stateCls != nullptr)
-                    doc2[F("stat_cla")] = String(stateCls);
-
-                if (!total)
-                    snprintf(topic.data(), topic.size(), "%s/sensor/%s/ch%d_%s/config", MQTT_DISCOVERY_PREFIX, iv->config->name, rec->assign[mDiscovery.sub].ch, iv->getFieldName(mDiscovery.sub, rec));
-                else // total values
-                    snprintf(topic.data(), topic.size(), "%s/sensor/%s/total_%s/config", MQTT_DISCOVERY_PREFIX, node_id.c_str(), fields[fldTotal[mDiscovery.sub]]);
-
-                size_t size = measureJson(doc2) + 1;
-                serializeJson(doc2, buf.data(), size);
-
-                if(nullptr != rec) {
-                    if(FLD_EVT != rec->assign[mDiscovery.sub].fieldId)
-                        publish(topic.data(), buf.data(), true, false);
-                } else if(total)
-                    publish(topic.data(), buf.data(), true, false);
-
-                if(++mDiscovery.sub == ((!total) ? (rec->length) : 4)) {
-                    mDiscovery.sub = 0;
-                    checkDiscoveryEnd();
-                }
-            } else {
-                mDiscovery.sub = 0;
+            if(!mClient.connected())
+                mDiscovery.complete = false; // publish() drops the message
+            if(ok)
+                publish(topic.data(), buf.data(), true, false);
+
+            if(++mDiscovery.sub == cnt) {
+                // otherwise the next connect publishes the inverter again
+                if(mDiscovery.complete)
+                    mDiscoveryHash[mDiscovery.lastIvId] = mDiscovery.hash;
+                mDiscovery.publish = false;
+                mDiscovery.sub     = 0;
                 checkDiscoveryEnd();
             }
-
             yield();
         }
 
+        // hash of the topics and payloads of all sensors of an inverter or
+        // the total values (nullptr)
+        uint32_t getDiscoveryHash(Inverter<> *iv) {
+            std::array<char, MQTT_DISCOVERY_TOPIC_LEN> topic;
+            std::array<char, MQTT_DISCOVERY_BUF_SIZE> buf;
+            uint32_t hash = PubMqttDiscovery::HASH_INIT;
+            uint8_t cnt = (nullptr != iv) ? iv->getRecordStruct(RealTimeRunData_Debug)->length : MQTT_DISCOVERY_TOTAL_CNT;
+            for(uint8_t sub = 0; sub < cnt; sub++) {
+                bool ok = (nullptr != iv) ? mDiscoveryFmt.format(iv, sub, topic.data(), buf.data())
+                                          : mDiscoveryFmt.formatTotal(sub, topic.data(), buf.data());
+                if(ok) {
+                    hash = PubMqttDiscovery::hash(hash, topic.data());
+                    hash = PubMqttDiscovery::hash(hash, buf.data());
+                }
+            }
+            return hash;
+        }
+
         void checkDiscoveryEnd(void) {
             if(++mDiscovery.lastIvId == MAX_NUM_INVERTERS) {
                 // check if only one inverter was found, then don't create 'total' sensor
@@ -529,24 +540,6 @@ class PubMqtt {
                 mDiscovery.running = false;
         }
 
-        const char *getFieldDeviceClass(uint8_t fieldId) {
-            uint8_t pos = 0;
-            for (; pos < DEVICE_CLS_ASSIGN_LIST_LEN; pos++) {
-                if (deviceFieldAssignment[pos].fieldId == fieldId)
-                    break;
-            }
-            return (pos >= DEVICE_CLS_ASSIGN_LIST_LEN) ? NULL : deviceClasses[deviceFieldAssignment[pos].deviceClsId];
-        }
-
-        const char *getFieldStateClass(uint8_t fieldId) {
-            uint8_t pos = 0;
-            for (; pos < DEVICE_CLS_ASSIGN_LIST_LEN; pos++) {
-                if (deviceFieldAssignment[pos].fieldId == fieldId)
-                    break;
-            }
-            return (pos >= DEVICE_CLS_ASSIGN_LIST_LEN) ? NULL : stateClasses[deviceFieldAssignment[pos].stateClsId];
-        }
-
         bool processIvStatus() {
             // returns true if any inverter is available
             bool allAvail = true;   // shows if all enabled inverters are available
@@ -626,7 +619,7 @@ class PubMqtt {
         }
 
         void sendData(Inverter<> *iv, uint8_t curInfoCmd) {
-            if (mCfgMqtt->json)
+            if (mCfgMqtt->json || mCfgMqtt->batch)
                 return;
 
             record_t<> *rec = iv->getRecordStruct(curInfoCmd);
@@ -675,67 +668,6 @@ class PubMqtt {
     private:
         enum {MQTT_STATUS_OFFLINE = 0, MQTT_STATUS_PARTIAL, MQTT_STATUS_ONLINE};
 
-        struct message_s
-        {
-            char *topic;
-            uint8_t *payload;
-            size_t len;
-            size_t index;
-            size_t total;
-
-            message_s()
-            : topic { nullptr }
-            , payload { nullptr }
-            , len { 0 }
-            , index { 0 }
-            , total { 0 }
-            {}
-
-            message_s(const char* topic, const uint8_t* payload, size_t len, size_t index, size_t total)
-            {
-                uint8_t topic_len = strlen(topic) + 1;
-                this->topic = new char[topic_len];
-                this->payload = new uint8_t[len];
-
-                memcpy(this->topic, topic, topic_len);
-                memcpy(this->payload, payload, len);
-                this->len = len;
-                this->index = index;
-                this->total = total;
-            }
-
-            message_s(const message_s &) = delete;
-
-            message_s(message_s && other) : message_s {}
-            {
-                this->swap( other );
-            }
-
-            ~message_s()
-            {
-                delete[] this->topic;
-                delete[] this->payload;
-            }
-
-            message_s  &operator = (const message_s &) = delete;
-
-            message_s  &operator = (message_s &&other)
-            {
-                this->swap(other);
-                return *this;
-            }
-
-            void swap(message_s &other)
-            {
-                std::swap(this->topic, other.topic);
-                std::swap(this->payload, other.payload);
-                std::swap(this->len, other.len);
-                std::swap(this->index, other.index);
-                std::swap(this->total, other.total);
-            }
-
-        };
-
     private:
         espMqttClient mClient;
         cfgMqtt_t *mCfgMqtt = nullptr;
@@ -761,7 +693,7 @@ class PubMqtt {
         std::array<uint32_t, MAX_NUM_INVERTERS> mIvLastRTRpub;
         uint16_t mIntervalTimeout = 0;
 
-        std::queue<message_s> mReceiveQueue;
+        PubMqttRxQueue mReceiveQueue;
 
         // last will topic and payload must be available through lifetime of 'espMqttClient'
         std::array<char, (MQTT_TOPIC_LEN + 5)> mLwtTopic;
@@ -771,7 +703,11 @@ class PubMqtt {
         std::array<char, (MQTT_TOPIC_LEN + 32 + MAX_NAME_LENGTH + 1)> mTopic;
         std::array<char, (32 + MAX_NAME_LENGTH + 1)> mSubTopic;
         std::array<char, 100> mVal;
-        discovery_t mDiscovery = {true, 0, 0, 0};
+        discovery_t mDiscovery = {true, false, false, 0, 0, 0, 0};
+        PubMqttDiscovery mDiscoveryFmt;
+        std::array<uint32_t, (MAX_NUM_INVERTERS + 1)> mDiscoveryHash; // last published, 'total' at the end
+        bool mDiscoverySent = false;
+        bool mConnectEvt = false, mDisconnectEvt = false; // handled in loop(), protected by 'mutex'
 };
 
 #endif /*ENABLE_MQTT*/
@@ -0,0 +1,78 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __PUB_MQTT_BATCH_H__
+#define __PUB_MQTT_BATCH_H__
+
+#include "../utils/dbg.h"
+#include "../utils/helper.h"
+#include "../utils/jsonWriter.h"
+#include "../hm/hmInverter.h"
+
+#define MQTT_BATCH_BUF_SIZE     1536 // 6 channels and radio statistics
+
+//-----------------------------------------------------------------------------
+// One message with the live data of an inverter (topic <inverter>/data):
+// {"ts": ts, "ch": [{"U_AC": 230.1, ...}, {"U_DC": 31.2, ...}],
+//  "radio_stat": {"tx": ..}}, the index of "ch" is the channel.
+// The message is formatted into a buffer which is allocated once.
+//-----------------------------------------------------------------------------
+class PubMqttBatch {
+    public:
+        ~PubMqttBatch() {
+            delete[] mBuf;
+        }
+
+        // returns the message or nullptr if it doesn't fit into the buffer
+        const char *format(Inverter<> *iv, record_t<> *rec) {
+            if(nullptr == mBuf)
+                mBuf = new char[MQTT_BATCH_BUF_SIZE];
+
+            ah::ChunkWriter wr(reinterpret_cast<uint8_t*>(mBuf), MQTT_BATCH_BUF_SIZE - 1);
+            ah::JsonWriter::state_t state = {0, 0};
+            ah::JsonWriter json(&wr, &state);
+
+            json.beginObject();
+            json.add("ts", rec->ts);
+            json.beginArray("ch");
+            for(uint8_t ch = 0; ch <= iv->channels; ch++) {
+                json.beginObject();
+                for(uint8_t pos = 0; pos < rec->length; pos++) {
+                    if(ch != rec->assign[pos].ch)
+                        continue;
+                    uint8_t fld = rec->assign[pos].fieldId;
+                    if((FLD_EVT != fld) && (FLD_LAST_ALARM_CODE != fld))
+                        json.add(fields[fld], (float)iv->getValue(pos, rec), 3);
+                }
+                json.endObject();
+            }
+            json.endArray();
+
+            json.beginObject("radio_stat");
+            json.add("tx",          iv->radioStatistics.txCnt);
+            json.add("success",     iv->radioStatistics.rxSuccess);
+            json.add("fail",        iv->radioStatistics.rxFail);
+            json.add("no_answer",   iv->radioStatistics.rxFailNoAnswer);
+            json.add("retransmits", iv->radioStatistics.retransmits);
+            json.add("lossIvRx",    iv->radioStatistics.ivLoss);
+            json.add("lossIvTx",    iv->radioStatistics.ivSent);
+            json.add("lossDtuRx",   iv->radioStatistics.dtuLoss);
+            json.add("lossDtuTx",   iv->radioStatistics.dtuSent);
+            json.endObject();
+            json.endObject();
+
+            if(wr.isFull()) {
+                DPRINTLN(DBG_WARN, F("mqtt: inverter data too large"));
+                return nullptr;
+            }
+            mBuf[wr.getLength()] = '\0';
+            return mBuf;
+        }
+
+    private:
+        char *mBuf = nullptr;
+};
+
+#endif /*__PUB_MQTT_BATCH_H__*/
@@ -0,0 +1,110 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __PUB_MQTT_DEADBAND_H__
+#define __PUB_MQTT_DEADBAND_H__
+
+#include <algorithm>
+#include <cmath>
+#include "../config/settings.h"
+#include "../hm/hmInverter.h"
+
+//-----------------------------------------------------------------------------
+// Report by exception of the live data: a value is published again if it
+// differs from the last published value by more than its deadband, which is
+// the larger one of the absolute and the relative deadband of its class
+// (power, voltage, temperature, yield). Changes from or to zero and all other
+// fields are published on any change. All values of an inverter are published
+// again after the refresh period.
+// The last published values are allocated per inverter on first use.
+//-----------------------------------------------------------------------------
+class PubMqttDeadband {
+    public:
+        ~PubMqttDeadband() {
+            for(uint8_t i = 0; i < MAX_NUM_INVERTERS; i++)
+                delete[] mLast[i].val;
+        }
+
+        void setup(cfgMqtt_t *cfg) {
+            mCfg = cfg;
+        }
+
+        bool isEnabled(void) const {
+            return mCfg->rbe;
+        }
+
+        // call before the values of the record are checked, returns true if
+        // all values are published (first time or refresh)
+        bool start(Inverter<> *iv, record_t<> *rec) {
+            last_t *last = &mLast[iv->id];
+            if(last->len != rec->length) {
+                delete[] last->val;
+                last->val = new float[rec->length];
+                last->len = rec->length;
+                mAll      = true;
+            } else
+                mAll = ((millis() - last->tsRefresh) >= (mCfg->rbeRefresh * 1000UL));
+
+            if(mAll)
+                last->tsRefresh = millis();
+            mVal = last->val;
+            return mAll;
+        }
+
+        // the next start() publishes all values, e.g. after a reconnect to
+        // the broker which may have lost the values that aren't retained
+        void invalidate(void) {
+            for(uint8_t i = 0; i < MAX_NUM_INVERTERS; i++)
+                mLast[i].len = 0;
+        }
+
+        // returns true if the value at 'pos' has to be published
+        bool changed(uint8_t pos, float val, uint8_t fieldId) {
+            float prev = mVal[pos];
+            if(!mAll && !exceeds(fieldId, val, prev))
+                return false;
+            mVal[pos] = val;
+            return true;
+        }
+
+    private:
+        bool exceeds(uint8_t fieldId, float val, float prev) const {
+            float diff = std::fabs(val - prev);
+            if(0.0f == diff)
+                return false;
+            if((0.0f == val) || (0.0f == prev))
+                return true;
+
+            float db = 0.0f;
+            switch(fieldUnits[fieldId]) {
+                case UNIT_W:
+                case UNIT_VAR: db = getDeadband(MQTT_DB_POWER, prev);   break;
+                case UNIT_V:   db = getDeadband(MQTT_DB_VOLTAGE, prev); break;
+                case UNIT_C:   db = getDeadband(MQTT_DB_TEMP, prev);    break;
+                case UNIT_WH:  db = getDeadband(MQTT_DB_YIELD, prev);   break;
+                case UNIT_KWH: db = getDeadband(MQTT_DB_YIELD, prev * 1000.0f) / 1000.0f; break;
+                default:       break;
+            }
+            return (diff >= std::max(db, 0.0005f)); // at least a change after ah::round3()
+        }
+
+        inline float getDeadband(uint8_t cls, float prev) const {
+            return std::max(mCfg->dbAbs[cls], std::fabs(prev) * mCfg->dbRel[cls] / 100.0f);
+        }
+
+    private:
+        typedef struct {
+            float *val = nullptr;
+            uint8_t len = 0;
+            uint32_t tsRefresh = 0;
+        } last_t;
+
+        cfgMqtt_t *mCfg = nullptr;
+        last_t mLast[MAX_NUM_INVERTERS];
+        float *mVal = nullptr;
+        bool mAll = false;
+};
+
+#endif /*__PUB_MQTT_DEADBAND_H__*/
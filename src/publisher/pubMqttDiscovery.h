@@ -0,0 +1,185 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __PUB_MQTT_DISCOVERY_H__
+#define __PUB_MQTT_DISCOVERY_H__
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "../config/config.h"
+#include "../config/settings.h"
+#include "../utils/jsonWriter.h"
+#include "../hm/hmInverter.h"
+
+#define MQTT_DISCOVERY_TOPIC_LEN    (sizeof(MQTT_DISCOVERY_PREFIX) + 2 * MAX_NAME_LENGTH + 32)
+#define MQTT_DISCOVERY_BUF_SIZE     512
+#define MQTT_DISCOVERY_TOTAL_CNT    4
+
+//-----------------------------------------------------------------------------
+// Home Assistant discovery config of one sensor (field of the live data of an
+// inverter or total value), written with JsonWriter into the given buffers.
+// hash() is used to find the inverters whose config changed since it was
+// published.
+//-----------------------------------------------------------------------------
+class PubMqttDiscovery {
+    public:
+        void setup(cfgMqtt_t *cfg, cfgInst_t *cfgInst, const char *devName) {
+            mCfg     = cfg;
+            mCfgInst = cfgInst;
+            mDevName = devName;
+        }
+
+        // call before a sweep, the URL is part of the device
+        void setIp(const char *ip) {
+            snprintf(mUrl, sizeof(mUrl), "http://%s", ip);
+        }
+
+        // config of field 'pos' of the live data, returns false if it doesn't fit
+        bool format(Inverter<> *iv, uint8_t pos, char *topic, char *buf) {
+            record_t<> *rec = iv->getRecordStruct(RealTimeRunData_Debug);
+            uint8_t ch  = rec->assign[pos].ch;
+            uint8_t fld = rec->assign[pos].fieldId;
+            char serial[17], tmp[MQTT_TOPIC_LEN + 32 + MAX_NAME_LENGTH];
+            toHex(serial, iv->config->serial.u64);
+
+            snprintf(topic, MQTT_DISCOVERY_TOPIC_LEN, "%s/sensor/%s/ch%d_%s/config", MQTT_DISCOVERY_PREFIX, iv->config->name, ch, fields[fld]);
+
+            ah::ChunkWriter wr(reinterpret_cast<uint8_t*>(buf), MQTT_DISCOVERY_BUF_SIZE - 1);
+            ah::JsonWriter::state_t state = {0, 0};
+            ah::JsonWriter json(&wr, &state);
+            json.beginObject();
+            if(CH0 == ch)
+                json.add("name", fields[fld]);
+            else {
+                snprintf(tmp, sizeof(tmp), "CH%d_%s", ch, fields[fld]);
+                json.add("name", tmp);
+            }
+
+            if(mCfg->batch) {
+                snprintf(tmp, sizeof(tmp), "{{ value_json.ch[%d].%s }}", ch, fields[fld]);
+                json.add("val_tpl", tmp);
+                snprintf(tmp, sizeof(tmp), "%s/%s/data", mCfg->topic, iv->config->name);
+            } else if(mCfg->json) {
+                snprintf(tmp, sizeof(tmp), "{{ value_json.%s }}", fields[fld]);
+                json.add("val_tpl", tmp);
+                snprintf(tmp, sizeof(tmp), "%s/%s/ch%d", mCfg->topic, iv->config->name, ch);
+            } else
+                snprintf(tmp, sizeof(tmp), "%s/%s/ch%d/%s", mCfg->topic, iv->config->name, ch, fields[fld]);
+            json.add("stat_t", tmp);
+
+            json.add("unit_of_meas", iv->getUnit(pos, rec));
+            snprintf(tmp, sizeof(tmp), "%s_ch%d_%s", serial, ch, fields[fld]);
+            json.add("uniq_id", tmp);
+            writeDevice(&json, iv->config->name, serial, iv->config->name);
+            writeClasses(&json, fld);
+            json.endObject();
+            return finish(&wr, buf);
+        }
+
+        // config of total value 'sub'
+        bool formatTotal(uint8_t sub, char *topic, char *buf) {
+            constexpr static uint8_t fldTotal[] = {FLD_PAC, FLD_YT, FLD_YD, FLD_PDC};
+            constexpr static const char* unitTotal[] = {"W", "kWh", "Wh", "W"};
+            uint8_t fld = fldTotal[sub];
+            char nodeId[MAX_NAME_LENGTH + 8], tmp[MQTT_TOPIC_LEN + 32];
+            snprintf(nodeId, sizeof(nodeId), "%s_TOTAL", mDevName);
+
+            snprintf(topic, MQTT_DISCOVERY_TOPIC_LEN, "%s/sensor/%s/total_%s/config", MQTT_DISCOVERY_PREFIX, nodeId, fields[fld]);
+
+            ah::ChunkWriter wr(reinterpret_cast<uint8_t*>(buf), MQTT_DISCOVERY_BUF_SIZE - 1);
+            ah::JsonWriter::state_t state = {0, 0};
+            ah::JsonWriter json(&wr, &state);
+            json.beginObject();
+            snprintf(tmp, sizeof(tmp), "Total %s", fields[fld]);
+            json.add("name", tmp);
+            if(mCfg->json) {
+                snprintf(tmp, sizeof(tmp), "{{ value_json.%s }}", fields[fld]);
+                json.add("val_tpl", tmp);
+                snprintf(tmp, sizeof(tmp), "%s/total", mCfg->topic);
+            } else
+                snprintf(tmp, sizeof(tmp), "%s/total/%s", mCfg->topic, fields[fld]);
+            json.add("stat_t", tmp);
+            json.add("unit_of_meas", unitTotal[sub]);
+            snprintf(tmp, sizeof(tmp), "%s_total_%s", nodeId, fields[fld]);
+            json.add("uniq_id", tmp);
+            writeDevice(&json, nodeId, nodeId, nodeId);
+            writeClasses(&json, fld);
+            json.endObject();
+            return finish(&wr, buf);
+        }
+
+        // FNV-1a
+        static uint32_t hash(uint32_t h, const char *str) {
+            for(; '\0' != *str; str++) {
+                h ^= (uint8_t)*str;
+                h *= 16777619UL;
+            }
+            return h;
+        }
+
+        static constexpr uint32_t HASH_INIT = 2166136261UL;
+
+    private:
+        void writeDevice(ah::JsonWriter *json, const char *name, const char *ids, const char *mdl) {
+            json->beginObject("dev");
+            json->add("name", name);
+            json->add("ids",  ids);
+            json->add("mdl",  mdl);
+            json->add("cu",   mUrl);
+            json->add("mf",   "Hoymiles");
+            json->endObject();
+        }
+
+        void writeClasses(ah::JsonWriter *json, uint8_t fld) {
+            const char *devCls = nullptr, *stateCls = nullptr;
+            for(uint8_t pos = 0; pos < DEVICE_CLS_ASSIGN_LIST_LEN; pos++) {
+                if(deviceFieldAssignment[pos].fieldId == fld) {
+                    devCls   = deviceClasses[deviceFieldAssignment[pos].deviceClsId];
+                    stateCls = stateClasses[deviceFieldAssignment[pos].stateClsId];
+                    break;
+                }
+            }
+
+            if((nullptr == stateCls) || (0 != strcmp(stateCls, "total_increasing")))
+                json->add("exp_aft", getExpireAfter());
+            if(nullptr != devCls)
+                json->add("dev_cla", devCls);
+            if(nullptr != stateCls)
+                json->add("stat_cla", stateCls);
+        }
+
+        // at least the longest poll interval, report by exception publishes an
+        // unchanged value again with the first payload after the refresh
+        // period, add 5 sec if connection is bad or ESP too slow
+        uint16_t getExpireAfter(void) const {
+            uint32_t sec = std::max((uint16_t)MQTT_INTERVAL, mCfgInst->adaptiveInterval ? mCfgInst->maxInterval : mCfgInst->sendInterval) + 5;
+            if(mCfg->rbe)
+                sec += mCfg->rbeRefresh;
+            return (uint16_t)std::min(sec, (uint32_t)UINT16_MAX);
+        }
+
+        bool finish(ah::ChunkWriter *wr, char *buf) {
+            if(wr->isFull())
+                return false;
+            buf[wr->getLength()] = '\0';
+            return true;
+        }
+
+        // like String(val, HEX)
+        static void toHex(char *out, uint64_t val) {
+            ah::ChunkWriter wr(reinterpret_cast<uint8_t*>(out), 16);
+            wr.writeHex(val);
+            out[wr.getLength()] = '\0';
+        }
+
+    private:
+        cfgMqtt_t *mCfg = nullptr;
+        cfgInst_t *mCfgInst = nullptr;
+        const char *mDevName = nullptr;
+        char mUrl[48] = "";
+};
+
+#endif /*__PUB_MQTT_DISCOVERY_H__*/
@@ -10,6 +10,8 @@
 #include "../utils/dbg.h"
 #include "../hm/hmSystem.h"
 #include "pubMqttDefs.h"
+#include "pubMqttDeadband.h"
+#include "pubMqttBatch.h"
 
 typedef std::function<void(const char *subTopic, const char *payload, bool retained, uint8_t qos)> pubMqttPublisherType;
 
@@ -32,6 +34,7 @@ class PubMqttIvData {
             mSendList      = sendList;
             mState         = IDLE;
             mYldTotalStore = 0;
+            mDeadband.setup(cfg_mqtt);
 
             mRTRDataHasBeenSent = false;
 
@@ -51,6 +54,11 @@ class PubMqttIvData {
             mYldTotalStore = 0;
         }
 
+        // publish all values of the next payloads (report by exception)
+        void publishAll() {
+            mDeadband.invalidate();
+        }
+
         bool start() {
             if(IDLE != mState)
                 return false;
@@ -121,6 +129,11 @@ class PubMqttIvData {
                         mPublish(mSubTopic.data(), mVal.data(), false, QOS_0);
                     }
                     rec->mqttSentStatus = MqttSentStatus::LAST_SUCCESS_SENT;
+
+                    mBatch = (RealTimeRunData_Debug == mCmd) && mCfg->batch;
+                    mRbe = (RealTimeRunData_Debug == mCmd) && mDeadband.isEnabled();
+                    mRbeAll = mRbe ? mDeadband.start(mIv, rec) : true;
+                    mChChanged = 0;
                 }
 
                 mIv->isProducing(); // recalculate status
@@ -178,6 +191,13 @@ class PubMqttIvData {
 
                 if (MqttSentStatus::LAST_SUCCESS_SENT == rec->mqttSentStatus) {
                     mAtLeastOneWasntSent = true;
+                    bool changed = true;
+                    if(mRbe) {
+                        changed = mDeadband.changed(mPos, mIv->getValue(mPos, rec), rec->assign[mPos].fieldId);
+                        if(changed)
+                            mChChanged |= (1 << rec->assign[mPos].ch);
+                    }
+
                     if(InverterDevInform_All == mCmd) {
                         snprintf(mSubTopic.data(), mSubTopic.size(), "%s/firmware", mIv->config->name);
                         snprintf(mVal.data(), mVal.size(), "{\"version\":%d,\"build_year\":\"%d\",\"build_month_day\":%d,\"build_hour_min\":%d,\"bootloader\":%d}",
@@ -193,7 +213,7 @@ class PubMqttIvData {
                             static_cast<int>(mIv->getChannelFieldValue(CH0, FLD_HW_VERSION, rec)),
                             static_cast<int>(mIv->getChannelFieldValue(CH0, FLD_GRID_PROFILE_CODE, rec)),
                             static_cast<int>(mIv->getChannelFieldValue(CH0, FLD_GRID_PROFILE_VERSION, rec)));
-                    } else {
+                    } else if(!mBatch) {
                         if (!mCfg->json) {
                             snprintf(mSubTopic.data(), mSubTopic.size(), "%s/ch%d/%s", mIv->config->name, rec->assign[mPos].ch, fields[rec->assign[mPos].fieldId]);
                             snprintf(mVal.data(), mVal.size(), "%g", ah::round3(mIv->getValue(mPos, rec)));
@@ -207,17 +227,23 @@ class PubMqttIvData {
                         }
                     }
 
-                    if ((InverterDevInform_All == mCmd) || (InverterDevInform_Simple == mCmd) || !mCfg->json)
+                    if ((InverterDevInform_All == mCmd) || (InverterDevInform_Simple == mCmd) || (!mCfg->json && !mBatch))
                     {
                         uint8_t qos = (FLD_ACT_ACTIVE_PWR_LIMIT == rec->assign[mPos].fieldId) ? QOS_2 : QOS_0;
-                        if((FLD_EVT != rec->assign[mPos].fieldId) && (FLD_LAST_ALARM_CODE != rec->assign[mPos].fieldId))
+                        if((FLD_EVT != rec->assign[mPos].fieldId) && (FLD_LAST_ALARM_CODE != rec->assign[mPos].fieldId) && changed)
                             mPublish(mSubTopic.data(), mVal.data(), retained, qos);
                     }
                 }
                 mPos++;
             } else {
                 if (MqttSentStatus::LAST_SUCCESS_SENT == rec->mqttSentStatus) {
-                    if (mCfg->json && (RealTimeRunData_Debug == mCmd)) {
+                    if (mBatch) {
+                        const char *msg = (!mRbe || mRbeAll || (0 != mChChanged)) ? mBatchMsg.format(mIv, rec) : nullptr;
+                        if (nullptr != msg) {
+                            snprintf(mSubTopic.data(), mSubTopic.size(), "%s/data", mIv->config->name);
+                            mPublish(mSubTopic.data(), msg, false, QOS_0);
+                        }
+                    } else if (mCfg->json && (RealTimeRunData_Debug == mCmd)) {
                         DynamicJsonDocument doc(300);
 
                         for (mPos = 0; mPos < rec->length; mPos++) {
@@ -231,17 +257,21 @@ class PubMqttIvData {
                                 publish = true;
 
                             if (publish) {
-                                doc[F("ts")] = rec->ts;
-                                // if next channel or end->publish
-                                serializeJson(doc, mVal.data(), mVal.size());
-                                snprintf(mSubTopic.data(), mSubTopic.size(), "%s/ch%d", mIv->config->name, rec->assign[mPos].ch);
-                                mPublish(mSubTopic.data(), mVal.data(), false, QOS_0);
+                                // if next channel or end->publish, with report by exception only
+                                // if a value of the channel exceeds its deadband
+                                if (!mRbe || (0 != (mChChanged & (1 << rec->assign[mPos].ch)))) {
+                                    doc[F("ts")] = rec->ts;
+                                    serializeJson(doc, mVal.data(), mVal.size());
+                                    snprintf(mSubTopic.data(), mSubTopic.size(), "%s/ch%d", mIv->config->name, rec->assign[mPos].ch);
+                                    mPublish(mSubTopic.data(), mVal.data(), false, QOS_0);
+                                }
                                 doc.clear();
                             }
                         }
                     }
 
-                    sendRadioStat(rec->length);
+                    if(mRbeAll && !mBatch)
+                        sendRadioStat(rec->length);
                     rec->mqttSentStatus = MqttSentStatus::DATA_SENT;
                 }
                 mState = FIND_NXT_IV;
@@ -345,6 +375,11 @@ class PubMqttIvData {
         uint8_t mPos = 0;
         bool mRTRDataHasBeenSent = false;
 
+        PubMqttDeadband mDeadband;
+        PubMqttBatch mBatchMsg;
+        bool mBatch = false, mRbe = false, mRbeAll = true;
+        uint8_t mChChanged = 0; // bit per channel: at least one value was published
+
         std::array<char, (32 + MAX_NAME_LENGTH + 1)> mSubTopic;
         std::array<char, 300> mVal;
 
@@ -0,0 +1,97 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __PUB_MQTT_RX_QUEUE_H__
+#define __PUB_MQTT_RX_QUEUE_H__
+
+#include <cstdint>
+#include <cstring>
+#include "../config/settings.h"
+
+#define MQTT_RX_SLOTS           8
+#define MQTT_RX_TOPIC_LEN       (MQTT_TOPIC_LEN + 32)
+#define MQTT_RX_PAYLOAD_LEN     32  // control messages are numbers
+
+//-----------------------------------------------------------------------------
+// Received messages in a fixed number of slots (FIFO), nothing is allocated.
+// A message whose topic is already queued replaces the queued one (latest
+// wins, e.g. repeated power limits of an inverter), it is moved to the end to
+// keep the order of the messages received in between. Messages are dropped if
+// all slots are used or if they don't fit into a slot (counted separately).
+// Not thread safe, the caller has to lock.
+//-----------------------------------------------------------------------------
+class PubMqttRxQueue {
+    public:
+        typedef struct {
+            char topic[MQTT_RX_TOPIC_LEN];
+            uint8_t payload[MQTT_RX_PAYLOAD_LEN];
+            uint8_t len;
+        } message_t;
+
+        // returns false if the message was dropped
+        bool push(const char *topic, const uint8_t *payload, size_t len, size_t index, size_t total) {
+            size_t topicLen = strlen(topic);
+            if((0 != index) || (total > MQTT_RX_PAYLOAD_LEN) || (len > MQTT_RX_PAYLOAD_LEN) || (topicLen >= MQTT_RX_TOPIC_LEN)) {
+                mTooLarge++;
+                return false;
+            }
+
+            if(remove(topic))
+                mCoalesced++;
+            else if(MQTT_RX_SLOTS == mCnt) {
+                mDropped++;
+                return false;
+            }
+            message_t *msg = &mSlot[(mHead + mCnt) % MQTT_RX_SLOTS];
+            memcpy(msg->topic, topic, topicLen + 1);
+            mCnt++;
+            memcpy(msg->payload, payload, len);
+            msg->len = len;
+            return true;
+        }
+
+        // copies the oldest message to 'out' and frees its slot
+        bool pop(message_t *out) {
+            if(0 == mCnt)
+                return false;
+            *out = mSlot[mHead];
+            mHead = (mHead + 1) % MQTT_RX_SLOTS;
+            mCnt--;
+            return true;
+        }
+
+        inline uint32_t getDroppedCnt(void) const {
+            return mDropped;
+        }
+
+        inline uint32_t getCoalescedCnt(void) const {
+            return mCoalesced;
+        }
+
+        inline uint32_t getTooLargeCnt(void) const {
+            return mTooLarge;
+        }
+
+    private:
+        // removes the queued message of 'topic', the newer ones move up
+        bool remove(const char *topic) {
+            for(uint8_t i = 0; i < mCnt; i++) {
+                if(0 != strcmp(mSlot[(mHead + i) % MQTT_RX_SLOTS].topic, topic))
+                    continue;
+                for(uint8_t j = i + 1; j < mCnt; j++)
+                    mSlot[(mHead + j - 1) % MQTT_RX_SLOTS] = mSlot[(mHead + j) % MQTT_RX_SLOTS];
+                mCnt--;
+                return true;
+            }
+            return false;
+        }
+
+    private:
+        message_t mSlot[MQTT_RX_SLOTS];
+        uint8_t mHead = 0, mCnt = 0;
+        uint32_t mDropped = 0, mCoalesced = 0, mTooLarge = 0;
+};
+
+#endif /*__PUB_MQTT_RX_QUEUE_H__*/
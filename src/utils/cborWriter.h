@@ -0,0 +1,103 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __CBOR_WRITER_H__
+#define __CBOR_WRITER_H__
+
+#include <cstring>
+#include "chunkWriter.h"
+
+namespace ah {
+    //-------------------------------------------------------------------------
+    // Writes CBOR (RFC 8949) through a ChunkWriter. Maps and arrays have a
+    // definite length: the number of pairs / elements is written first.
+    //-------------------------------------------------------------------------
+    class CborWriter {
+        public:
+            CborWriter(ChunkWriter *wr) : mWr(wr) {}
+
+            void beginMap(uint32_t pairs) {
+                writeHead(5, pairs);
+            }
+
+            void beginArray(uint32_t len) {
+                writeHead(4, len);
+            }
+
+            void add(const char *str) {
+                size_t len = strlen(str);
+                writeHead(3, len);
+                for(size_t i = 0; i < len; i++)
+                    mWr->write(str[i]);
+            }
+
+            void add(uint64_t val) {
+                writeHead(0, val);
+            }
+
+            void add(int64_t val) {
+                if(val < 0)
+                    writeHead(1, (uint64_t)(-(val + 1)));
+                else
+                    writeHead(0, (uint64_t)val);
+            }
+
+            void add(uint32_t val) { add((uint64_t)val); }
+            void add(uint16_t val) { add((uint64_t)val); }
+            void add(uint8_t val)  { add((uint64_t)val); }
+            void add(int32_t val)  { add((int64_t)val); }
+            void add(int8_t val)   { add((int64_t)val); }
+
+            void add(bool val) {
+                mWr->write((char)(val ? 0xf5 : 0xf4));
+            }
+
+            // single precision, the type of the records
+            void add(float val) {
+                uint32_t bits;
+                memcpy(&bits, &val, sizeof(bits));
+                mWr->write((char)0xfa);
+                writeBE(bits, 4);
+            }
+
+            // text key and value of a map
+            template<typename T>
+            void add(const char *key, T val) {
+                add(key);
+                add(val);
+            }
+
+        private:
+            // major type and argument in the shortest form
+            void writeHead(uint8_t major, uint64_t val) {
+                major <<= 5;
+                if(val < 24)
+                    mWr->write((char)(major | val));
+                else if(val <= 0xff) {
+                    mWr->write((char)(major | 24));
+                    writeBE(val, 1);
+                } else if(val <= 0xffff) {
+                    mWr->write((char)(major | 25));
+                    writeBE(val, 2);
+                } else if(val <= 0xffffffff) {
+                    mWr->write((char)(major | 26));
+                    writeBE(val, 4);
+                } else {
+                    mWr->write((char)(major | 27));
+                    writeBE(val, 8);
+                }
+            }
+
+            void writeBE(uint64_t val, uint8_t len) {
+                while(len-- > 0)
+                    mWr->write((char)(val >> (8 * len)));
+            }
+
+        private:
+            ChunkWriter *mWr;
+    };
+}
+
+#endif /*__CBOR_WRITER_H__*/
@@ -0,0 +1,142 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __CHUNK_WRITER_H__
+#define __CHUNK_WRITER_H__
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace ah {
+    //-------------------------------------------------------------------------
+    // Formats text directly into the buffer of a chunked response, nothing is
+    // allocated. The output is split into items, an item which doesn't fit
+    // completely is written again in the next chunk: the bytes which were
+    // already sent are skipped (startItem(sent)), getItemLen() returns the
+    // number of bytes of the current item sent so far.
+    //-------------------------------------------------------------------------
+    class ChunkWriter {
+        public:
+            ChunkWriter(uint8_t *buf, size_t maxLen) : mBuf(buf), mMax(maxLen) {}
+
+            void startItem(size_t sent) {
+                mSkip    = sent;
+                mItemLen = 0;
+            }
+
+            // the item got shorter since the last chunk (changed value), its
+            // line is terminated to keep the output readable
+            void endItem(void) {
+                if(0 != mSkip) {
+                    mSkip = 0;
+                    write('\n');
+                }
+            }
+
+            inline void write(char c) {
+                if(mFull)
+                    return;
+                if(0 != mSkip)
+                    mSkip--;
+                else if(mLen == mMax) {
+                    mFull = true;
+                    return;
+                } else
+                    mBuf[mLen++] = c;
+                mItemLen++;
+            }
+
+            void write(const char *str) {
+                while(('\0' != *str) && !mFull)
+                    write(*str++);
+            }
+
+            void writeUInt(uint64_t val) {
+                char tmp[20];
+                uint8_t i = 0;
+                do {
+                    tmp[i++] = '0' + (val % 10);
+                    val /= 10;
+                } while(0 != val);
+                while(i > 0)
+                    write(tmp[--i]);
+            }
+
+            void writeInt(int64_t val) {
+                if(val < 0) {
+                    write('-');
+                    writeUInt(-(uint64_t)val);
+                } else
+                    writeUInt(val);
+            }
+
+            // hex, padded with spaces to 'width' like "%12llx"
+            void writeHex(uint64_t val, uint8_t width = 0) {
+                char tmp[16];
+                uint8_t i = 0;
+                do {
+                    tmp[i++] = "0123456789abcdef"[val & 0x0f];
+                    val >>= 4;
+                } while(0 != val);
+                while(width-- > i)
+                    write(' ');
+                while(i > 0)
+                    write(tmp[--i]);
+            }
+
+            // 'val' / 10^dec with 'dec' decimals
+            void writeFixed(int64_t val, uint8_t dec) {
+                uint64_t div = 1;
+                for(uint8_t i = 0; i < dec; i++)
+                    div *= 10;
+                uint64_t abs = (val < 0) ? -(uint64_t)val : val;
+                if(val < 0)
+                    write('-');
+                writeUInt(abs / div);
+                if(0 == dec)
+                    return;
+                write('.');
+                uint64_t frac = abs % div;
+                for(div /= 10; div > 0; div /= 10) {
+                    write('0' + (frac / div));
+                    frac %= div;
+                }
+            }
+
+            // like "%.3f", non finite values in Prometheus notation
+            void writeFloat(float val, uint8_t dec = 3) {
+                double scale = 1.0;
+                for(uint8_t i = 0; i < dec; i++)
+                    scale *= 10.0;
+                if(std::isnan(val) || (fabs(val * scale) > 9.0e18))
+                    write(std::isinf(val) ? ((val < 0) ? "-Inf" : "+Inf") : "NaN");
+                else
+                    writeFixed(llround(val * scale), dec);
+            }
+
+            bool isFull(void) const {
+                return mFull;
+            }
+
+            size_t getItemLen(void) const {
+                return mItemLen;
+            }
+
+            size_t getLength(void) const {
+                return mLen;
+            }
+
+        private:
+            uint8_t *mBuf;
+            size_t mMax;
+            size_t mLen = 0;
+            size_t mSkip = 0;
+            size_t mItemLen = 0;
+            bool mFull = false;
+    };
+}
+
+#endif /*__CHUNK_WRITER_H__*/
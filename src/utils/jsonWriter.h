@@ -0,0 +1,159 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __JSON_WRITER_H__
+#define __JSON_WRITER_H__
+
+#include "chunkWriter.h"
+
+#define JSON_MAX_DEPTH      32
+
+namespace ah {
+    //-------------------------------------------------------------------------
+    // Writes JSON through a ChunkWriter without building a document. The
+    // nesting (state_t) is kept outside, so one document can be written in
+    // several calls. 'key' is nullptr for the elements of an array.
+    //-------------------------------------------------------------------------
+    class JsonWriter {
+        public:
+            typedef struct {
+                uint32_t first; // bit per depth: no element written yet
+                uint8_t depth;
+            } state_t;
+
+            JsonWriter(ChunkWriter *wr, state_t *state) : mWr(wr), mState(state) {}
+
+            static void reset(state_t *state) {
+                state->first = 0;
+                state->depth = 0;
+            }
+
+            void beginObject(const char *key = nullptr) {
+                begin(key, '{');
+            }
+
+            void endObject(void) {
+                end('}');
+            }
+
+            void beginArray(const char *key = nullptr) {
+                begin(key, '[');
+            }
+
+            void endArray(void) {
+                end(']');
+            }
+
+            void add(const char *key, const char *val) {
+                writeKey(key);
+                writeString(val);
+            }
+
+            void addNull(const char *key) {
+                writeKey(key);
+                mWr->write("null");
+            }
+
+            void add(const char *key, bool val) {
+                writeKey(key);
+                mWr->write(val ? "true" : "false");
+            }
+
+            void add(const char *key, int32_t val) {
+                writeKey(key);
+                mWr->writeInt(val);
+            }
+
+            void add(const char *key, uint32_t val) {
+                writeKey(key);
+                mWr->writeUInt(val);
+            }
+
+            void add(const char *key, uint16_t val) { add(key, (uint32_t)val); }
+            void add(const char *key, uint8_t val)  { add(key, (uint32_t)val); }
+            void add(const char *key, int8_t val)   { add(key, (int32_t)val); }
+
+            // rounded to 'dec' decimals, without trailing zeros
+            void add(const char *key, float val, uint8_t dec) {
+                writeKey(key);
+                int64_t scale = 1;
+                for(uint8_t i = 0; i < dec; i++)
+                    scale *= 10;
+                if(std::isnan(val) || std::isinf(val) || (fabs(val * scale) > 9.0e18)) {
+                    mWr->write("null");
+                    return;
+                }
+                int64_t fixed = llround((double)val * scale);
+                while((dec > 0) && (0 == (fixed % 10))) {
+                    fixed /= 10;
+                    dec--;
+                }
+                mWr->writeFixed(fixed, dec);
+            }
+
+            // hex string without leading zeros like String(val, HEX)
+            void addHex(const char *key, uint64_t val) {
+                writeKey(key);
+                mWr->write('"');
+                mWr->writeHex(val);
+                mWr->write('"');
+            }
+
+        private:
+            void begin(const char *key, char c) {
+                writeKey(key);
+                mWr->write(c);
+                if(mState->depth < JSON_MAX_DEPTH) {
+                    mState->first |= (1UL << mState->depth);
+                    mState->depth++;
+                }
+            }
+
+            void end(char c) {
+                if(mState->depth > 0) {
+                    mState->depth--;
+                    mState->first &= ~(1UL << mState->depth);
+                }
+                mWr->write(c);
+            }
+
+            // separator of the previous element and the key if in an object
+            void writeKey(const char *key) {
+                if(0 != mState->depth) {
+                    uint32_t mask = 1UL << (mState->depth - 1);
+                    if(0 == (mState->first & mask))
+                        mWr->write(',');
+                    mState->first &= ~mask;
+                }
+                if(nullptr != key) {
+                    writeString(key);
+                    mWr->write(':');
+                }
+            }
+
+            void writeString(const char *str) {
+                mWr->write('"');
+                for(; '\0' != *str; str++) {
+                    char c = *str;
+                    if(('"' == c) || ('\\' == c)) {
+                        mWr->write('\\');
+                        mWr->write(c);
+                    } else if((uint8_t)c < 0x20) {
+                        mWr->write("\\u00");
+                        mWr->write("0123456789abcdef"[(c >> 4) & 0x0f]);
+                        mWr->write("0123456789abcdef"[c & 0x0f]);
+                    } else
+                        mWr->write(c);
+                }
+                mWr->write('"');
+            }
+
+        private:
+            ChunkWriter *mWr;
+            state_t *mState;
+    };
+}
+
+#endif /*__JSON_WRITER_H__*/
@@ -0,0 +1,120 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __PERF_H__
+#define __PERF_H__
+
+#if defined(ENABLE_PROFILER)
+
+#include <Arduino.h>
+#include <cstring>
+
+#define PERF_HIST_BUCKETS   8
+#define PERF_MAX_TICKER     30      // same as MAX_NUM_TICKER of the scheduler
+#define PERF_NONE           0xff
+
+namespace ah {
+    // upper bounds of the histogram buckets [us], the last bucket is +Inf
+    static const uint32_t perfBounds[PERF_HIST_BUCKETS - 1] = {50, 200, 1000, 5000, 20000, 100000, 500000};
+
+    enum class PerfSection : uint8_t {LOOP, NRF, CMT, COMM, MQTT, DISPLAY, CNT};
+    static const char* const perfSectionNames[] = {"loop", "nrf", "cmt", "comm", "mqtt", "display"};
+
+    struct perfStat_t {
+        uint32_t cnt = 0;
+        uint32_t max = 0;   // [us]
+        uint64_t sum = 0;   // [us]
+
+        inline void add(uint32_t us) {
+            cnt++;
+            sum += us;
+            if(us > max)
+                max = us;
+        }
+    };
+
+    struct perfHist_t : perfStat_t {
+        uint32_t hist[PERF_HIST_BUCKETS] = {0};
+
+        inline void add(uint32_t us) {
+            perfStat_t::add(us);
+            uint8_t i = 0;
+            while((i < (PERF_HIST_BUCKETS - 1)) && (us > perfBounds[i]))
+                i++;
+            hist[i]++;
+        }
+    };
+
+    //-------------------------------------------------------------------------
+    // Run times of the main loop, of the modules called by it and of the
+    // scheduler callbacks. The sections keep a histogram, the tickers (by
+    // name) only count, sum and max. Each entry is written by one task only,
+    // the readers (web) may see a value which is just being updated.
+    //-------------------------------------------------------------------------
+    class Perf {
+        public:
+            inline void add(PerfSection s, uint32_t us) {
+                mSection[static_cast<uint8_t>(s)].add(us);
+            }
+
+            inline void addTicker(uint8_t id, uint32_t us) {
+                if(id < mTickerCnt)
+                    mTicker[id].add(us);
+            }
+
+            // returns the id of the ticker 'name' (6 chars, zero padded), a
+            // new one is created if it is not known yet
+            uint8_t getTickerId(const char name[6]) {
+                for(uint8_t i = 0; i < mTickerCnt; i++) {
+                    if(0 == memcmp(name, mTickerName[i], 6))
+                        return i;
+                }
+                if(PERF_MAX_TICKER == mTickerCnt)
+                    return PERF_NONE;
+                memcpy(mTickerName[mTickerCnt], name, 6);
+                return mTickerCnt++;
+            }
+
+            const perfHist_t *getSection(uint8_t id) const {
+                return &mSection[id];
+            }
+
+            uint8_t getTickerCnt(void) const {
+                return mTickerCnt;
+            }
+
+            const perfStat_t *getTicker(uint8_t id, const char **name) const {
+                *name = mTickerName[id];
+                return &mTicker[id];
+            }
+
+            void reset(void) {
+                for(uint8_t i = 0; i < static_cast<uint8_t>(PerfSection::CNT); i++)
+                    mSection[i] = perfHist_t();
+                for(uint8_t i = 0; i < mTickerCnt; i++)
+                    mTicker[i] = perfStat_t();
+            }
+
+        private:
+            perfHist_t mSection[static_cast<uint8_t>(PerfSection::CNT)];
+            perfStat_t mTicker[PERF_MAX_TICKER];
+            char mTickerName[PERF_MAX_TICKER][6];
+            uint8_t mTickerCnt = 0;
+    };
+
+    inline Perf gPerf;
+}
+
+#define PERF_RUN(section, call) do { \
+        uint32_t perfStart = micros(); \
+        call; \
+        ah::gPerf.add(section, micros() - perfStart); \
+    } while(0)
+
+#else
+    #define PERF_RUN(section, call) call
+#endif /*ENABLE_PROFILER*/
+
+#endif /*__PERF_H__*/
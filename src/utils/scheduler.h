@@ -8,25 +8,43 @@
 
 #include <functional>
 #include <array>
+#include <cstring>
 #include "dbg.h"
+#include "perf.h"
 
 namespace ah {
     typedef std::function<void()> scdCb;
+    typedef uint16_t scdHandle; // slot | generation << 8
 
     enum {SCD_SEC = 1, SCD_MIN = 60, SCD_HOUR = 3600, SCD_12H = 43200, SCD_DAY = 86400};
 
+    #define MAX_NUM_TICKER  30
+    #define SCD_INVALID     0xffff
+    #define SCD_NONE        0xff
+
     struct sP {
         scdCb c;
-        uint32_t timeout;
-        uint32_t reload;
+        uint32_t due;       // millis(), UTC timestamp if 'isTimestamp'
+        uint32_t reload;    // [ms], 0: once
+        uint32_t seq;       // order of adding / rescheduling
         bool isTimestamp;
+        uint8_t gen;        // generation of the slot, part of the handle
+        uint8_t pos;        // position in the heap
         char name[6];
-        sP() : c(NULL), timeout(0), reload(0), isTimestamp(false), name("\n") {}
-        sP(scdCb a, uint32_t tmt, uint32_t rl, bool its) : c(a), timeout(tmt), reload(rl), isTimestamp(its), name("\n") {}
+        #if defined(ENABLE_PROFILER)
+        uint8_t perfId = PERF_NONE;
+        #endif
+        sP() : c(NULL), due(0), reload(0), seq(0), isTimestamp(false), gen(0), pos(SCD_NONE), name("\n") {}
     };
 
-    #define MAX_NUM_TICKER  30
-
+    //-------------------------------------------------------------------------
+    // Tickers are kept in two min heaps: relative tickers by their due
+    // millis(), tickers at a timestamp by the timestamp. loop() only looks at
+    // the top of the heaps, nothing is scanned while nothing is due. Second
+    // based tickers are due on the second grid of the uptime, the ms tickers
+    // (onceMs / everyMs) at their own time.
+    // A ticker can be cancelled by its handle or by its name.
+    //-------------------------------------------------------------------------
     class Scheduler {
         public:
             void setup(bool directStart) {
@@ -34,67 +52,73 @@ namespace ah {
                 mTimestamp  = (directStart) ? 1 : 0;
                 mMax        = 0;
                 mPrevMillis = millis();
+                mMillis     = mPrevMillis;
                 mTsMillis   = mPrevMillis % 1000;
-                mFastTicker = false;
                 resetTicker();
             }
 
             virtual void loop(void) {
                 mMillis = millis();
                 mDiff = mMillis - mPrevMillis;
-                if (mDiff < 1000) {
-                    if (mFastTicker) {
-                        mDiffSeconds = 0;
-                        checkTicker();
-                        mFastTicker = false;
+                if (mDiff >= 1000) {
+                    uint32_t diffSeconds = 1;
+                    if (mDiff < 2000)
+                        mPrevMillis += 1000;
+                    else {
+                        diffSeconds = mDiff / 1000;
+                        mPrevMillis += (diffSeconds * 1000);
                     }
-                    return;
-                }
 
-                mDiffSeconds = 1;
-                if (mDiff < 2000)
-                    mPrevMillis += 1000;
-                else {
-                    if (mMillis < mPrevMillis) { // overflow
-                        mDiff = mMillis;
-                        if (mDiff < 1000)
-                            return;
+                    mUptime += diffSeconds;
+                    if(0 != mTimestamp) {
+                        mTimestamp += diffSeconds;
+                        mTsMillis  = mPrevMillis % 1000;
                     }
-                    mDiffSeconds = mDiff / 1000;
-                    mPrevMillis += (mDiffSeconds * 1000);
                 }
 
-                mUptime += mDiffSeconds;
-                if(0 != mTimestamp) {
-                    mTimestamp += mDiffSeconds;
-                    mTsMillis  = mPrevMillis % 1000;
-                }
-                checkTicker();
-
+                // tickers added by the callbacks run with the next loop
+                uint32_t seq = mSeq;
+                while((0 != mTsHeap.cnt) && (mTicker[mTsHeap.slot[0]].due <= mTimestamp) && isOlder(mTsHeap.slot[0], seq))
+                    fire(&mTsHeap);
+                while((0 != mMsHeap.cnt) && isDue(mTicker[mMsHeap.slot[0]].due) && isOlder(mMsHeap.slot[0], seq))
+                    fire(&mMsHeap);
             }
 
-            uint8_t once(scdCb c, uint32_t timeout, const char *name)     { return addTicker(c, timeout, 0, false, name); }
-            uint8_t onceAt(scdCb c, uint32_t timestamp, const char *name) { return addTicker(c, timestamp, 0, true, name); }
-            uint8_t every(scdCb c, uint32_t interval, const char *name)   { return addTicker(c, interval, interval, false, name); }
+            scdHandle once(scdCb c, uint32_t timeout, const char *name)     { return addTicker(c, gridDue(timeout * 1000), 0, false, name); }
+            scdHandle onceAt(scdCb c, uint32_t timestamp, const char *name) { return addTicker(c, timestamp, 0, true, name); }
+            scdHandle every(scdCb c, uint32_t interval, const char *name)   { return addTicker(c, gridDue(interval * 1000), interval * 1000, false, name); }
+
+            scdHandle everySec(scdCb c, const char *name)  { return every(c, SCD_SEC, name); }
+            scdHandle everyMin(scdCb c, const char *name)  { return every(c, SCD_MIN, name); }
+            scdHandle everyHour(scdCb c, const char *name) { return every(c, SCD_HOUR, name); }
+            scdHandle every12h(scdCb c, const char *name)  { return every(c, SCD_12H, name); }
+            scdHandle everyDay(scdCb c, const char *name)  { return every(c, SCD_DAY, name); }
 
-            uint8_t everySec(scdCb c, const char *name)  { return every(c, SCD_SEC, name); }
-            uint8_t everyMin(scdCb c, const char *name)  { return every(c, SCD_MIN, name); }
-            uint8_t everyHour(scdCb c, const char *name) { return every(c, SCD_HOUR, name); }
-            uint8_t every12h(scdCb c, const char *name)  { return every(c, SCD_12H, name); }
-            uint8_t everyDay(scdCb c, const char *name)  { return every(c, SCD_DAY, name); }
+            // sub second tickers, not bound to the second grid
+            scdHandle onceMs(scdCb c, uint32_t ms, const char *name)  { return addTicker(c, millis() + ms, 0, false, name); }
+            scdHandle everyMs(scdCb c, uint32_t ms, const char *name) { return addTicker(c, millis() + ms, ms, false, name); }
 
             virtual void setTimestamp(uint32_t ts) {
                 mTimestamp = ts;
             }
 
+            bool cancel(scdHandle handle) {
+                uint8_t id = handle & 0xff;
+                if((SCD_INVALID == handle) || (id >= MAX_NUM_TICKER))
+                    return false;
+                if((SCD_NONE == mTicker[id].pos) || (mTicker[id].gen != (handle >> 8)))
+                    return false;
+                remove(id);
+                return true;
+            }
+
             bool resetTickerByName(const char* name) {
+                char key[6];
+                toName(name, key);
                 for (uint8_t id = 0; id < MAX_NUM_TICKER; id++) {
-                    if (mTickerInUse[id]) {
-                        if(strncmp(name, mTicker[id].name, strlen(name)) == 0) {
-                            mTicker[id].timeout = mTicker[id].reload;
-                            mTickerInUse[id] = false;
-                            return true;
-                        }
+                    if ((SCD_NONE != mTicker[id].pos) && (0 == memcmp(key, mTicker[id].name, sizeof(key)))) {
+                        remove(id);
+                        return true;
                     }
                 }
 
@@ -106,7 +130,10 @@ namespace ah {
             }
 
             inline void resetTicker(void) {
-                mTickerInUse.fill(false);
+                for (uint8_t i = 0; i < MAX_NUM_TICKER; i++)
+                    mTicker[i].pos = SCD_NONE;
+                mMsHeap.cnt = 0;
+                mTsHeap.cnt = 0;
             }
 
             void getStat(uint8_t *max) {
@@ -115,10 +142,15 @@ namespace ah {
 
             void printSchedulers() {
                 for (uint8_t i = 0; i < MAX_NUM_TICKER; i++) {
-                    if (mTickerInUse[i]) {
+                    if (SCD_NONE != mTicker[i].pos) {
                         DPRINT(DBG_INFO, String(mTicker[i].name));
-                        DBGPRINT(", tmt: ");
-                        DBGPRINT(String(mTicker[i].timeout));
+                        if(mTicker[i].isTimestamp) {
+                            DBGPRINT(", at: ");
+                            DBGPRINT(String(mTicker[i].due));
+                        } else {
+                            DBGPRINT(", tmt: ");
+                            DBGPRINT(String((int32_t)(mTicker[i].due - millis())));
+                        }
                         DBGPRINT(", rel: ");
                         DBGPRINTLN(String(mTicker[i].reload));
                     }
@@ -131,54 +163,155 @@ namespace ah {
             uint16_t mTsMillis;
 
         private:
-            uint8_t addTicker(scdCb c, uint32_t timeout, uint32_t reload, bool isTimestamp, const char *name) {
+            typedef struct {
+                std::array<uint8_t, MAX_NUM_TICKER> slot;
+                uint8_t cnt = 0;
+            } heap_t;
+
+            // due time 'ms' after the last second of the uptime
+            inline uint32_t gridDue(uint32_t ms) const {
+                return (0 == ms) ? millis() : (mPrevMillis + ms);
+            }
+
+            inline bool isDue(uint32_t due) const {
+                return ((int32_t)(due - mMillis) <= 0);
+            }
+
+            inline bool isOlder(uint8_t id, uint32_t seq) const {
+                return ((int32_t)(mTicker[id].seq - seq) < 0);
+            }
+
+            static void toName(const char *name, char key[6]) {
+                memset(key, 0, 6);
+                strncpy(key, name, 5);
+            }
+
+            scdHandle addTicker(scdCb c, uint32_t due, uint32_t reload, bool isTimestamp, const char *name) {
+                uint8_t cnt = 0;
+                uint8_t id = SCD_NONE;
                 for (uint8_t i = 0; i < MAX_NUM_TICKER; i++) {
-                    if (!mTickerInUse[i]) {
-                        mTickerInUse[i] = true;
-                        mTicker[i].c = c;
-                        mTicker[i].timeout = timeout;
-                        mTicker[i].reload = reload;
-                        mTicker[i].isTimestamp = isTimestamp;
-                        strncpy(mTicker[i].name, name, 5);
-                        mTicker[i].name[5]=0;
-                        if (timeout == 0 && reload == false)
-                            mFastTicker = true;
-                        if(mMax == i)
-                            mMax = i + 1;
-                        return i;
-                    }
+                    if (SCD_NONE != mTicker[i].pos)
+                        cnt++;
+                    else if ((SCD_NONE == id) && (i != mRunning))
+                        id = i;
+                }
+                if(SCD_NONE == id) {
+                    DPRINT(DBG_ERROR, F("no free ticker for "));
+                    DBGPRINTLN(String(name));
+                    return SCD_INVALID;
                 }
-                return 0xff;
+
+                sP *t = &mTicker[id];
+                t->c           = c;
+                t->due         = due;
+                t->reload      = reload;
+                t->isTimestamp = isTimestamp;
+                t->seq         = mSeq++;
+                t->gen++;
+                toName(name, t->name);
+                #if defined(ENABLE_PROFILER)
+                t->perfId = gPerf.getTickerId(t->name);
+                #endif
+                push(isTimestamp ? &mTsHeap : &mMsHeap, id);
+
+                if(mMax <= cnt)
+                    mMax = cnt + 1;
+                return (t->gen << 8) | id;
             }
 
-            inline void checkTicker(void) {
-                bool inUse[MAX_NUM_TICKER];
-                for (uint8_t i = 0; i < MAX_NUM_TICKER; i++)
-                    inUse[i] = mTickerInUse[i];
-                for (uint8_t i = 0; i < MAX_NUM_TICKER; i++) {
-                    if (inUse[i]) {
-                        if (mTicker[i].timeout <= ((mTicker[i].isTimestamp) ? mTimestamp : mDiffSeconds)) { // expired
-                            if(0 == mTicker[i].reload)
-                                mTickerInUse[i] = false;
-                            else
-                                mTicker[i].timeout = mTicker[i].reload;
-                            //DPRINTLN(DBG_INFO, "checkTick " + String(i) + " reload: " + String(mTicker[i].reload) + ", timeout: " + String(mTicker[i].timeout));
-                            (mTicker[i].c)();
-                            yield();
-                        }
-                        else // not expired
-                            if (!mTicker[i].isTimestamp)
-                                mTicker[i].timeout -= mDiffSeconds;
-                    }
+            // the due ticker on top of 'h' is rescheduled or removed before
+            // its callback runs, the callback may add or cancel tickers
+            void fire(heap_t *h) {
+                uint8_t id = h->slot[0];
+                sP *t = &mTicker[id];
+                if(0 == t->reload)
+                    pop(h, 0);
+                else {
+                    uint32_t due = t->due + t->reload;
+                    if(isDue(due)) // loop was blocked, no catch up
+                        due = ((0 == (t->reload % 1000)) ? mPrevMillis : mMillis) + t->reload;
+                    t->due = due;
+                    t->seq = mSeq++;
+                    siftDown(h, 0);
+                }
+
+                mRunning = id;
+                #if defined(ENABLE_PROFILER)
+                uint32_t start = micros();
+                (t->c)();
+                gPerf.addTicker(t->perfId, micros() - start);
+                #else
+                (t->c)();
+                #endif
+                mRunning = SCD_NONE;
+                yield();
+            }
+
+            void remove(uint8_t id) {
+                pop(mTicker[id].isTimestamp ? &mTsHeap : &mMsHeap, mTicker[id].pos);
+            }
+
+            inline bool before(uint8_t a, uint8_t b) const {
+                const sP *ta = &mTicker[a], *tb = &mTicker[b];
+                int32_t diff = ta->isTimestamp ? ((ta->due < tb->due) ? -1 : (ta->due > tb->due)) : (int32_t)(ta->due - tb->due);
+                return (diff < 0) || ((0 == diff) && (a < b)); // same order as the slots
+            }
+
+            inline void place(heap_t *h, uint8_t pos, uint8_t id) {
+                h->slot[pos] = id;
+                mTicker[id].pos = pos;
+            }
+
+            void push(heap_t *h, uint8_t id) {
+                place(h, h->cnt++, id);
+                siftUp(h, h->cnt - 1);
+            }
+
+            void pop(heap_t *h, uint8_t pos) {
+                uint8_t id = h->slot[pos];
+                uint8_t last = h->slot[--h->cnt];
+                mTicker[id].pos = SCD_NONE;
+                if(pos == h->cnt)
+                    return;
+                place(h, pos, last);
+                siftUp(h, pos);
+                siftDown(h, mTicker[last].pos);
+            }
+
+            void siftUp(heap_t *h, uint8_t pos) {
+                uint8_t id = h->slot[pos];
+                while(pos > 0) {
+                    uint8_t parent = (pos - 1) / 2;
+                    if(!before(id, h->slot[parent]))
+                        break;
+                    place(h, pos, h->slot[parent]);
+                    pos = parent;
+                }
+                place(h, pos, id);
+            }
+
+            void siftDown(heap_t *h, uint8_t pos) {
+                uint8_t id = h->slot[pos];
+                while(true) {
+                    uint8_t child = 2 * pos + 1;
+                    if(child >= h->cnt)
+                        break;
+                    if(((child + 1) < h->cnt) && before(h->slot[child + 1], h->slot[child]))
+                        child++;
+                    if(!before(h->slot[child], id))
+                        break;
+                    place(h, pos, h->slot[child]);
+                    pos = child;
                 }
+                place(h, pos, id);
             }
 
             std::array<sP, MAX_NUM_TICKER> mTicker;
-            std::array<bool, MAX_NUM_TICKER> mTickerInUse;
+            heap_t mMsHeap, mTsHeap;
             uint32_t mMillis = 0, mPrevMillis = 0, mDiff = 0;
-            uint8_t mDiffSeconds = 0;
+            uint32_t mSeq = 0;
+            uint8_t mRunning = SCD_NONE;    // ticker whose callback is running, its slot is not reused
             uint8_t mMax = 0;
-            bool mFastTicker;
     };
 }
 
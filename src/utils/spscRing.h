@@ -0,0 +1,88 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __SPSC_RING_H__
+#define __SPSC_RING_H__
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+//-----------------------------------------------------------------------------
+// Preallocated lock free ring for one producer and one consumer (task / task
+// or ISR / task). The producer fills the slot returned by reserve() in place
+// and publishes it with commit(), the consumer reads front() by reference and
+// releases it with pop(). If the ring is full reserve() returns a spare slot,
+// commit() drops it and counts the overflow.
+//-----------------------------------------------------------------------------
+template<class T, uint8_t N>
+class SpscRing {
+    static_assert((N > 0) && (N <= 128) && (0 == (N & (N - 1))), "size must be a power of 2 up to 128");
+
+    public:
+        // producer
+        T *reserve(void) {
+            uint8_t wr = mWr.load(std::memory_order_relaxed);
+            if(isFull(wr))
+                return &mSpare;
+            return &mBuf[wr & (N - 1)];
+        }
+
+        // returns false if the element was dropped
+        bool commit(void) {
+            uint8_t wr = mWr.load(std::memory_order_relaxed);
+            if(isFull(wr)) {
+                mOverflowCnt++;
+                return false;
+            }
+            mWr.store(wr + 1, std::memory_order_release);
+            return true;
+        }
+
+        // copies 'val' into the ring, returns false if the ring is full
+        bool push(const T &val) {
+            *reserve() = val;
+            return commit();
+        }
+
+        bool full(void) const {
+            return isFull(mWr.load(std::memory_order_relaxed));
+        }
+
+        // consumer
+        bool empty(void) const {
+            return mRd.load(std::memory_order_relaxed) == mWr.load(std::memory_order_acquire);
+        }
+
+        T &front(void) {
+            return mBuf[mRd.load(std::memory_order_relaxed) & (N - 1)];
+        }
+
+        void pop(void) {
+            mRd.store(mRd.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        uint8_t size(void) const {
+            return mWr.load(std::memory_order_acquire) - mRd.load(std::memory_order_relaxed);
+        }
+
+        uint32_t getOverflowCnt(void) const {
+            return mOverflowCnt;
+        }
+
+    private:
+        inline bool isFull(uint8_t wr) const {
+            return ((uint8_t)(wr - mRd.load(std::memory_order_acquire)) >= N);
+        }
+
+    private:
+        std::array<T, N> mBuf;
+        T mSpare;
+        std::atomic<uint8_t> mWr{0};
+        std::atomic<uint8_t> mRd{0};
+        uint32_t mOverflowCnt = 0;
+};
+
+#endif /*__SPSC_RING_H__*/
@@ -0,0 +1,379 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __API_STREAM_H__
+#define __API_STREAM_H__
+
+#include <algorithm>
+#include <cstring>
+#include "../utils/dbg.h"
+#include "../utils/cborWriter.h"
+#include "../utils/jsonWriter.h"
+#include "../config/settings.h"
+#include "../hm/hmInverter.h"
+#include "lang.h"
+
+#define API_STREAM_ITEM_SIZE    256     // largest item: the settings of an inverter with its escaped name
+                                        // (about 220 bytes), channel names and values are items of their own
+
+constexpr uint8_t acList[] = {FLD_UAC, FLD_IAC, FLD_PAC, FLD_F, FLD_PF, FLD_T, FLD_YT,
+    FLD_YD, FLD_PDC, FLD_EFF, FLD_Q, FLD_MP, FLD_MT};
+constexpr uint8_t acListHmt[] = {FLD_UAC_1N, FLD_IAC_1, FLD_PAC, FLD_F, FLD_PF, FLD_T,
+    FLD_YT, FLD_YD, FLD_PDC, FLD_EFF, FLD_Q, FLD_MP, FLD_MT};
+constexpr uint8_t dcList[] = {FLD_UDC, FLD_IDC, FLD_PDC, FLD_YD, FLD_YT, FLD_IRR, FLD_MP};
+
+//-----------------------------------------------------------------------------
+// Response of an API endpoint written in chunks, the memory needed is the
+// same for any size of the response. The response is written in items (a few
+// values) by writeItem() into a small buffer which is copied into the chunks.
+// Unlike the Prometheus output an item is not formatted again if it is split,
+// a value which changes in between can't break the response.
+//-----------------------------------------------------------------------------
+class ApiStream {
+    public:
+        virtual ~ApiStream() {}
+
+        virtual const char *getContentType(void) const {
+            return "application/json";
+        }
+
+        // returns 0 if the response is complete
+        size_t fill(uint8_t *buf, size_t maxLen) {
+            size_t len = 0;
+            while(len < maxLen) {
+                if(mItemPos == mItemLen) {
+                    if(mDone)
+                        break;
+                    ah::ChunkWriter wr(mItem, API_STREAM_ITEM_SIZE);
+                    mDone    = !writeItem(&wr);
+                    mItemLen = wr.getLength();
+                    mItemPos = 0;
+                    if(wr.isFull())
+                        DPRINTLN(DBG_ERROR, F("api stream: item too large"));
+                }
+                size_t cnt = std::min(maxLen - len, (size_t)(mItemLen - mItemPos));
+                memcpy(&buf[len], &mItem[mItemPos], cnt);
+                mItemPos += cnt;
+                len      += cnt;
+            }
+            return len;
+        }
+
+    protected:
+        // writes the next item, returns false after the last one
+        virtual bool writeItem(ah::ChunkWriter *wr) = 0;
+
+        uint8_t mStep = 0;
+        uint8_t mId = 0;        // inverter or channel
+
+    private:
+        uint8_t mItem[API_STREAM_ITEM_SIZE];
+        uint16_t mItemLen = 0, mItemPos = 0;
+        bool mDone = false;
+};
+
+//-----------------------------------------------------------------------------
+// JSON document written in items, the nesting is kept between the items
+//-----------------------------------------------------------------------------
+class JsonStream : public ApiStream {
+    protected:
+        bool writeItem(ah::ChunkWriter *wr) override {
+            ah::JsonWriter json(wr, &mJson);
+            return writeJson(&json);
+        }
+
+        virtual bool writeJson(ah::JsonWriter *json) = 0;
+
+    private:
+        ah::JsonWriter::state_t mJson = {0, 0};
+};
+
+//-----------------------------------------------------------------------------
+// /api/inverter/list
+//-----------------------------------------------------------------------------
+template<class HMSYSTEM>
+class InverterListStream : public JsonStream {
+    public:
+        InverterListStream(HMSYSTEM *sys, cfgInst_t *cfg) : mSys(sys), mCfg(cfg) {}
+
+    protected:
+        bool writeJson(ah::JsonWriter *json) override {
+            Inverter<> *iv = (mId < MAX_NUM_INVERTERS) ? mSys->getInverterByPos(mId) : nullptr;
+            switch(mStep) {
+                case 0:
+                    json->beginObject();
+                    json->beginArray("inverter");
+                    mStep = 1;
+                    break;
+
+                case 1:
+                    while((nullptr == iv) && (++mId < MAX_NUM_INVERTERS))
+                        iv = mSys->getInverterByPos(mId);
+                    if(nullptr == iv) {
+                        json->endArray();
+                        mStep = 6;
+                        break;
+                    }
+                    json->beginObject();
+                    json->add("enabled",     (bool)iv->config->enabled);
+                    json->add("id",          mId);
+                    json->add("name",        iv->config->name);
+                    json->addHex("serial",   iv->config->serial.u64);
+                    json->add("channels",    iv->channels);
+                    json->add("freq",        iv->config->frequency);
+                    json->add("disnightcom", (bool)iv->config->disNightCom);
+                    if(0xff == iv->config->powerLevel)
+                        json->add("pa", (uint8_t)(((IV_HMT == iv->ivGen) || (IV_HMS == iv->ivGen)) ? 30 : 1)); // 20dBm / low
+                    else
+                        json->add("pa", iv->config->powerLevel);
+                    mStep = (0 == iv->channels) ? 5 : 2;
+                    break;
+
+                case 2:
+                    json->beginArray("ch_yield_cor");
+                    for(uint8_t j = 0; j < iv->channels; j++)
+                        json->add(nullptr, (float)iv->config->yieldCor[j], 3);
+                    json->endArray();
+                    mStep = 3;
+                    break;
+
+                case 3:
+                    json->beginArray("ch_max_pwr");
+                    for(uint8_t j = 0; j < iv->channels; j++)
+                        json->add(nullptr, iv->config->chMaxPwr[j]);
+                    json->endArray();
+                    json->beginArray("ch_name");
+                    mCh   = 0;
+                    mStep = 4;
+                    break;
+
+                case 4: // one name per item, the length depends on the escaping
+                    if(mCh < iv->channels) {
+                        json->add(nullptr, iv->config->chName[mCh++]);
+                        break;
+                    }
+                    json->endArray();
+                    mStep = 5;
+                    break;
+
+                case 5:
+                    json->endObject();
+                    mId++;
+                    mStep = 1;
+                    break;
+
+                default: {
+                    char interval[8];
+                    snprintf(interval, sizeof(interval), "%d", mCfg->sendInterval);
+                    json->add("interval",          interval);
+                    json->add("max_num_inverters", (uint8_t)MAX_NUM_INVERTERS);
+                    json->add("rstMid",            (bool)mCfg->rstValsAtMidNight);
+                    json->add("rstNotAvail",       (bool)mCfg->rstValsNotAvail);
+                    json->add("rstComStop",        (bool)mCfg->rstValsCommStop);
+                    json->add("rstComStart",       (bool)mCfg->rstValsCommStart);
+                    json->add("strtWthtTm",        (bool)mCfg->startWithoutTime);
+                    json->add("rdGrid",            (bool)mCfg->readGrid);
+                    json->add("adptIntvl",         (bool)mCfg->adaptiveInterval);
+                    json->add("lmtFast",           (bool)mCfg->limitFastPath);
+                    json->add("intvlMin",          mCfg->minInterval);
+                    json->add("intvlMax",          mCfg->maxInterval);
+                    json->add("rstMaxMid",         (bool)mCfg->rstIncludeMaxVals);
+                    json->endObject();
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+        HMSYSTEM *mSys;
+        cfgInst_t *mCfg;
+        uint8_t mCh = 0;
+};
+
+//-----------------------------------------------------------------------------
+// /api/inverter/id/<id>
+//-----------------------------------------------------------------------------
+template<class HMSYSTEM>
+class InverterStream : public JsonStream {
+    public:
+        InverterStream(HMSYSTEM *sys, uint8_t id) : mIv(sys->getInverterByPos(id)), mIvId(id) {}
+
+    protected:
+        bool writeJson(ah::JsonWriter *json) override {
+            Inverter<> *iv = mIv;
+            if(nullptr == iv) {
+                json->beginObject();
+                json->add("error", INV_NOT_FOUND);
+                json->endObject();
+                return false;
+            }
+
+            record_t<> *rec = iv->getRecordStruct(RealTimeRunData_Debug);
+            switch(mStep) {
+                case 0:
+                    json->beginObject();
+                    json->add("id",               mIvId);
+                    json->add("enabled",          (bool)iv->config->enabled);
+                    json->add("name",             iv->config->name);
+                    json->addHex("serial",        iv->config->serial.u64);
+                    json->add("version",          iv->getFwVersion());
+                    json->add("power_limit_read", iv->getChannelFieldValue(CH0, FLD_ACT_ACTIVE_PWR_LIMIT, iv->getRecordStruct(SystemConfigPara)), 1);
+                    json->add("power_limit_ack",  iv->powerLimitAck);
+                    json->add("max_pwr",          iv->getMaxPower());
+                    mStep = 1;
+                    break;
+
+                case 1:
+                    json->add("ts_last_success",  rec->ts);
+                    json->add("generation",       iv->ivGen);
+                    json->add("status",           (uint8_t)iv->getStatus());
+                    json->add("alarm_cnt",        iv->alarmCnt);
+                    json->add("rssi",             iv->rssi);
+                    json->add("ts_max_ac_pwr",    iv->tsMaxAcPower);
+                    json->add("ts_max_temp",      iv->tsMaxTemperature);
+                    json->beginArray("ch_name");
+                    json->add(nullptr, "AC");
+                    mId   = 0;
+                    mStep = 2;
+                    break;
+
+                case 2: // one name per item, the length depends on the escaping
+                    if(mId < iv->channels) {
+                        json->add(nullptr, iv->config->chName[mId++]);
+                        break;
+                    }
+                    json->endArray();
+                    mStep = 3;
+                    break;
+
+                case 3:
+                    json->beginArray("ch_max_pwr");
+                    json->addNull(nullptr); // AC
+                    for(uint8_t j = 0; j < iv->channels; j++)
+                        json->add(nullptr, iv->config->chMaxPwr[j]);
+                    json->endArray();
+                    json->beginArray("ch");
+                    mId   = 0;  // channel, 0: AC
+                    mFld  = 0;
+                    mStep = 4;
+                    break;
+
+                default: // one value per item
+                    if(mId > iv->channels) {
+                        json->endArray();
+                        json->endObject();
+                        return false;
+                    }
+                    writeValue(json, iv, rec);
+                    break;
+            }
+            return true;
+        }
+
+    private:
+        void writeValue(ah::JsonWriter *json, Inverter<> *iv, record_t<> *rec) {
+            const uint8_t *list = dcList;
+            uint8_t len = sizeof(dcList);
+            if(CH0 == mId) {
+                list = (IV_HMT == iv->ivGen) ? acListHmt : acList;
+                len  = (IV_HMT == iv->ivGen) ? sizeof(acListHmt) : sizeof(acList);
+            }
+
+            if(0 == mFld)
+                json->beginArray();
+            uint8_t pos = iv->getPosByChFld(mId, list[mFld], rec);
+            json->add(nullptr, (0xff != pos) ? (float)iv->getValue(pos, rec) : 0.0f, 3);
+            if(++mFld == len) {
+                json->endArray();
+                mFld = 0;
+                mId++;
+            }
+        }
+
+    private:
+        Inverter<> *mIv;    // the inverter stays in place even if it's deleted meanwhile
+        uint8_t mIvId;
+        uint8_t mFld = 0;
+};
+
+//-----------------------------------------------------------------------------
+// /api/live/cbor
+// measured values (recordMeas) of all inverters as CBOR for data collectors,
+// read directly from the records without formatting text:
+// {"ts_now": ts, "iv": [{"id", "serial", "generation", "status",
+// "ts_last_success", "ch": [{fieldId: value}]}]}, the index of "ch" is the
+// channel (0: AC), the keys are the field ids (index of fields[])
+//-----------------------------------------------------------------------------
+template<class HMSYSTEM>
+class RecordCborStream : public ApiStream {
+    public:
+        RecordCborStream(HMSYSTEM *sys, uint32_t tsNow) : mTsNow(tsNow) {
+            for(uint8_t i = 0; i < MAX_NUM_INVERTERS; i++) {
+                Inverter<> *iv = sys->getInverterByPos(i);
+                if(nullptr != iv)
+                    mIv[mCnt++] = iv;
+            }
+        }
+
+        const char *getContentType(void) const override {
+            return "application/cbor";
+        }
+
+    protected:
+        bool writeItem(ah::ChunkWriter *wr) override {
+            ah::CborWriter cbor(wr);
+            if(0 == mStep) {
+                cbor.beginMap(2);
+                cbor.add("ts_now", mTsNow);
+                cbor.add("iv");
+                cbor.beginArray(mCnt);
+                mStep = 1;
+                return (0 != mCnt);
+            }
+
+            Inverter<> *iv = mIv[mId];
+            record_t<> *rec = &iv->recordMeas;
+            if(1 == mStep) {
+                cbor.beginMap(6);
+                cbor.add("id",              iv->id);
+                cbor.add("serial",          iv->config->serial.u64);
+                cbor.add("generation",      (uint8_t)iv->ivGen);
+                cbor.add("status",          (uint8_t)iv->getStatus());
+                cbor.add("ts_last_success", rec->ts);
+                cbor.add("ch");
+                cbor.beginArray(iv->channels + 1);
+                mCh   = 0;
+                mStep = 2;
+                return true;
+            }
+
+            uint8_t cnt = 0;
+            for(uint8_t pos = 0; pos < rec->length; pos++) {
+                if(mCh == rec->assign[pos].ch)
+                    cnt++;
+            }
+            cbor.beginMap(cnt);
+            for(uint8_t pos = 0; pos < rec->length; pos++) {
+                if(mCh != rec->assign[pos].ch)
+                    continue;
+                cbor.add(rec->assign[pos].fieldId);
+                cbor.add((float)iv->getValue(pos, rec));
+            }
+
+            if(++mCh <= iv->channels)
+                return true;
+            mStep = 1;
+            return (++mId < mCnt);
+        }
+
+    private:
+        Inverter<> *mIv[MAX_NUM_INVERTERS];    // see InverterStream
+        uint8_t mCnt = 0;
+        uint8_t mCh = 0;
+        uint32_t mTsNow;
+};
+
+#endif /*__API_STREAM_H__*/
@@ -0,0 +1,159 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __LIVE_DELTA_H__
+#define __LIVE_DELTA_H__
+
+#include <cstring>
+#include "ApiStream.h"
+
+#define LIVE_DELTA_AC_CNT       sizeof(acList)
+#define LIVE_DELTA_DC_CNT       sizeof(dcList)
+#define LIVE_DELTA_VAL_CNT      (LIVE_DELTA_AC_CNT + 6 * LIVE_DELTA_DC_CNT)
+
+//-----------------------------------------------------------------------------
+// Live data pushed by the event source: only the fields which changed since
+// the last event of the inverter are written, in the layout of
+// /api/inverter/id/<id>. "ch" holds the changed values by channel and by the
+// index in the value list, e.g. {"id":0,"ch":{"0":{"2":231.5}}}.
+// Values are compared rounded to the 3 decimals which are sent.
+//-----------------------------------------------------------------------------
+class LiveDelta {
+    public:
+        typedef struct {
+            uint32_t tsLastSuccess;
+            uint32_t tsMaxAcPwr;
+            uint32_t tsMaxTemp;
+            int32_t val[LIVE_DELTA_VAL_CNT];
+            int32_t pwrLimitRead;   // in 0.1 %
+            uint16_t alarmCnt;
+            uint8_t status;
+            int8_t rssi;
+            bool pwrLimitAck;
+            bool valid;
+        } last_t;
+
+        LiveDelta() {
+            reset();
+        }
+
+        // next event of each inverter contains all fields
+        void reset(void) {
+            memset(mLast, 0, sizeof(mLast));
+        }
+
+        // returns the length of the event, 0 if nothing changed
+        size_t write(Inverter<> *iv, char *buf, size_t maxLen) {
+            if((nullptr == iv) || (iv->id >= MAX_NUM_INVERTERS))
+                return 0;
+
+            last_t *last = &mLast[iv->id];
+            bool all = !last->valid;
+            record_t<> *rec = iv->getRecordStruct(RealTimeRunData_Debug);
+            float pwrLimitRead = iv->getChannelFieldValue(CH0, FLD_ACT_ACTIVE_PWR_LIMIT, iv->getRecordStruct(SystemConfigPara));
+
+            ah::ChunkWriter wr(reinterpret_cast<uint8_t*>(buf), maxLen - 1);
+            ah::JsonWriter::state_t state = {0, 0};
+            ah::JsonWriter json(&wr, &state);
+            bool changed = false;
+
+            json.beginObject();
+            json.add("id", iv->id);
+            changed |= addU32(&json, "ts_last_success",  rec->ts,                   &last->tsLastSuccess, all);
+            changed |= addU32(&json, "ts_max_ac_pwr",    iv->tsMaxAcPower,          &last->tsMaxAcPwr,    all);
+            changed |= addU32(&json, "ts_max_temp",      iv->tsMaxTemperature,      &last->tsMaxTemp,     all);
+            changed |= addU32(&json, "status",           (uint8_t)iv->getStatus(),  &last->status,        all);
+            changed |= addU32(&json, "alarm_cnt",        iv->alarmCnt,              &last->alarmCnt,      all);
+            if(all || (lround(pwrLimitRead * 10.0f) != last->pwrLimitRead)) {
+                json.add("power_limit_read", pwrLimitRead, 1);
+                last->pwrLimitRead = lround(pwrLimitRead * 10.0f);
+                changed = true;
+            }
+            if(all || (iv->powerLimitAck != last->pwrLimitAck)) {
+                json.add("power_limit_ack", iv->powerLimitAck);
+                last->pwrLimitAck = iv->powerLimitAck;
+                changed = true;
+            }
+            if(all || (iv->rssi != last->rssi)) {
+                json.add("rssi", iv->rssi);
+                last->rssi = iv->rssi;
+                changed = true;
+            }
+
+            // "ch" is opened by the first changed value
+            bool open = false;
+            int32_t *val = last->val;
+            if(IV_HMT == iv->ivGen)
+                changed |= addValues(&json, iv, rec, CH0, acListHmt, LIVE_DELTA_AC_CNT, val, all, &open);
+            else
+                changed |= addValues(&json, iv, rec, CH0, acList, LIVE_DELTA_AC_CNT, val, all, &open);
+            val += LIVE_DELTA_AC_CNT;
+            for(uint8_t ch = 1; ch <= std::min(iv->channels, (uint8_t)6); ch++) {
+                changed |= addValues(&json, iv, rec, ch, dcList, LIVE_DELTA_DC_CNT, val, all, &open);
+                val += LIVE_DELTA_DC_CNT;
+            }
+            if(open) {
+                json.endObject(); // channel
+                json.endObject(); // "ch"
+            }
+            json.endObject();
+
+            if(wr.isFull()) {
+                DPRINTLN(DBG_ERROR, F("live delta: buffer too small"));
+                last->valid = false;
+                return 0;
+            }
+            last->valid = true;
+            if(!changed)
+                return 0;
+
+            buf[wr.getLength()] = '\0';
+            return wr.getLength();
+        }
+
+    private:
+        template<typename T>
+        bool addU32(ah::JsonWriter *json, const char *key, uint32_t val, T *last, bool all) {
+            if(!all && (val == (uint32_t)*last))
+                return false;
+            json->add(key, val);
+            *last = (T)val;
+            return true;
+        }
+
+        // 'open': "ch" and the object of the previous channel are open
+        bool addValues(ah::JsonWriter *json, Inverter<> *iv, record_t<> *rec, uint8_t ch, const uint8_t *list, uint8_t len, int32_t *last, bool all, bool *open) {
+            bool changed = false;
+            for(uint8_t fld = 0; fld < len; fld++) {
+                uint8_t pos = iv->getPosByChFld(ch, list[fld], rec);
+                float val = (0xff != pos) ? (float)iv->getValue(pos, rec) : 0.0f;
+                int32_t fixed = lround(val * 1000.0f);
+                if(!all && (fixed == last[fld]))
+                    continue;
+                last[fld] = fixed;
+
+                if(!changed) {
+                    if(*open)
+                        json->endObject();
+                    else
+                        json->beginObject("ch");
+                    char key[4];
+                    snprintf(key, sizeof(key), "%d", ch);
+                    json->beginObject(key);
+                    *open = true;
+                    changed = true;
+                }
+                char key[4];
+                snprintf(key, sizeof(key), "%d", fld);
+                json->add(key, val, 3);
+            }
+            return changed;
+        }
+
+    private:
+        last_t mLast[MAX_NUM_INVERTERS];
+};
+
+#endif /*__LIVE_DELTA_H__*/
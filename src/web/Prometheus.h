@@ -0,0 +1,530 @@
+//-----------------------------------------------------------------------------
+// 2024 Ahoy, https://ahoydtu.de
+// Creative Commons - https://creativecommons.org/licenses/by-nc-sa/4.0/deed
+//-----------------------------------------------------------------------------
+
+#ifndef __PROMETHEUS_H__
+#define __PROMETHEUS_H__
+
+#include "../utils/chunkWriter.h"
+#include "../utils/perf.h"
+#include "../hm/hmDefines.h"
+#include "../hm/hmInverter.h"
+
+#define PROM_PREFIX     "ahoy_solar_"
+
+typedef struct {
+    const char *version;
+    const char *deviceName;
+    uint32_t freeHeap;
+    uint32_t uptime;
+    int8_t rssi;
+} promInfo_t;
+
+//-----------------------------------------------------------------------------
+// Prometheus exposition format, see
+// https://github.com/prometheus/docs/blob/main/content/docs/instrumenting/exposition_formats.md
+// fill() writes the metrics directly into the buffer of the chunked response
+// and returns 0 if everything was sent. The output is a sequence of items
+// (mostly one line), an item which doesn't fit into the chunk is continued
+// in the next one. The system values are taken at start(), the values of an
+// item when it's started: a split item is written again in the next chunk
+// and has to give the same output.
+//-----------------------------------------------------------------------------
+template<class HMSYSTEM>
+class Prometheus {
+    public:
+        void setup(HMSYSTEM *sys) {
+            mSys = sys;
+        }
+
+        void start(const promInfo_t &info) {
+            mInfo     = info;
+            mStep     = Step::START;
+            mSent     = 0;
+            mId       = 0;
+            mIvId     = 0;
+            mPos      = 0;
+            mDeclared = false;
+            mTotalDeclared = false;
+        }
+
+        size_t fill(uint8_t *buf, size_t maxLen) {
+            ah::ChunkWriter wr(buf, maxLen);
+            while(Step::END != mStep) {
+                if(0 == mSent)
+                    takeValues();
+                wr.startItem(mSent);
+                writeItem(&wr);
+                if(wr.isFull()) {
+                    mSent = wr.getItemLen();
+                    break;
+                }
+                wr.endItem();
+                mSent = 0;
+                next();
+            }
+            return wr.getLength();
+        }
+
+    private:
+        enum class Step : uint8_t {START, IV_TYPE, IV, RT, ALARM_TYPE, ALARM, PERF_SECTION, PERF_TICKER, PERF_MAX, END};
+
+        typedef struct {
+            const char *topic;
+            const char *type;
+        } ivMetric_t;
+
+        typedef struct {
+            const char *suffix;
+            const char *type;
+        } promUnit_t;
+
+        static constexpr uint8_t IV_METRIC_CNT = 17;
+        static constexpr ivMetric_t ivMetrics[IV_METRIC_CNT] = {
+            {"info",                 "gauge"},
+            {"is_enabled",           "gauge"},
+            {"is_available",         "gauge"},
+            {"is_producing",         "gauge"},
+            {"power_limit_read",     "gauge"},
+            {"power_limit_ack",      "gauge"},
+            {"max_power",            "gauge"},
+            {"radio_rx_success",     "counter"},
+            {"radio_rx_fail",        "counter"},
+            {"radio_rx_fail_answer", "counter"},
+            {"radio_frame_cnt",      "counter"},
+            {"radio_tx_cnt",         "counter"},
+            {"radio_retransmits",    "counter"},
+            {"radio_iv_loss_cnt",    "counter"},
+            {"radio_iv_sent_cnt",    "counter"},
+            {"radio_dtu_loss_cnt",   "counter"},
+            {"radio_dtu_sent_cnt",   "counter"}
+        };
+
+        // by unit id (UNIT_V, UNIT_A, ...)
+        static constexpr promUnit_t promUnits[UNIT_NONE + 1] = {
+            {"_volt", "gauge"}, {"_ampere", "gauge"}, {"_watt", "gauge"}, {"_wattHours", "counter"},
+            {"_kilowattHours", "counter"}, {"_hertz", "gauge"}, {"_celsius", "gauge"}, {"_ratio", "gauge"},
+            {"_var", "gauge"}, {"", "gauge"}
+        };
+
+        uint64_t ivValue(uint8_t metric, Inverter<> *iv) {
+            switch(metric) {
+                default:
+                case 0:  return 1;
+                case 1:  return iv->config->enabled;
+                case 2:  return iv->isAvailable();
+                case 3:  return iv->isProducing();
+                case 4:  return iv->actPowerLimit;
+                case 5:  return (iv->powerLimitAck) ? 1 : 0;
+                case 6:  return iv->getMaxPower();
+                case 7:  return iv->radioStatistics.rxSuccess;
+                case 8:  return iv->radioStatistics.rxFail;
+                case 9:  return iv->radioStatistics.rxFailNoAnswer;
+                case 10: return iv->radioStatistics.frmCnt;
+                case 11: return iv->radioStatistics.txCnt;
+                case 12: return iv->radioStatistics.retransmits;
+                case 13: return iv->radioStatistics.ivLoss;
+                case 14: return iv->radioStatistics.ivSent;
+                case 15: return iv->radioStatistics.dtuLoss;
+                case 16: return iv->radioStatistics.dtuSent;
+            }
+        }
+
+        // writes the current item, has to give the same output as long as
+        // the state isn't changed by next()
+        void writeItem(ah::ChunkWriter *wr) {
+            Inverter<> *iv;
+            switch(mStep) {
+                case Step::START:
+                    writeType(wr, "info", "gauge");
+                    wr->write(PROM_PREFIX "info{version=\"");
+                    wr->write(mInfo.version);
+                    wr->write("\",image=\"\",devicename=\"");
+                    wr->write(mInfo.deviceName);
+                    wr->write("\"} 1\n");
+                    writeSys(wr, "freeheap", "gauge", mInfo.freeHeap);
+                    writeSys(wr, "uptime", "counter", mInfo.uptime);
+                    writeSys(wr, "wifi_rssi_db", "gauge", mInfo.rssi);
+                    break;
+
+                case Step::IV_TYPE:
+                    wr->write("# TYPE " PROM_PREFIX "inverter_");
+                    wr->write(ivMetrics[mId].topic);
+                    wr->write(' ');
+                    wr->write(ivMetrics[mId].type);
+                    wr->write('\n');
+                    break;
+
+                case Step::IV:
+                    if(nullptr == (iv = mSys->getInverterByPos(mIvId)))
+                        break;
+                    wr->write(PROM_PREFIX "inverter_");
+                    wr->write(ivMetrics[mId].topic);
+                    if(0 == mId) {
+                        wr->write(" {name=\"");
+                        wr->write(iv->config->name);
+                        wr->write("\",serial=\"");
+                        wr->writeHex(iv->config->serial.u64, 12);
+                        wr->write("\"} 1\n");
+                    } else {
+                        wr->write(" {inverter=\"");
+                        wr->write(iv->config->name);
+                        wr->write("\"} ");
+                        wr->writeUInt(mVal.u);
+                        wr->write('\n');
+                    }
+                    break;
+
+                case Step::RT:
+                    writeRealtime(wr, false);
+                    break;
+
+                case Step::ALARM_TYPE:
+                    writeType(wr, fields[FLD_LAST_ALARM_CODE], "gauge");
+                    break;
+
+                case Step::ALARM: {
+                    if(nullptr == (iv = mSys->getInverterByPos(mIvId)))
+                        break;
+                    // there is only one channel with alarm data
+                    record_t<> *rec = iv->getRecordStruct(AlarmData);
+                    if(0 == rec->length)
+                        break;
+                    wr->write(PROM_PREFIX);
+                    wr->write(iv->getFieldName(0, rec));
+                    wr->write(promUnits[rec->assign[0].unitId].suffix);
+                    wr->write("{inverter=\"");
+                    wr->write(iv->config->name);
+                    wr->write("\"} ");
+                    wr->writeFloat(mVal.f);
+                    wr->write('\n');
+                    break;
+                }
+
+                #if defined(ENABLE_PROFILER)
+                case Step::PERF_SECTION: { // histogram of one section
+                    if(0 == mId)
+                        writeType(wr, "perf_section_seconds", "histogram");
+                    const ah::perfHist_t *stat = &mPerf;
+                    const char *name = ah::perfSectionNames[mId];
+                    uint32_t cnt = 0;
+                    for(uint8_t i = 0; i < PERF_HIST_BUCKETS; i++) {
+                        cnt += stat->hist[i];
+                        writePerf(wr, "perf_section_seconds_bucket", "section", name);
+                        wr->write(",le=\"");
+                        if(i < (PERF_HIST_BUCKETS - 1))
+                            wr->writeFixed(ah::perfBounds[i], 6);
+                        else
+                            wr->write("+Inf");
+                        wr->write("\"} ");
+                        wr->writeUInt(cnt);
+                        wr->write('\n');
+                    }
+                    writePerf(wr, "perf_section_seconds_sum", "section", name);
+                    wr->write("} ");
+                    wr->writeFixed(stat->sum, 6);
+                    wr->write('\n');
+                    writePerf(wr, "perf_section_seconds_count", "section", name);
+                    wr->write("} ");
+                    wr->writeUInt(stat->cnt);
+                    wr->write('\n');
+                    break;
+                }
+
+                case Step::PERF_TICKER: {
+                    if(mId >= ah::gPerf.getTickerCnt())
+                        break;
+                    if(0 == mId)
+                        writeType(wr, "perf_ticker_seconds", "summary");
+                    const char *name;
+                    ah::gPerf.getTicker(mId, &name);
+                    const ah::perfStat_t *stat = &mPerf;
+                    writePerf(wr, "perf_ticker_seconds_sum", "ticker", name);
+                    wr->write("} ");
+                    wr->writeFixed(stat->sum, 6);
+                    wr->write('\n');
+                    writePerf(wr, "perf_ticker_seconds_count", "ticker", name);
+                    wr->write("} ");
+                    wr->writeUInt(stat->cnt);
+                    wr->write('\n');
+                    break;
+                }
+
+                case Step::PERF_MAX: {
+                    if(0 == mId)
+                        writeType(wr, "perf_max_seconds", "gauge");
+                    if(mId < static_cast<uint8_t>(ah::PerfSection::CNT))
+                        writePerf(wr, "perf_max_seconds", "section", ah::perfSectionNames[mId]);
+                    else {
+                        const char *name;
+                        ah::gPerf.getTicker(mId - static_cast<uint8_t>(ah::PerfSection::CNT), &name);
+                        writePerf(wr, "perf_max_seconds", "ticker", name);
+                    }
+                    wr->write("} ");
+                    wr->writeFixed(mPerf.max, 6);
+                    wr->write('\n');
+                    break;
+                }
+                #endif /*ENABLE_PROFILER*/
+
+                default:
+                    break;
+            }
+        }
+
+        // copies the values of the current item which may change until it's
+        // completely sent
+        void takeValues(void) {
+            Inverter<> *iv = mSys->getInverterByPos(mIvId);
+            switch(mStep) {
+                case Step::IV:
+                    if(nullptr != iv)
+                        mVal.u = ivValue(mId, iv);
+                    break;
+
+                case Step::RT: {
+                    if(nullptr == iv)
+                        break;
+                    record_t<> *rec = iv->getRecordStruct(RealTimeRunData_Debug);
+                    if(mPos < rec->length)
+                        mVal.f = iv->getValue(mPos, rec);
+                    break;
+                }
+
+                case Step::ALARM: {
+                    if(nullptr == iv)
+                        break;
+                    record_t<> *rec = iv->getRecordStruct(AlarmData);
+                    if(0 != rec->length)
+                        mVal.f = iv->getValue(0, rec);
+                    break;
+                }
+
+                #if defined(ENABLE_PROFILER)
+                case Step::PERF_SECTION:
+                    mPerf = *ah::gPerf.getSection(mId);
+                    break;
+
+                case Step::PERF_TICKER:
+                    if(mId < ah::gPerf.getTickerCnt()) {
+                        const char *name;
+                        static_cast<ah::perfStat_t&>(mPerf) = *ah::gPerf.getTicker(mId, &name);
+                    }
+                    break;
+
+                case Step::PERF_MAX:
+                    if(mId < static_cast<uint8_t>(ah::PerfSection::CNT))
+                        mPerf.max = ah::gPerf.getSection(mId)->max;
+                    else {
+                        const char *name;
+                        mPerf.max = ah::gPerf.getTicker(mId - static_cast<uint8_t>(ah::PerfSection::CNT), &name)->max;
+                    }
+                    break;
+                #endif /*ENABLE_PROFILER*/
+
+                default:
+                    break;
+            }
+        }
+
+        // moves to the next item
+        void next(void) {
+            uint8_t numIv = mSys->getNumInverters();
+            switch(mStep) {
+                case Step::START:
+                    mId   = 0;
+                    mStep = Step::IV_TYPE;
+                    break;
+
+                case Step::IV_TYPE:
+                    mIvId = 0;
+                    mStep = (0 == numIv) ? nextIvMetric() : Step::IV;
+                    break;
+
+                case Step::IV:
+                    if(++mIvId >= numIv)
+                        mStep = nextIvMetric();
+                    break;
+
+                case Step::RT:
+                    writeRealtime(nullptr, true);
+                    if(++mPos >= rtLength()) {
+                        mPos = 0;
+                        if(++mIvId >= numIv) {
+                            mIvId          = 0;
+                            mDeclared      = false;
+                            mTotalDeclared = false;
+                            if(++mId >= FLD_LAST_ALARM_CODE)
+                                mStep = Step::ALARM_TYPE;
+                        }
+                    }
+                    break;
+
+                case Step::ALARM_TYPE:
+                    mIvId = 0;
+                    mStep = (0 == numIv) ? afterAlarm() : Step::ALARM;
+                    break;
+
+                case Step::ALARM:
+                    if(++mIvId >= numIv)
+                        mStep = afterAlarm();
+                    break;
+
+                #if defined(ENABLE_PROFILER)
+                case Step::PERF_SECTION:
+                    if(++mId >= static_cast<uint8_t>(ah::PerfSection::CNT)) {
+                        mId   = 0;
+                        mStep = Step::PERF_TICKER;
+                    }
+                    break;
+
+                case Step::PERF_TICKER:
+                    if(++mId >= ah::gPerf.getTickerCnt()) {
+                        mId   = 0;
+                        mStep = Step::PERF_MAX;
+                    }
+                    break;
+
+                case Step::PERF_MAX:
+                    if(++mId >= (static_cast<uint8_t>(ah::PerfSection::CNT) + ah::gPerf.getTickerCnt()))
+                        mStep = Step::END;
+                    break;
+                #endif /*ENABLE_PROFILER*/
+
+                default:
+                    mStep = Step::END;
+                    break;
+            }
+        }
+
+        Step nextIvMetric(void) {
+            if(++mId < IV_METRIC_CNT)
+                return Step::IV_TYPE;
+            mId   = FLD_UDC;
+            mIvId = 0;
+            mPos  = 0;
+            mDeclared      = false;
+            mTotalDeclared = false;
+            return Step::RT;
+        }
+
+        Step afterAlarm(void) {
+            #if defined(ENABLE_PROFILER)
+            mId = 0;
+            return Step::PERF_SECTION;
+            #else
+            return Step::END;
+            #endif
+        }
+
+        // field 'mId' at position 'mPos' of the real time record of inverter
+        // 'mIvId', the channel values are declared before the first one, the
+        // sum (channel 0) is called _total if there are channel values.
+        // 'apply' only updates the declarations, nothing is written
+        void writeRealtime(ah::ChunkWriter *wr, bool apply) {
+            Inverter<> *iv = mSys->getInverterByPos(mIvId);
+            if(nullptr == iv)
+                return;
+            record_t<> *rec = iv->getRecordStruct(RealTimeRunData_Debug);
+            if((mPos >= rec->length) || (mId != rec->assign[mPos].fieldId))
+                return;
+            uint8_t ch = rec->assign[mPos].ch;
+            if((0 != ch) && (0 == iv->config->chMaxPwr[ch-1]))
+                return;
+
+            if(apply) {
+                if(0 != ch)
+                    mDeclared = true;
+                else
+                    mTotalDeclared = true;
+                return;
+            }
+
+            const promUnit_t *unit = &promUnits[rec->assign[mPos].unitId];
+            const char *total = ((0 == ch) && mDeclared) ? "_total" : "";
+            if(((0 != ch) && !mDeclared) || ((0 == ch) && !mTotalDeclared)) {
+                wr->write("# TYPE " PROM_PREFIX);
+                wr->write(fields[mId]);
+                wr->write(unit->suffix);
+                wr->write(total);
+                wr->write(' ');
+                wr->write(unit->type);
+                wr->write('\n');
+            }
+
+            wr->write(PROM_PREFIX);
+            wr->write(fields[mId]);
+            wr->write(unit->suffix);
+            wr->write(total);
+            wr->write("{inverter=\"");
+            wr->write(iv->config->name);
+            if(0 != ch) {
+                // fallback channel name ch1, ch2, ...
+                wr->write("\",channel=\"");
+                if('\0' != iv->config->chName[ch-1][0])
+                    wr->write(iv->config->chName[ch-1]);
+                else {
+                    wr->write("ch");
+                    wr->writeUInt(ch);
+                }
+            }
+            wr->write("\"} ");
+            wr->writeFloat(mVal.f);
+            wr->write('\n');
+        }
+
+        uint8_t rtLength(void) {
+            Inverter<> *iv = mSys->getInverterByPos(mIvId);
+            return (nullptr == iv) ? 0 : iv->getRecordStruct(RealTimeRunData_Debug)->length;
+        }
+
+        void writeType(ah::ChunkWriter *wr, const char *name, const char *type) {
+            wr->write("# TYPE " PROM_PREFIX);
+            wr->write(name);
+            wr->write(' ');
+            wr->write(type);
+            wr->write('\n');
+        }
+
+        void writeSys(ah::ChunkWriter *wr, const char *name, const char *type, int32_t val) {
+            writeType(wr, name, type);
+            wr->write(PROM_PREFIX);
+            wr->write(name);
+            wr->write("{devicename=\"");
+            wr->write(mInfo.deviceName);
+            wr->write("\"} ");
+            wr->writeInt(val);
+            wr->write('\n');
+        }
+
+        // metric name and first label, the label set is left open
+        void writePerf(ah::ChunkWriter *wr, const char *name, const char *label, const char *val) {
+            wr->write(PROM_PREFIX);
+            wr->write(name);
+            wr->write('{');
+            wr->write(label);
+            wr->write("=\"");
+            wr->write(val);
+            wr->write('"');
+        }
+
+    private:
+        HMSYSTEM *mSys = nullptr;
+        promInfo_t mInfo;
+        Step mStep = Step::END;
+        size_t mSent = 0;       // bytes of the current item sent in the previous chunk(s)
+        uint8_t mId = 0;        // metric, field or perf entry
+        uint8_t mIvId = 0;
+        uint8_t mPos = 0;       // position in the real time record
+        bool mDeclared = false, mTotalDeclared = false;
+        union {
+            uint64_t u;
+            float f;
+        } mVal = {0};           // value of the current item, see takeValues()
+        #if defined(ENABLE_PROFILER)
+        ah::perfHist_t mPerf;
+        #endif
+};
+
+#endif /*__PROMETHEUS_H__*/
@@ -6,6 +6,7 @@
 #ifndef __WEB_API_H__
 #define __WEB_API_H__
 
+#include <memory>
 #include "../utils/dbg.h"
 #include "../appInterface.h"
 #include "../hm/hmSystem.h"
@@ -13,6 +14,7 @@
 #include "lang.h"
 #include "AsyncJson.h"
 #include "ESPAsyncWebServer.h"
+#include "ApiStream.h"
 
 #include "plugins/history.h"
 
@@ -53,6 +55,9 @@ class RestApi {
             #if defined(ESP32)
             mSrv->on("/coredump", HTTP_GET,  std::bind(&RestApi::getCoreDump, this, std::placeholders::_1));
             #endif
+            #if defined(ENABLE_PACKET_TRACE)
+            mSrv->on("/trace", HTTP_GET,  std::bind(&RestApi::getTrace, this, std::placeholders::_1));
+            #endif
         }
 
         uint32_t getTimezoneOffset(void) {
@@ -84,6 +89,10 @@ class RestApi {
                 mHeapFrag = 0;
             #endif
 
+            String path = request->url().substring(5);
+            if(sendStream(request, path))
+                return;
+
             #if defined(ESP32)
             AsyncJsonResponse* response = new AsyncJsonResponse(false, 8000);
             #else
@@ -91,7 +100,7 @@ class RestApi {
             #endif
             JsonObject root = response->getRoot();
 
-            String path = request->url().substring(5);
+            mApp->lockComm();
             if(path == "html/system")         getHtmlSystem(request, root);
             else if(path == "html/logout")    getHtmlLogout(request, root);
             else if(path == "html/reboot")    getHtmlReboot(request, root);
@@ -103,20 +112,16 @@ class RestApi {
             else if(path == "system")         getSysInfo(request, root);
             else if(path == "generic")        getGeneric(request, root);
             else if(path == "reboot")         getReboot(request, root);
-            else if(path == "inverter/list")  getInverterList(root);
             else if(path == "index")          getIndex(request, root);
             else if(path == "setup")          getSetup(request, root);
             else if(path == "setup/networks") getNetworks(root);
             else if(path == "setup/getip")    getIp(root);
             else if(path == "live")           getLive(request,root);
-            #if defined(ENABLE_HISTORY)
-            else if (path == "powerHistory")  getPowerHistory(request, root, HistoryStorageType::POWER);
-            else if (path == "powerHistoryDay")  getPowerHistory(request, root, HistoryStorageType::POWER_DAY);
-            #endif /*ENABLE_HISTORY*/
+            #if defined(ENABLE_PROFILER)
+            else if(path == "perf")           getPerf(root);
+            #endif
             else {
-                if(path.substring(0, 12) == "inverter/id/")
-                    getInverter(root, request->url().substring(17).toInt());
-                else if(path.substring(0, 15) == "inverter/alarm/")
+                if(path.substring(0, 15) == "inverter/alarm/")
                     getIvAlarms(root, request->url().substring(20).toInt());
                 else if(path.substring(0, 17) == "inverter/version/")
                     getIvVersion(root, request->url().substring(22).toInt());
@@ -133,6 +138,7 @@ class RestApi {
                 else
                     getNotFound(root, F("http://") + request->host() + F("/api/"));
             }
+            mApp->unlockComm();
 
             //DPRINTLN(DBG_INFO, "API mem usage: " + String(root.memoryUsage()));
             response->addHeader("Access-Control-Allow-Origin", "*");
@@ -141,6 +147,39 @@ class RestApi {
             request->send(response);
         }
 
+        // the large responses are written in chunks with constant memory
+        // instead of a JSON document, see ApiStream
+        bool sendStream(AsyncWebServerRequest *request, const String &path) {
+            std::shared_ptr<ApiStream> stream;
+            if(path == "inverter/list")
+                stream = std::make_shared<InverterListStream<HMSYSTEM>>(mSys, &mConfig->inst);
+            else if(path.substring(0, 12) == "inverter/id/")
+                stream = std::make_shared<InverterStream<HMSYSTEM>>(mSys, request->url().substring(17).toInt());
+            else if(path == "live/cbor")
+                stream = std::make_shared<RecordCborStream<HMSYSTEM>>(mSys, mApp->getTimestamp());
+            #if defined(ENABLE_HISTORY)
+            else if(path == "powerHistory")
+                stream = std::make_shared<PowerHistoryStream>(this, isMenuProtected(request), HistoryStorageType::POWER);
+            else if(path == "powerHistoryDay")
+                stream = std::make_shared<PowerHistoryStream>(this, isMenuProtected(request), HistoryStorageType::POWER_DAY);
+            #endif /*ENABLE_HISTORY*/
+            else
+                return false;
+
+            IApp *app = mApp;
+            AsyncWebServerResponse *response = request->beginChunkedResponse(stream->getContentType(),
+                                                                             [stream, app](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                app->lockComm();
+                size_t len = stream->fill(buffer, maxLen);
+                app->unlockComm();
+                return len;
+            });
+            response->addHeader("Access-Control-Allow-Origin", "*");
+            response->addHeader("Access-Control-Allow-Headers", "content-type");
+            request->send(response);
+            return true;
+        }
+
         void onApiPost(AsyncWebServerRequest *request) {
             DPRINTLN(DBG_VERBOSE, "onApiPost");
             #if defined(ETHERNET)
@@ -306,10 +345,14 @@ class RestApi {
             ep[F("setup/getip")]      = url + F("setup/getip");
             ep[F("system")]           = url + F("system");
             ep[F("live")]             = url + F("live");
+            ep[F("live/cbor")]        = url + F("live/cbor");
             #if defined(ENABLE_HISTORY)
             ep[F("powerHistory")]     = url + F("powerHistory");
             ep[F("powerHistoryDay")]  = url + F("powerHistoryDay");
             #endif
+            #if defined(ENABLE_PROFILER)
+            ep[F("perf")]             = url + F("perf");
+            #endif
         }
 
 
@@ -388,29 +431,113 @@ class RestApi {
         }
         #endif
 
-        void getGeneric(AsyncWebServerRequest *request, JsonObject obj) {
-            mApp->resetLockTimeout();
-            obj[F("wifi_rssi")]   = (WiFi.status() != WL_CONNECTED) ? 0 : WiFi.RSSI();
-            obj[F("ts_uptime")]   = mApp->getUptime();
-            obj[F("ts_now")]      = mApp->getTimestamp();
-            obj[F("version")]     = String(mApp->getVersion());
-            obj[F("modules")]     = String(mApp->getVersionModules());
-            obj[F("build")]       = String(AUTO_GIT_HASH);
-            obj[F("env")]         = String(ENV_NAME);
-            obj[F("host")]        = mConfig->sys.deviceName;
-            obj[F("menu_prot")]   = mApp->isProtected(request->client()->remoteIP().toString().c_str(), "", true);
-            obj[F("menu_mask")]   = (uint16_t)(mConfig->sys.protectionMask );
-            obj[F("menu_protEn")] = (bool) (mConfig->sys.adminPwd[0] != '\0');
-            obj[F("cst_lnk")]     = String(mConfig->plugin.customLink);
-            obj[F("cst_lnk_txt")] = String(mConfig->plugin.customLinkText);
-            obj[F("region")]      = mConfig->sys.region;
-            obj[F("timezone")]    = mConfig->sys.timezone;
+        #if defined(ENABLE_PACKET_TRACE)
+        // binary RF trace, see hm/PacketTrace.h; '/trace?clear' empties the ring afterwards
+        void getTrace(AsyncWebServerRequest *request) {
+            PacketTrace *trace = mRadioNrf->getPacketTrace();
+            if(nullptr == trace) {
+                AsyncWebServerResponse *response = request->beginResponse(200, F("application/json; charset=utf-8"), "{}");
+                request->send(response);
+                return;
+            }
 
-        #if defined(ESP32)
-            obj[F("esp_type")]    = F("ESP32");
-        #else
-            obj[F("esp_type")]    = F("ESP8266");
+            uint64_t serial[MAX_NUM_INVERTERS];
+            uint8_t numIv = 0;
+            for(uint8_t i = 0; i < MAX_NUM_INVERTERS; i++) {
+                Inverter<> *iv = mSys->getInverterByPos(i);
+                if(nullptr != iv)
+                    serial[numIv++] = iv->config->serial.u64;
+            }
+
+            // snapshot, the ring keeps on recording while the response is sent
+            size_t size = trace->getDumpSize(numIv);
+            std::shared_ptr<uint8_t> buf(new uint8_t[size], std::default_delete<uint8_t[]>());
+            trace->dump(buf.get(), serial, numIv);
+            if(request->hasParam("clear"))
+                trace->clear();
+
+            AsyncWebServerResponse *response = request->beginResponse("application/octet-stream", size, [size, buf](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                if((index + maxLen) > size)
+                    maxLen = size - index;
+                memcpy(buffer, buf.get() + index, maxLen);
+                return maxLen;
+            });
+
+            String filename = ah::getDateTimeStrFile(gTimezone.toLocal(mApp->getTimestamp()));
+            filename += "_v" + String(mApp->getVersion());
+
+            response->addHeader("Content-Description", "File Transfer");
+            response->addHeader("Content-Disposition", "attachment; filename=" + filename + "_trace.bin");
+            request->send(response);
+        }
         #endif
+
+        bool isMenuProtected(AsyncWebServerRequest *request) {
+            return mApp->isProtected(request->client()->remoteIP().toString().c_str(), "", true);
+        }
+
+        // fields of "generic" in three parts, 'out' is a JsonWriter or a
+        // JsonObjectWriter, the streamed and the JsonObject output share them
+        template<class T>
+        void addGeneric(T *out, bool menuProt, uint8_t part) {
+            switch(part) {
+                case 0:
+                    mApp->resetLockTimeout();
+                    out->add("wifi_rssi",   (int32_t)((WiFi.status() != WL_CONNECTED) ? 0 : WiFi.RSSI()));
+                    out->add("ts_uptime",   mApp->getUptime());
+                    out->add("ts_now",      mApp->getTimestamp());
+                    out->add("version",     mApp->getVersion());
+                    out->add("modules",     mApp->getVersionModules());
+                    out->add("build",       AUTO_GIT_HASH);
+                    out->add("env",         ENV_NAME);
+                    out->add("host",        mConfig->sys.deviceName);
+                    break;
+                case 1:
+                    out->add("menu_prot",   menuProt);
+                    out->add("menu_mask",   (uint16_t)(mConfig->sys.protectionMask));
+                    out->add("menu_protEn", (bool)(mConfig->sys.adminPwd[0] != '\0'));
+                    out->add("cst_lnk",     mConfig->plugin.customLink);
+                    out->add("cst_lnk_txt", mConfig->plugin.customLinkText);
+                    break;
+                default:
+                    out->add("region",      mConfig->sys.region);
+                    out->add("timezone",    mConfig->sys.timezone);
+                    #if defined(ESP32)
+                    out->add("esp_type",    "ESP32");
+                    #else
+                    out->add("esp_type",    "ESP8266");
+                    #endif
+                    break;
+            }
+        }
+
+        // JsonWriter::add() on a JsonObject, strings are copied
+        class JsonObjectWriter {
+            public:
+                explicit JsonObjectWriter(JsonObject obj) : mObj(obj) {}
+
+                void add(const char *key, const char *val) {
+                    mObj[key] = String(val);
+                }
+
+                template<class V>
+                void add(const char *key, V val) {
+                    mObj[key] = val;
+                }
+
+            private:
+                JsonObject mObj;
+        };
+
+        void writeGeneric(ah::JsonWriter *json, bool menuProt, uint8_t part) {
+            addGeneric(json, menuProt, part);
+        }
+
+        void getGeneric(AsyncWebServerRequest *request, JsonObject obj) {
+            JsonObjectWriter wr(obj);
+            bool menuProt = isMenuProtected(request);
+            for(uint8_t part = 0; part < 3; part++)
+                addGeneric(&wr, menuProt, part);
         }
 
         void getSysInfo(AsyncWebServerRequest *request, JsonObject obj) {
@@ -427,6 +554,7 @@ class RestApi {
             getMqttInfo(obj.createNestedObject(F("mqtt")));
             getNetworkInfo(obj.createNestedObject(F("network")));
             getMemoryInfo(obj.createNestedObject(F("memory")));
+            mApp->getCommQueueInfo(obj.createNestedObject(F("queue")));
             #if defined(ESP32)
             getRadioCmtInfo(obj.createNestedObject(F("radioCmt")));
             #endif
@@ -548,102 +676,14 @@ class RestApi {
                 return;
             }
             obj["ack"] = (bool)iv->powerLimitAck;
-        }
-
-        void getInverterList(JsonObject obj) {
-            JsonArray invArr = obj.createNestedArray(F("inverter"));
-
-            Inverter<> *iv;
-            for(uint8_t i = 0; i < MAX_NUM_INVERTERS; i ++) {
-                iv = mSys->getInverterByPos(i);
-                if(NULL == iv)
-                    continue;
-
-                JsonObject obj2 = invArr.createNestedObject();
-                obj2[F("enabled")]  = (bool)iv->config->enabled;
-                obj2[F("id")]       = i;
-                obj2[F("name")]     = String(iv->config->name);
-                obj2[F("serial")]   = String(iv->config->serial.u64, HEX);
-                obj2[F("channels")] = iv->channels;
-                obj2[F("freq")]     = iv->config->frequency;
-                obj2[F("disnightcom")] = (bool)iv->config->disNightCom;
-                if(0xff == iv->config->powerLevel) {
-                    if((IV_HMT == iv->ivGen) || (IV_HMS == iv->ivGen))
-                        obj2[F("pa")] = 30; // 20dBm
-                    else
-                        obj2[F("pa")] = 1; // low
-                } else
-                    obj2[F("pa")] = iv->config->powerLevel;
-
-                for(uint8_t j = 0; j < iv->channels; j ++) {
-                    obj2[F("ch_yield_cor")][j] = (double)iv->config->yieldCor[j];
-                    obj2[F("ch_name")][j]      = iv->config->chName[j];
-                    obj2[F("ch_max_pwr")][j]   = iv->config->chMaxPwr[j];
-                }
-            }
-            obj[F("interval")]          = String(mConfig->inst.sendInterval);
-            obj[F("max_num_inverters")] = MAX_NUM_INVERTERS;
-            obj[F("rstMid")]            = (bool)mConfig->inst.rstValsAtMidNight;
-            obj[F("rstNotAvail")]       = (bool)mConfig->inst.rstValsNotAvail;
-            obj[F("rstComStop")]        = (bool)mConfig->inst.rstValsCommStop;
-            obj[F("rstComStart")]       = (bool)mConfig->inst.rstValsCommStart;
-            obj[F("strtWthtTm")]        = (bool)mConfig->inst.startWithoutTime;
-            obj[F("rdGrid")]            = (bool)mConfig->inst.readGrid;
-            obj[F("rstMaxMid")]         = (bool)mConfig->inst.rstIncludeMaxVals;
-        }
-
-        void getInverter(JsonObject obj, uint8_t id) {
-            Inverter<> *iv = mSys->getInverterByPos(id);
-            if(NULL == iv) {
-                obj[F("error")] = F(INV_NOT_FOUND);
-                return;
-            }
-
-            record_t<> *rec = iv->getRecordStruct(RealTimeRunData_Debug);
-            obj[F("id")]               = id;
-            obj[F("enabled")]          = (bool)iv->config->enabled;
-            obj[F("name")]             = String(iv->config->name);
-            obj[F("serial")]           = String(iv->config->serial.u64, HEX);
-            obj[F("version")]          = String(iv->getFwVersion());
-            obj[F("power_limit_read")] = ah::round1(iv->getChannelFieldValue(CH0, FLD_ACT_ACTIVE_PWR_LIMIT, iv->getRecordStruct(SystemConfigPara)));
-            obj[F("power_limit_ack")]  = iv->powerLimitAck;
-            obj[F("max_pwr")]          = iv->getMaxPower();
-            obj[F("ts_last_success")]  = rec->ts;
-            obj[F("generation")]       = iv->ivGen;
-            obj[F("status")]           = (uint8_t)iv->getStatus();
-            obj[F("alarm_cnt")]        = iv->alarmCnt;
-            obj[F("rssi")]             = iv->rssi;
-            obj[F("ts_max_ac_pwr")]    = iv->tsMaxAcPower;
-            obj[F("ts_max_temp")]      = iv->tsMaxTemperature;
-
-            JsonArray ch = obj.createNestedArray("ch");
-
-            // AC
-            uint8_t pos;
-            obj[F("ch_name")][0] = "AC";
-            JsonArray ch0 = ch.createNestedArray();
-            if(IV_HMT == iv->ivGen) {
-                for (uint8_t fld = 0; fld < sizeof(acListHmt); fld++) {
-                    pos = (iv->getPosByChFld(CH0, acListHmt[fld], rec));
-                    ch0[fld] = (0xff != pos) ? ah::round3(iv->getValue(pos, rec)) : 0.0;
-                }
-            } else  {
-                for (uint8_t fld = 0; fld < sizeof(acList); fld++) {
-                    pos = (iv->getPosByChFld(CH0, acList[fld], rec));
-                    ch0[fld] = (0xff != pos) ? ah::round3(iv->getValue(pos, rec)) : 0.0;
-                }
-            }
-
-            // DC
-            for(uint8_t j = 0; j < iv->channels; j ++) {
-                obj[F("ch_name")][j+1] = iv->config->chName[j];
-                obj[F("ch_max_pwr")][j+1] = iv->config->chMaxPwr[j];
-                JsonArray cur = ch.createNestedArray();
-                for (uint8_t fld = 0; fld < sizeof(dcList); fld++) {
-                    pos = (iv->getPosByChFld((j+1), dcList[fld], rec));
-                    cur[fld] = (0xff != pos) ? ah::round3(iv->getValue(pos, rec)) : 0.0;
-                }
-            }
+            const PowerLimitMailbox::stat_t *st = iv->limitBox.getStat();
+            obj[F("req")]        = st->reqCnt;
+            obj[F("coalesced")]  = st->coalescedCnt;
+            obj[F("sent")]       = st->sentCnt;
+            obj[F("ack_cnt")]    = st->ackCnt;
+            obj[F("ack_ms")]     = st->lastMs;
+            obj[F("ack_max_ms")] = st->maxMs;
+            obj[F("ack_avg_ms")] = (0 == st->ackCnt) ? 0 : (st->sumMs / st->ackCnt);
         }
 
         void getGridProfile(JsonObject obj, uint8_t id) {
@@ -824,8 +864,15 @@ class RestApi {
             obj[F("pwd")]        = (strlen(mConfig->mqtt.pwd) > 0) ? F("{PWD}") : String("");
             obj[F("topic")]      = String(mConfig->mqtt.topic);
             obj[F("json")]       = (bool) mConfig->mqtt.json;
+            obj[F("batch")]      = (bool) mConfig->mqtt.batch;
             obj[F("interval")]   = String(mConfig->mqtt.interval);
             obj[F("retain")]     = (bool)mConfig->mqtt.enableRetain;
+            obj[F("rbe")]        = (bool)mConfig->mqtt.rbe;
+            obj[F("rbeRef")]     = mConfig->mqtt.rbeRefresh;
+            for(uint8_t i = 0; i < MQTT_DB_CNT; i++) {
+                obj[F("dbAbs")][i] = mConfig->mqtt.dbAbs[i];
+                obj[F("dbRel")][i] = mConfig->mqtt.dbRel[i];
+            }
         }
 
         void getNtp(JsonObject obj) {
@@ -992,6 +1039,7 @@ class RestApi {
 
         void getRadioNrf(JsonObject obj) {
             obj[F("en")] = (bool) mConfig->nrf.enabled;
+            obj[F("ch_sel")] = mConfig->nrf.chSelect;
             if(mConfig->nrf.enabled) {
                 obj[F("isconnected")] = mRadioNrf->isChipConnected();
                 obj[F("dataRate")]    = mRadioNrf->getDataRate();
@@ -1039,6 +1087,9 @@ class RestApi {
             obj[F("connected")] = mApp->getMqttIsConnected();
             obj[F("tx_cnt")]    = mApp->getMqttTxCnt();
             obj[F("rx_cnt")]    = mApp->getMqttRxCnt();
+            obj[F("rx_drop")]   = mApp->getMqttRxDroppedCnt();
+            obj[F("rx_coal")]   = mApp->getMqttRxCoalescedCnt();
+            obj[F("rx_large")]  = mApp->getMqttRxTooLargeCnt();
             obj[F("interval")]  = mConfig->mqtt.interval;
         }
 
@@ -1136,37 +1187,72 @@ class RestApi {
             }
         }
 
-        #if defined(ENABLE_HISTORY)
-        void getPowerHistory(AsyncWebServerRequest *request, JsonObject obj, HistoryStorageType type) {
-            getGeneric(request, obj.createNestedObject(F("generic")));
-            obj[F("refresh")] = mApp->getHistoryPeriod(static_cast<uint8_t>(type));
 
-            uint16_t max = 0;
-            for (uint16_t fld = 0; fld < HISTORY_DATA_ARR_LENGTH; fld++) {
-                uint16_t value = mApp->getHistoryValue(static_cast<uint8_t>(type), fld);
-                obj[F("value")][fld] = value;
-                if (value > max)
-                    max = value;
-            }
-            obj[F("max")] = max;
 
-            if(HistoryStorageType::POWER_DAY == type) {
-                float yldDay = 0;
-                for (uint8_t i = 0; i < mSys->getNumInverters(); i++) {
-                    Inverter<> *iv = mSys->getInverterByPos(i);
-                    if (iv == NULL)
-                        continue;
-                    record_t<> *rec = iv->getRecordStruct(RealTimeRunData_Debug);
-                    yldDay += iv->getChannelFieldValue(CH0, FLD_YD, rec);
+        #if defined(ENABLE_HISTORY)
+        // /api/powerHistory and /api/powerHistoryDay, 'max' follows the values
+        class PowerHistoryStream : public JsonStream {
+            public:
+                PowerHistoryStream(RestApi *api, bool menuProt, HistoryStorageType type) : mApi(api), mMenuProt(menuProt), mType(static_cast<uint8_t>(type)) {}
+
+            protected:
+                bool writeJson(ah::JsonWriter *json) override {
+                    IApp *app = mApi->mApp;
+                    switch(mStep) {
+                        case 0:
+                            json->beginObject();
+                            json->beginObject("generic");
+                            mApi->writeGeneric(json, mMenuProt, 0);
+                            break;
+                        case 1:
+                            mApi->writeGeneric(json, mMenuProt, 1);
+                            break;
+                        case 2:
+                            mApi->writeGeneric(json, mMenuProt, 2);
+                            json->endObject();
+                            json->add("refresh", app->getHistoryPeriod(mType));
+                            json->beginArray("value");
+                            break;
+                        case 3: // 16 values per item
+                            for(uint8_t i = 0; (i < 16) && (mIdx < HISTORY_DATA_ARR_LENGTH); i++, mIdx++) {
+                                uint16_t value = app->getHistoryValue(mType, mIdx);
+                                json->add(nullptr, value);
+                                if(value > mMax)
+                                    mMax = value;
+                            }
+                            if(mIdx < HISTORY_DATA_ARR_LENGTH)
+                                return true;
+                            json->endArray();
+                            break;
+                        default:
+                            json->add("max", mMax);
+                            if(static_cast<uint8_t>(HistoryStorageType::POWER_DAY) == mType) {
+                                float yldDay = 0;
+                                for(uint8_t i = 0; i < mApi->mSys->getNumInverters(); i++) {
+                                    Inverter<> *iv = mApi->mSys->getInverterByPos(i);
+                                    if(NULL == iv)
+                                        continue;
+                                    yldDay += iv->getChannelFieldValue(CH0, FLD_YD, iv->getRecordStruct(RealTimeRunData_Debug));
+                                }
+                                json->add("yld", yldDay / 1000.0f, 3);
+                            }
+                            json->add("lastValueTs", app->getHistoryLastValueTs(mType));
+                            json->endObject();
+                            return false;
+                    }
+                    mStep++;
+                    return true;
                 }
-                obj[F("yld")] = ah::round3(yldDay / 1000.0);
-            }
 
-            obj[F("lastValueTs")] = mApp->getHistoryLastValueTs(static_cast<uint8_t>(type));
-        }
+            private:
+                RestApi *mApi;
+                bool mMenuProt;
+                uint8_t mType;
+                uint16_t mIdx = 0;
+                uint16_t mMax = 0;
+        };
         #endif /*ENABLE_HISTORY*/
 
-
         #if defined(ENABLE_HISTORY_YIELD_PER_DAY)
         void getYieldDayHistory(AsyncWebServerRequest *request, JsonObject obj) {
             obj[F("refresh")] = mApp->getHistoryPeriod((uint8_t)HistoryStorageType::YIELD);
@@ -1181,6 +1267,39 @@ class RestApi {
         }
         #endif /*ENABLE_HISTORY_YIELD_PER_DAY*/
 
+        #if defined(ENABLE_PROFILER)
+        void getPerf(JsonObject obj) {
+            obj[F("ts_uptime")] = mApp->getUptime();
+            JsonArray bounds = obj.createNestedArray(F("bounds_us"));
+            for(uint8_t i = 0; i < (PERF_HIST_BUCKETS - 1); i++)
+                bounds.add(ah::perfBounds[i]);
+
+            JsonArray sections = obj.createNestedArray(F("sections"));
+            for(uint8_t i = 0; i < static_cast<uint8_t>(ah::PerfSection::CNT); i++) {
+                const ah::perfHist_t *stat = ah::gPerf.getSection(i);
+                JsonObject obj2 = sections.createNestedObject();
+                obj2[F("name")]   = ah::perfSectionNames[i];
+                obj2[F("cnt")]    = stat->cnt;
+                obj2[F("sum_us")] = stat->sum;
+                obj2[F("max_us")] = stat->max;
+                JsonArray hist = obj2.createNestedArray(F("hist"));
+                for(uint8_t j = 0; j < PERF_HIST_BUCKETS; j++)
+                    hist.add(stat->hist[j]);
+            }
+
+            JsonArray tickers = obj.createNestedArray(F("tickers"));
+            for(uint8_t i = 0; i < ah::gPerf.getTickerCnt(); i++) {
+                const char *name;
+                const ah::perfStat_t *stat = ah::gPerf.getTicker(i, &name);
+                JsonObject obj2 = tickers.createNestedObject();
+                obj2[F("name")]   = name;
+                obj2[F("cnt")]    = stat->cnt;
+                obj2[F("sum_us")] = stat->sum;
+                obj2[F("max_us")] = stat->max;
+            }
+        }
+        #endif /*ENABLE_PROFILER*/
+
         bool setCtrl(JsonObject jsonIn, JsonObject jsonOut, const char *clientIP) {
             if(jsonIn.containsKey(F("auth"))) {
                 if(String(jsonIn[F("auth")]) == String(mConfig->sys.adminPwd)) {
@@ -1210,17 +1329,15 @@ class RestApi {
             else if(F("restart") == jsonIn[F("cmd")])
                 accepted = iv->setDevControlRequest(Restart);
             else if(0 == strncmp("limit_", jsonIn[F("cmd")].as<const char*>(), 6)) {
-                iv->powerLimit[0] = static_cast<uint16_t>(jsonIn["val"].as<float>() * 10.0);
+                uint16_t ctrl = AbsolutNonPersistent;
                 if(F("limit_persistent_relative") == jsonIn[F("cmd")])
-                    iv->powerLimit[1] = RelativPersistent;
+                    ctrl = RelativPersistent;
                 else if(F("limit_persistent_absolute") == jsonIn[F("cmd")])
-                    iv->powerLimit[1] = AbsolutPersistent;
+                    ctrl = AbsolutPersistent;
                 else if(F("limit_nonpersistent_relative") == jsonIn[F("cmd")])
-                    iv->powerLimit[1] = RelativNonPersistent;
-                else if(F("limit_nonpersistent_absolute") == jsonIn[F("cmd")])
-                    iv->powerLimit[1] = AbsolutNonPersistent;
+                    ctrl = RelativNonPersistent;
 
-                accepted = iv->setDevControlRequest(ActivePowerContr);
+                accepted = iv->setPowerLimitRequest(static_cast<uint16_t>(jsonIn["val"].as<float>() * 10.0), ctrl);
             } else if(F("dev") == jsonIn[F("cmd")]) {
                 DPRINTLN(DBG_INFO, F("dev cmd"));
                 iv->setDevCommand(jsonIn[F("val")].as<int>());
@@ -1329,13 +1446,6 @@ class RestApi {
             return false;
         }
 
-    private:
-        constexpr static uint8_t acList[] = {FLD_UAC, FLD_IAC, FLD_PAC, FLD_F, FLD_PF, FLD_T, FLD_YT,
-            FLD_YD, FLD_PDC, FLD_EFF, FLD_Q, FLD_MP, FLD_MT};
-        constexpr static uint8_t acListHmt[] = {FLD_UAC_1N, FLD_IAC_1, FLD_PAC, FLD_F, FLD_PF, FLD_T,
-            FLD_YT, FLD_YD, FLD_PDC, FLD_EFF, FLD_Q, FLD_MP, FLD_MT};
-        constexpr static uint8_t dcList[] = {FLD_UDC, FLD_IDC, FLD_PDC, FLD_YD, FLD_YT, FLD_IRR, FLD_MP};
-
     private:
         IApp *mApp = nullptr;
         HMSYSTEM *mSys = nullptr;
@@ -14,6 +14,10 @@
 #include "../hm/hmSystem.h"
 #include "../utils/helper.h"
 #include "ESPAsyncWebServer.h"
+#include "LiveDelta.h"
+#if defined(ENABLE_PROMETHEUS_EP)
+#include "Prometheus.h"
+#endif
 #include "html/h/api_js.h"
 #include "html/h/colorBright_css.h"
 #include "html/h/colorDark_css.h"
@@ -33,6 +37,7 @@
 #include "html/h/history_html.h"
 
 #define WEB_SERIAL_BUF_SIZE 2048
+#define WEB_LIVE_BUF_SIZE   1024
 
 const char* const pinArgNames[] = {
     "pinCs", "pinCe", "pinIrq", "pinSclk", "pinMosi", "pinMiso", "pinLed0",
@@ -52,6 +57,9 @@ class Web {
             mApp     = app;
             mSys     = sys;
             mConfig  = config;
+            #if defined(ENABLE_PROMETHEUS_EP)
+            mMetrics.setup(sys);
+            #endif
 
             DPRINTLN(DBG_VERBOSE, F("app::setup-on"));
             mWeb.on("/",               HTTP_GET,  std::bind(&Web::onIndex,        this, std::placeholders::_1, true));
@@ -119,6 +127,20 @@ class Web {
             }
         }
 
+        // changed live values of the inverter as "live" event, the
+        // visualization doesn't need to poll while it is connected
+        void payloadEventListener(uint8_t cmd, Inverter<> *iv) {
+            if(0 == mEvts.count())
+                return;
+
+            if(nullptr != iv) {
+                sendLive(iv);
+                return;
+            }
+            for(uint8_t i = 0; i < mSys->getNumInverters(); i++) // values were reset
+                sendLive(mSys->getInverterByPos(i));
+        }
+
         AsyncWebServer *getWebSrvPtr(void) {
             return &mWeb;
         }
@@ -304,6 +326,12 @@ class Web {
             mApp->setRebootFlag();
         }
 
+        void sendLive(Inverter<> *iv) {
+            char buf[WEB_LIVE_BUF_SIZE];
+            if(0 != mLive.write(iv, buf, WEB_LIVE_BUF_SIZE))
+                mEvts.send(buf, "live", millis());
+        }
+
         void onConnect(AsyncEventSourceClient *client) {
             DPRINTLN(DBG_VERBOSE, "onConnect");
 
@@ -517,6 +545,12 @@ class Web {
             mConfig->inst.rstValsNotAvail = (request->arg("invRstNotAvail") == "on");
             mConfig->inst.startWithoutTime = (request->arg("strtWthtTm") == "on");
             mConfig->inst.readGrid = (request->arg("rdGrid") == "on");
+            mConfig->inst.adaptiveInterval = (request->arg("adptIntvl") == "on");
+            mConfig->inst.limitFastPath = (request->arg("lmtFast") == "on");
+            if (request->arg("invIntvlMin") != "")
+                mConfig->inst.minInterval = request->arg("invIntvlMin").toInt();
+            if (request->arg("invIntvlMax") != "")
+                mConfig->inst.maxInterval = request->arg("invIntvlMax").toInt();
             mConfig->inst.rstIncludeMaxVals = (request->arg("invRstMaxMid") == "on");
 
 
@@ -558,6 +592,8 @@ class Web {
             }
 
             mConfig->nrf.enabled = (request->arg("nrfEnable") == "on");
+            if (request->arg("nrfChSel") != "")
+                mConfig->nrf.chSelect = request->arg("nrfChSel").toInt();
             mConfig->cmt.enabled = (request->arg("cmtEnable") == "on");
             #if defined(ETHERNET)
             mConfig->sys.eth.enabled = (request->arg("ethEn") == "on");
@@ -596,9 +632,16 @@ class Web {
                 request->arg("mqttPwd").toCharArray(mConfig->mqtt.pwd, MQTT_PWD_LEN);
             request->arg("mqttTopic").toCharArray(mConfig->mqtt.topic, MQTT_TOPIC_LEN);
             mConfig->mqtt.json = (request->arg("mqttJson") == "on");
+            mConfig->mqtt.batch = (request->arg("mqttBatch") == "on");
             mConfig->mqtt.port = request->arg("mqttPort").toInt();
             mConfig->mqtt.interval = request->arg("mqttInterval").toInt();
             mConfig->mqtt.enableRetain = (request->arg("retain") == "on");
+            mConfig->mqtt.rbe = (request->arg("mqttRbe") == "on");
+            mConfig->mqtt.rbeRefresh = request->arg("mqttRbeRef").toInt();
+            for(uint8_t i = 0; i < MQTT_DB_CNT; i++) {
+                mConfig->mqtt.dbAbs[i] = request->arg("mqttDbAbs" + String(i)).toFloat();
+                mConfig->mqtt.dbRel[i] = request->arg("mqttDbRel" + String(i)).toInt();
+            }
 
             // serial console
             mConfig->serial.debug = (request->arg("serDbg") == "on");
@@ -686,286 +729,35 @@ class Web {
 
 
 #ifdef ENABLE_PROMETHEUS_EP
-        // Note
-        // Prometheus exposition format is defined here: https://github.com/prometheus/docs/blob/main/content/docs/instrumenting/exposition_formats.md
-        // NOTE: Grouping for fields with channels and totals is currently not working
-        // TODO: Handle grouping and sorting for independant from channel number
-        // NOTE: Check packetsize for MAX_NUM_INVERTERS. Successfully Tested with 4 Inverters (each with 4 channels)
-        const char* metricConstPrefix = "ahoy_solar_";
-        const char* metricConstInverterFormat = " {inverter=\"%s\"} %d\n";
-        typedef enum {
-            metricsStateInverterInfo=0,           metricsStateInverterEnabled=1,        metricsStateInverterAvailable=2,
-            metricsStateInverterProducing=3,      metricsStateInverterPowerLimitRead=4, metricsStateInverterPowerLimitAck=5,
-            metricsStateInverterMaxPower=6,       metricsStateInverterRxSuccess=7,      metricsStateInverterRxFail=8,
-            metricsStateInverterRxFailAnswer=9,   metricsStateInverterFrameCnt=10,      metricsStateInverterTxCnt=11,
-            metricsStateInverterRetransmits=12,   metricsStateInverterIvRxCnt=13,       metricsStateInverterIvTxCnt=14,
-            metricsStateInverterDtuRxCnt=15,      metricsStateInverterDtuTxCnt=16,
-            metricStateRealtimeFieldId=metricsStateInverterDtuTxCnt+1, // ensure that this state follows the last per_inverter state
-            metricStateRealtimeInverterId,
-            metricsStateAlarmData,
-            metricsStateStart,
-            metricsStateEnd
-        } MetricStep_t;
-        MetricStep_t metricsStep = metricsStateInverterInfo;
-        typedef struct {
-            const char *topic;
-            const char *type;
-            const char *format;
-            const std::function<uint64_t(Inverter<> *iv)> valueFunc;
-        } InverterMetric_t;
-        InverterMetric_t inverterMetrics[17] = {
-            { "info",                 "gauge",   " {name=\"%s\",serial=\"%12llx\"} 1\n", [](Inverter<> *iv)-> uint64_t {return iv->config->serial.u64;} },
-            { "is_enabled",           "gauge",   metricConstInverterFormat, [](Inverter<> *iv)-> uint64_t {return iv->config->enabled;} },
-            { "is_available",         "gauge",   metricConstInverterFormat, [](Inverter<> *iv)-> uint64_t {return iv->isAvailable();} },
-            { "is_producing",         "gauge",   metricConstInverterFormat, [](Inverter<> *iv)-> uint64_t {return iv->isProducing();} },
-            { "power_limit_read",     "gauge",   metricConstInverterFormat, [](Inverter<> *iv)-> uint64_t {return iv->actPowerLimit;} },
-            { "power_limit_ack",      "gauge",   metricConstInverterFormat, [](Inverter<> *iv)-> uint64_t {return (iv->powerLimitAck)?1:0;} },
-            { "max_power",            "gauge",   metricConstInverterFormat, [](Inverter<> *iv)-> uint64_t {return iv->getMaxPower();} },
-            { "radio_rx_success",     "counter" ,metricConstInverterFormat, [](Inverter<> *iv)-> uint64_t {return iv->radioStatistics.rxSuccess;} },
-            { "radio_rx_fail",        "counter" ,metricConstInverterFormat, [](Inverter<> *iv)-> uint64_t {return iv->radioStatistics.rxFail;} },
-            { "radio_rx_fail_answer", "counter" ,metricConstInverterFormat, [](Inverter<> *iv)-> uint64_t {return iv->radioStatistics.rxFailNoAnswer;} },
-            { "radio_frame_cnt",      "counter" ,metricConstInverterFormat, [](Inverter<> *iv)-> uint64_t {return iv->radioStatistics.frmCnt;} },
-            { "radio_tx_cnt",         "counter" ,metricConstInverterFormat, [](Inverter<> *iv)-> uint64_t {return iv->radioStatistics.txCnt;} },
-            { "radio_retransmits",    "counter" ,metricConstInverterFormat, [](Inverter<> *iv)-> uint64_t {return iv->radioStatistics.retransmits;} },
-            { "radio_iv_loss_cnt",    "counter" ,metricConstInverterFormat, [](Inverter<> *iv)-> uint64_t {return iv->radioStatistics.ivLoss;} },
-            { "radio_iv_sent_cnt",    "counter" ,metricConstInverterFormat, [](Inverter<> *iv)-> uint64_t {return iv->radioStatistics.ivSent;} },
-            { "radio_dtu_loss_cnt",   "counter" ,metricConstInverterFormat, [](Inverter<> *iv)-> uint64_t {return iv->radioStatistics.dtuLoss;} },
-            { "radio_dtu_sent_cnt",   "counter" ,metricConstInverterFormat, [](Inverter<> *iv)-> uint64_t {return iv->radioStatistics.dtuSent;} }
-        };
-
+        // the system values are taken at the start of the scrape, the
+        // chunks are written directly into the buffer of the response
         void showMetrics(AsyncWebServerRequest *request) {
             DPRINTLN(DBG_VERBOSE, F("web::showMetrics"));
-            metricsStep = metricsStateStart;
+            promInfo_t info;
+            info.version    = mApp->getVersion();
+            info.deviceName = mConfig->sys.deviceName;
+            info.freeHeap   = ESP.getFreeHeap();
+            info.uptime     = mApp->getUptime();
+            info.rssi       = WiFi.RSSI();
+            mMetrics.start(info);
+
             AsyncWebServerResponse *response = request->beginChunkedResponse(F("text/plain"),
-                                                                             [this](uint8_t *buffer, size_t maxLen, size_t filledLength) -> size_t
-            {
-                Inverter<> *iv;
-                record_t<> *rec;
-                String promUnit, promType;
-                String metrics;
-                char type[60], topic[100], val[25];
-                size_t len = 0;
-                int alarmChannelId;
-
-                // Perform grouping on metrics according to format specification
-                // Each step must return at least one character. Otherwise the processing of AsyncWebServerResponse stops.
-                // So several "Info:" blocks are used to keep the transmission going
-                switch (metricsStep) {
-                    case metricsStateStart: // System Info  : fit to one packet
-                        snprintf(type,sizeof(type),"# TYPE %sinfo gauge\n",metricConstPrefix);
-                        snprintf(topic,sizeof(topic),"%sinfo{version=\"%s\",image=\"\",devicename=\"%s\"} 1\n",metricConstPrefix,
-                            mApp->getVersion(), mConfig->sys.deviceName);
-                        metrics = String(type) + String(topic);
-
-                        snprintf(type,sizeof(type),"# TYPE %sfreeheap gauge\n",metricConstPrefix);
-                        snprintf(topic,sizeof(topic),"%sfreeheap{devicename=\"%s\"} %u\n",metricConstPrefix,mConfig->sys.deviceName,ESP.getFreeHeap());
-                        metrics += String(type) + String(topic);
-
-                        snprintf(type,sizeof(type),"# TYPE %suptime counter\n",metricConstPrefix);
-                        snprintf(topic,sizeof(topic),"%suptime{devicename=\"%s\"} %u\n",metricConstPrefix, mConfig->sys.deviceName, mApp->getUptime());
-                        metrics += String(type) + String(topic);
-
-                        snprintf(type,sizeof(type),"# TYPE %swifi_rssi_db gauge\n",metricConstPrefix);
-                        snprintf(topic,sizeof(topic),"%swifi_rssi_db{devicename=\"%s\"} %d\n",metricConstPrefix, mConfig->sys.deviceName, WiFi.RSSI());
-                        metrics += String(type) + String(topic);
-
-                        len = snprintf(reinterpret_cast<char*>(buffer), maxLen,"%s",metrics.c_str());
-                        // Next is Inverter information
-                        metricsStep = metricsStateInverterInfo;
-                        break;
-
-                    // Information about all inverters configured : each metric for all inverters must fit to one network packet
-                    case metricsStateInverterInfo:
-                    case metricsStateInverterEnabled:
-                    case metricsStateInverterAvailable:
-                    case metricsStateInverterProducing:
-                    case metricsStateInverterPowerLimitRead:
-                    case metricsStateInverterPowerLimitAck:
-                    case metricsStateInverterMaxPower:
-                    case metricsStateInverterRxSuccess:
-                    case metricsStateInverterRxFail:
-                    case metricsStateInverterRxFailAnswer:
-                    case metricsStateInverterFrameCnt:
-                    case metricsStateInverterTxCnt:
-                    case metricsStateInverterRetransmits:
-                    case metricsStateInverterIvRxCnt:
-                    case metricsStateInverterIvTxCnt:
-                    case metricsStateInverterDtuRxCnt:
-                    case metricsStateInverterDtuTxCnt:
-                        metrics = "# TYPE ahoy_solar_inverter_" + String(inverterMetrics[metricsStep].topic) + " " + String(inverterMetrics[metricsStep].type) + "\n";
-                        metrics += inverterMetric(topic, sizeof(topic),
-                                        (String("ahoy_solar_inverter_") + inverterMetrics[metricsStep].topic +
-                                            inverterMetrics[metricsStep].format).c_str(),
-                                            inverterMetrics[metricsStep].valueFunc);
-                        len = snprintf(reinterpret_cast<char*>(buffer), maxLen, "%s", metrics.c_str());
-                        // ugly hack to increment the enum
-                        metricsStep = static_cast<MetricStep_t>( static_cast<int>(metricsStep) + 1);
-                        // Prepare  Realtime Field loop, which may be startet next
-                        metricsFieldId = FLD_UDC;
-                        break;
-
-
-                    case metricStateRealtimeFieldId: // Iterate over all defined fields
-                        if (metricsFieldId < FLD_LAST_ALARM_CODE) {
-                            metrics = "# Info: processing realtime field #"+String(metricsFieldId)+"\n";
-                            metricDeclared = false;
-                            metricTotalDeclard = false;
-
-                            metricsInverterId = 0;
-                            metricsStep = metricStateRealtimeInverterId;
-                        } else {
-                            metrics = "# Info: all realtime fields processed\n";
-                            metricsStep = metricsStateAlarmData;
-                        }
-                        len = snprintf(reinterpret_cast<char *>(buffer), maxLen, "%s", metrics.c_str());
-                        break;
-
-                  case metricStateRealtimeInverterId: // Iterate over all inverters for this field
-                        metrics = "";
-                        if (metricsInverterId < mSys->getNumInverters()) {
-                            // process all channels of this inverter
-                            iv = mSys->getInverterByPos(metricsInverterId);
-                            if (NULL != iv) {
-                                rec = iv->getRecordStruct(RealTimeRunData_Debug);
-                                for (int metricsChannelId=0; metricsChannelId < rec->length;metricsChannelId++) {
-                                    uint8_t channel = rec->assign[metricsChannelId].ch;
-
-                                    // Try inverter channel (channel 0) or any channel with maxPwr > 0
-                                    if (0 == channel || 0 != iv->config->chMaxPwr[channel-1]) {
-                                        if (metricsFieldId == iv->getByteAssign(metricsChannelId, rec)->fieldId) {
-                                            // This is the correct field to report
-                                            std::tie(promUnit, promType) = convertToPromUnits(iv->getUnit(metricsChannelId, rec));
-                                            // Declare metric only once
-                                            if (channel != 0 && !metricDeclared) {
-                                                snprintf(type, sizeof(type), "# TYPE %s%s%s %s\n",metricConstPrefix, iv->getFieldName(metricsChannelId, rec), promUnit.c_str(), promType.c_str());
-                                                metrics += type;
-                                                metricDeclared = true;
-                                            }
-                                            // report value
-                                            if (0 == channel) {
-                                                // Report a _total value if also channel values were reported. Otherwise report without _total
-                                                char total[7] = {0};
-                                                if (metricDeclared) {
-                                                    // A declaration and value for channels have been delivered. So declare and deliver a _total metric
-                                                    snprintf(total, sizeof(total), "_total");
-                                                }
-                                                if (!metricTotalDeclard) {
-                                                    snprintf(type, sizeof(type), "# TYPE %s%s%s%s %s\n",metricConstPrefix, iv->getFieldName(metricsChannelId, rec), promUnit.c_str(), total, promType.c_str());
-                                                    metrics += type;
-                                                    metricTotalDeclard = true;
-                                                }
-                                                snprintf(topic, sizeof(topic), "%s%s%s%s{inverter=\"%s\"}",metricConstPrefix, iv->getFieldName(metricsChannelId, rec), promUnit.c_str(), total,iv->config->name);
-                                            } else {
-                                                // Report (non zero) channel value
-                                                // Use a fallback channel name (ch0, ch1, ...)if non is given by user
-                                                char chName[MAX_NAME_LENGTH];
-                                                if (iv->config->chName[channel-1][0] != 0) {
-                                                    strncpy(chName, iv->config->chName[channel-1], sizeof(chName));
-                                                } else {
-                                                    snprintf(chName,sizeof(chName),"ch%1d",channel);
-                                                }
-                                                snprintf(topic, sizeof(topic), "%s%s%s{inverter=\"%s\",channel=\"%s\"}",metricConstPrefix, iv->getFieldName(metricsChannelId, rec), promUnit.c_str(), iv->config->name,chName);
-                                            }
-                                            snprintf(val, sizeof(val), " %.3f\n", iv->getValue(metricsChannelId, rec));
-                                            metrics += topic;
-                                            metrics += val;
-                                        }
-                                    }
-                                }
-                                if (metrics.length() < 1) {
-                                    metrics = "# Info: Field #"+String(metricsFieldId)+" (" + fields[metricsFieldId] +
-                                                ") not available for inverter #"+String(metricsInverterId)+". Skipping remaining inverters\n";
-                                    metricsFieldId++; // Process next field Id
-                                    metricsStep = metricStateRealtimeFieldId;
-                                }
-                            } else {
-                                metrics = "# Info: No data for field #"+String(metricsFieldId)+ " (" + fields[metricsFieldId] +
-                                          ") of inverter #"+String(metricsInverterId)+". Skipping remaining inverters\n";
-                                metricsFieldId++; // Process next field Id
-                                metricsStep = metricStateRealtimeFieldId;
-                            }
-                            // Stay in this state and try next inverter
-                            metricsInverterId++;
-                        } else {
-                            metrics = "# Info: All inverters for field #"+String(metricsFieldId)+" processed.\n";
-                            metricsFieldId++; // Process next field Id
-                            metricsStep = metricStateRealtimeFieldId;
-                        }
-                        len = snprintf(reinterpret_cast<char *>(buffer), maxLen, "%s", metrics.c_str());
-                        break;
-
-                    case metricsStateAlarmData: // Alarm Info loop : fit to one packet
-                        // Perform grouping on metrics according to Prometheus exposition format specification
-                        snprintf(type, sizeof(type),"# TYPE %s%s gauge\n",metricConstPrefix,fields[FLD_LAST_ALARM_CODE]);
-                        metrics = type;
-
-                        for (metricsInverterId = 0; metricsInverterId < mSys->getNumInverters();metricsInverterId++) {
-                            iv = mSys->getInverterByPos(metricsInverterId);
-                            if (NULL != iv) {
-                                rec = iv->getRecordStruct(AlarmData);
-                                // simple hack : there is only one channel with alarm data
-                                // TODO: find the right one channel with the alarm id
-                                alarmChannelId = 0;
-                                if (alarmChannelId < rec->length) {
-                                    std::tie(promUnit, promType) = convertToPromUnits(iv->getUnit(alarmChannelId, rec));
-                                    snprintf(topic, sizeof(topic), "%s%s%s{inverter=\"%s\"}",metricConstPrefix, iv->getFieldName(alarmChannelId, rec), promUnit.c_str(), iv->config->name);
-                                    snprintf(val, sizeof(val), " %.3f\n", iv->getValue(alarmChannelId, rec));
-                                    metrics += topic;
-                                    metrics += val;
-                                }
-                            }
-                        }
-                        len = snprintf(reinterpret_cast<char*>(buffer), maxLen, "%s", metrics.c_str());
-                        metricsStep = metricsStateEnd;
-                        break;
-
-                    default: // end of transmission
-                        DBGPRINT("E: Prometheus: Bad metricsStep=");
-                        DBGPRINTLN(String(metricsStep));
-                    case metricsStateEnd:
-                        len = 0;
-                        break;
-                } // switch
+                                                                             [this](uint8_t *buffer, size_t maxLen, size_t filledLength) -> size_t {
+                mApp->lockComm();
+                size_t len = mMetrics.fill(buffer, maxLen);
+                mApp->unlockComm();
                 return len;
             });
             request->send(response);
         }
 
-
-        // Traverse all inverters and collect the metric via valueFunc
-        String inverterMetric(char *buffer, size_t len, const char *format, std::function<uint64_t(Inverter<> *iv)> valueFunc) {
-            String metric = "";
-            for (int id = 0; id < mSys->getNumInverters();id++) {
-                Inverter<> *iv = mSys->getInverterByPos(id);
-                if (NULL != iv) {
-                    snprintf(buffer,len,format,iv->config->name, valueFunc(iv));
-                    metric += String(buffer);
-                }
-            }
-            return metric;
-        }
-
-        std::pair<String, String> convertToPromUnits(String shortUnit) {
-            if(shortUnit == "A")    return {"_ampere", "gauge"};
-            if(shortUnit == "V")    return {"_volt", "gauge"};
-            if(shortUnit == "%")    return {"_ratio", "gauge"};
-            if(shortUnit == "W")    return {"_watt", "gauge"};
-            if(shortUnit == "Wh")   return {"_wattHours", "counter"};
-            if(shortUnit == "kWh")  return {"_kilowattHours", "counter"};
-            if(shortUnit == "°C")   return {"_celsius", "gauge"};
-            if(shortUnit == "var")  return {"_var", "gauge"};
-            if(shortUnit == "Hz")   return {"_hertz", "gauge"};
-            return {"", "gauge"};
-        }
-
     private:
-        int metricsInverterId = 0;
-        uint8_t metricsFieldId = 0;
-        bool metricDeclared = false, metricTotalDeclard = false;
+        Prometheus<HMSYSTEM> mMetrics;
 #endif
     private:
         AsyncWebServer mWeb;
         AsyncEventSource mEvts;
+        LiveDelta mLive;
         IApp *mApp = nullptr;
         HMSYSTEM *mSys = nullptr;
 